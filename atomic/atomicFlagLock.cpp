@@ -1,31 +1,28 @@
 /**
- * 使用atomic_flag生成一个自旋锁类
+ * 使用atomic_flag生成一个自旋锁类，实现见include/my_lock.hpp
  */
 
 #include <iostream>
-#include <atomic>
+#include <mutex>
 #include <thread>
+#include <vector>
 
-class MyLock {
-private:
-    std::atomic_flag atomicFlag;
-public:
-    MyLock();
+#include "my_lock.hpp"
 
-    void lock();
-
-    void unlock();
-};
-
-MyLock::MyLock() {
-    atomicFlag.clear();
+int main() {
+    zhaocc::MyLock my_lock;
+    int count = 0;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < 100000; j++) {
+                std::lock_guard<zhaocc::MyLock> lock(my_lock); // MyLock满足BasicLockable，可以配合lock_guard使用
+                count++;
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    std::cout << "count: " << count << std::endl;
 }
-
-void MyLock::lock() {
-    while (atomicFlag.test_and_set(std::memory_order_acquire)) // 如果flag为false，则代表当前没有人占用这个锁，则flag置为true。如果flag为true，则代表当前有人占用锁，则只能一直忙等
-        std::this_thread::yield();
-}
-
-void MyLock::unlock() {
-    atomicFlag.clear(std::memory_order_release); // 置为false
-}
\ No newline at end of file
@@ -1,25 +1,28 @@
 /**
- * 使用compare_exchange_weak实现支持并发stack的push动作
+ * 使用compare_exchange_weak实现支持并发stack的push动作，实现见include/lock_free_stack.hpp
  */
 
-#include <atomic>
+#include <iostream>
+#include <iterator>
+#include <thread>
+#include <vector>
 
-template<typename T>
-class lock_free_stack {
-private:
-    struct node {
-        T data;
-        node *next;
+#include "lock_free_stack.hpp"
 
-        node(T const &data_) :
-                data(data_) {}
-    };
-
-    std::atomic<node *> head;
-public:
-    void push(T const &data) {
-        node *const new_node = new node(data);
-        new_node->next = head.load();  //如果head更新了，这条语句要重来一遍
-        while (!head.compare_exchange_weak(new_node->next, new_node));
+int main() {
+    zhaocc::lock_free_stack<int> stack;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&stack, i]() {
+            for (int j = 0; j < 1000; j++) {
+                stack.push(i * 1000 + j);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
     }
-};
\ No newline at end of file
+    std::vector<int> values;
+    stack.pop_all(std::back_inserter(values));
+    std::cout << "popped " << values.size() << " values" << std::endl;
+}
@@ -0,0 +1,27 @@
+/**
+ * 自旋等待时每次循环调用的cpu_relax()，所有自旋循环（SeqLock、SpscQueue、同步原语、SerialExecutor）共用这一个实现。
+ * 只提示cpu当前在忙等：x86的pause降低功耗并避免退出循环时因内存序误判清空流水线，同一物理核上的另一个超线程可以多用一些资源；
+ * 不会像std::this_thread::yield()那样进入内核，自旋阶段本来就是为了不进入内核。
+ */
+
+#ifndef ATOMIC_CPU_RELAX_HPP
+#define ATOMIC_CPU_RELAX_HPP
+
+#include <atomic>
+
+namespace zhaocc {
+    /* 忙等时让出流水线资源 */
+    inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        __asm__ __volatile__("isb" ::: "memory"); // yield在多数ARM核心上什么也不做，isb的停顿时间更接近x86的pause
+#elif defined(__arm__)
+        __asm__ __volatile__("yield" ::: "memory");
+#else
+        std::atomic_signal_fence(std::memory_order_seq_cst); // 没有对应指令时只阻止编译器合并循环中的读取
+#endif
+    }
+}
+
+#endif //ATOMIC_CPU_RELAX_HPP
@@ -0,0 +1,73 @@
+/**
+ * 使用compare_exchange_weak实现支持并发stack的push动作。
+ * 出栈只提供pop_all：一次exchange把整条链表取下来，取下的节点只属于调用线程，不存在ABA和节点回收的问题，
+ * 适合生产者很多、消费者批量处理的场景。
+ */
+
+#ifndef ATOMIC_LOCK_FREE_STACK_HPP
+#define ATOMIC_LOCK_FREE_STACK_HPP
+
+#include <atomic>
+#include <cstddef>
+
+namespace zhaocc {
+    template<typename T>
+    class lock_free_stack {
+    private:
+        struct node {
+            T data;
+            node* next;
+
+            node(T const& data_) :
+                    data(data_) {}
+        };
+
+        std::atomic<node*> head{nullptr};
+
+    public:
+        lock_free_stack() = default;
+
+        lock_free_stack(const lock_free_stack&) = delete;
+
+        lock_free_stack& operator=(const lock_free_stack&) = delete;
+
+        ~lock_free_stack() {
+            for (node* n = head.load(); n != nullptr;) {
+                node* const next = n->next;
+                delete n;
+                n = next;
+            }
+        }
+
+        void push(T const& data) {
+            node* const new_node = new node(data);
+            new_node->next = head.load(std::memory_order_relaxed); //如果head更新了，这条语句要重来一遍
+            while (!head.compare_exchange_weak(new_node->next, new_node, std::memory_order_release,
+                                               std::memory_order_relaxed));
+        }
+
+        /**
+         * 取出栈中所有元素，按出栈顺序（后入栈的在前）写入out
+         * @return 取出的元素数量
+         */
+        template<typename OutputIt>
+        size_t pop_all(OutputIt out) {
+            node* n = head.exchange(nullptr, std::memory_order_acquire);
+            size_t count = 0;
+            while (n != nullptr) {
+                *out++ = n->data;
+                node* const next = n->next;
+                delete n;
+                n = next;
+                count++;
+            }
+            return count;
+        }
+
+        bool empty() const {
+            return head.load(std::memory_order_relaxed) == nullptr;
+        }
+    };
+}
+
+#endif //ATOMIC_LOCK_FREE_STACK_HPP
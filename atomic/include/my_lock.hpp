@@ -0,0 +1,31 @@
+/**
+ * 使用atomic_flag生成一个自旋锁类
+ */
+
+#ifndef ATOMIC_MY_LOCK_HPP
+#define ATOMIC_MY_LOCK_HPP
+
+#include <atomic>
+#include <thread>
+
+namespace zhaocc {
+    class MyLock {
+    private:
+        std::atomic_flag atomicFlag;
+    public:
+        MyLock() {
+            atomicFlag.clear();
+        }
+
+        void lock() {
+            while (atomicFlag.test_and_set(std::memory_order_acquire)) // 如果flag为false，则代表当前没有人占用这个锁，则flag置为true。如果flag为true，则代表当前有人占用锁，则只能一直忙等
+                std::this_thread::yield();
+        }
+
+        void unlock() {
+            atomicFlag.clear(std::memory_order_release); // 置为false
+        }
+    };
+}
+
+#endif //ATOMIC_MY_LOCK_HPP
@@ -0,0 +1,169 @@
+/**
+ * 顺序锁（seqlock），适用于频繁读取、很少写入的小块数据，例如时间戳、计数器、小结构体。
+ * 写线程在修改前后各把序号加一（修改期间序号为奇数），读线程读取前后序号不变且为偶数时说明读到的数据是完整的，否则重试。
+ * 读线程不写任何共享数据，多个读线程之间没有cache line争抢；数据以原子变量按字拷贝，避免数据竞争。
+ * T只需要可平凡拷贝，不要求有默认构造函数（只有SeqLock的默认构造用到T()）。
+ */
+
+#ifndef ATOMIC_SEQ_LOCK_HPP
+#define ATOMIC_SEQ_LOCK_HPP
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "cpu_relax.hpp"
+
+namespace zhaocc {
+    template<typename T>
+    class SeqLock {
+        static_assert(std::is_trivially_copyable<T>::value, "SeqLock only supports trivially copyable types");
+
+    private:
+        static constexpr size_t kWordCount = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+        alignas(64) std::atomic<uint64_t> seq; // 序号，为奇数时表示正在写
+        std::atomic<uint64_t> words[kWordCount]; // 数据按字保存
+
+        uint64_t lock_write(); // 将序号从偶数改为奇数，多个写线程之间互斥
+        void write_words(const T& value); // 持有写锁时写入数据
+        T read_words() const; // 持有写锁时读取数据
+        bool try_read_words(uint64_t (& buf)[kWordCount]) const; // 无锁读取一次，读取期间有写入时失败
+
+        /* 由字节构造T，不需要默认构造函数 */
+        static T from_words(const uint64_t (& buf)[kWordCount]) {
+            unsigned char bytes[sizeof(T)];
+            std::memcpy(bytes, buf, sizeof(T));
+            return std::bit_cast<T>(bytes);
+        }
+
+    public:
+        explicit SeqLock(const T& value = T());
+
+        // 不允许拷贝
+        SeqLock(const SeqLock&) = delete;
+
+        SeqLock& operator=(const SeqLock&) = delete;
+
+        /**
+         * 尝试读取一次
+         * @param value: 读取成功时赋值
+         * @return 是否读取成功，读取期间有写入时失败
+         */
+        bool try_load(T& value) const;
+
+        /**
+         * 读取，有写入冲突时一直重试
+         */
+        T load() const;
+
+        /**
+         * 写入
+         */
+        void store(const T& value);
+
+        /**
+         * 在写锁中读取-修改-写入，多个写线程之间不会丢失修改
+         * @param f: 可调用对象，参数为T&
+         */
+        template<typename F>
+        void update(F&& f);
+
+        /**
+         * 已经完成的写入次数
+         */
+        uint64_t version() const {
+            return seq.load(std::memory_order_acquire) >> 1;
+        }
+    };
+
+    template<typename T>
+    SeqLock<T>::SeqLock(const T& value) : seq(0) {
+        write_words(value);
+    }
+
+    template<typename T>
+    uint64_t SeqLock<T>::lock_write() {
+        uint64_t s = seq.load(std::memory_order_relaxed);
+        while ((s & 1) || !seq.compare_exchange_weak(s, s + 1, std::memory_order_acquire,
+                                                       std::memory_order_relaxed)) {
+            cpu_relax(); // 其他写线程正在写
+            s = seq.load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release); // 之后的数据写入不能重排到序号变为奇数之前
+        return s;
+    }
+
+    template<typename T>
+    void SeqLock<T>::write_words(const T& value) {
+        uint64_t buf[kWordCount] = {};
+        std::memcpy(buf, &value, sizeof(T));
+        for (size_t i = 0; i < kWordCount; i++) {
+            words[i].store(buf[i], std::memory_order_relaxed);
+        }
+    }
+
+    template<typename T>
+    T SeqLock<T>::read_words() const {
+        uint64_t buf[kWordCount];
+        for (size_t i = 0; i < kWordCount; i++) {
+            buf[i] = words[i].load(std::memory_order_relaxed);
+        }
+        return from_words(buf);
+    }
+
+    template<typename T>
+    bool SeqLock<T>::try_read_words(uint64_t (& buf)[kWordCount]) const {
+        uint64_t const s1 = seq.load(std::memory_order_acquire);
+        if (s1 & 1) { // 正在写
+            return false;
+        }
+
+        for (size_t i = 0; i < kWordCount; i++) {
+            buf[i] = words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire); // 和写线程的release屏障构成一对，之前的数据读取不能重排到第二次读序号之后
+
+        return seq.load(std::memory_order_relaxed) == s1; // 读取期间有写入时失败
+    }
+
+    template<typename T>
+    bool SeqLock<T>::try_load(T& value) const {
+        uint64_t buf[kWordCount];
+        if (!try_read_words(buf)) {
+            return false;
+        }
+        std::memcpy(&value, buf, sizeof(T));
+        return true;
+    }
+
+    template<typename T>
+    T SeqLock<T>::load() const {
+        uint64_t buf[kWordCount];
+        while (!try_read_words(buf)) {
+            cpu_relax();
+        }
+        return from_words(buf);
+    }
+
+    template<typename T>
+    void SeqLock<T>::store(const T& value) {
+        uint64_t const s = lock_write();
+        write_words(value);
+        seq.store(s + 2, std::memory_order_release); // 序号恢复为偶数，之前的数据写入不能重排到它之后
+    }
+
+    template<typename T>
+    template<typename F>
+    void SeqLock<T>::update(F&& f) {
+        uint64_t const s = lock_write();
+        T value = read_words();
+        f(value);
+        write_words(value);
+        seq.store(s + 2, std::memory_order_release);
+    }
+}
+
+#endif //ATOMIC_SEQ_LOCK_HPP
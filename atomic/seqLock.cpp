@@ -0,0 +1,165 @@
+/**
+ * 顺序锁的使用、压力测试，以及与boost::shared_mutex（sharedMutex.cpp中DnsCache的做法）的读取吞吐对比。
+ */
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <cassert>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/shared_lock_guard.hpp>
+
+#include "seq_lock.hpp"
+
+/* 被保护的小结构体，checksum由其他字段计算得到，读到不完整的数据时校验会失败 */
+struct Sample {
+    uint64_t version;
+    uint64_t sec;
+    uint64_t nsec;
+    uint64_t checksum;
+};
+
+static uint64_t calc_checksum(const Sample& s) {
+    return (s.version * 0x9E3779B97F4A7C15ULL) ^ (s.sec << 7) ^ (s.nsec * 31);
+}
+
+static Sample make_sample(uint64_t version) {
+    Sample s{version, version / 1000, version % 1000 * 1000000, 0};
+    s.checksum = calc_checksum(s);
+    return s;
+}
+
+/* 压力测试：多个写线程不断写入，多个读线程校验每次读到的数据都是完整的 */
+void torture_test(unsigned writer_count, unsigned reader_count, uint64_t writes_per_writer) {
+    zhaocc::SeqLock<Sample> lock(make_sample(0));
+    zhaocc::SeqLock<uint64_t> counter(0);
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> total_reads(0);
+
+    std::vector<std::thread> readers;
+    for (unsigned i = 0; i < reader_count; i++) {
+        readers.emplace_back([&]() {
+            uint64_t reads = 0;
+            uint64_t last_counter = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                Sample s = lock.load();
+                assert(s.checksum == calc_checksum(s)); // 不会读到写了一半的数据
+                uint64_t c = counter.load();
+                assert(c >= last_counter); // 同一个读线程看到的计数单调不减
+                last_counter = c;
+                reads++;
+            }
+            total_reads += reads;
+        });
+    }
+
+    std::vector<std::thread> writers;
+    for (unsigned i = 0; i < writer_count; i++) {
+        writers.emplace_back([&, i]() {
+            for (uint64_t n = 0; n < writes_per_writer; n++) {
+                lock.store(make_sample(i * writes_per_writer + n));
+                counter.update([](uint64_t& c) { c++; }); // 读-修改-写，多个写线程之间不会丢失修改
+            }
+        });
+    }
+
+    for (auto& th : writers) {
+        th.join();
+    }
+    stop = true;
+    for (auto& th : readers) {
+        th.join();
+    }
+
+    assert(counter.load() == writer_count * writes_per_writer);
+    assert(lock.version() == writer_count * writes_per_writer); // 构造时的初始值不算写入
+    std::cout << "torture test passed, writes: " << counter.load() << ", reads: " << total_reads << std::endl;
+}
+
+/* 使用共享锁保护的同样数据，作为对比 */
+class SharedMutexSample {
+private:
+    Sample sample;
+    mutable boost::shared_mutex m;
+public:
+    explicit SharedMutexSample(const Sample& s) : sample(s) {}
+
+    Sample load() const {
+        boost::shared_lock_guard<boost::shared_mutex> lock(m);
+        return sample;
+    }
+
+    void store(const Sample& s) {
+        std::lock_guard<boost::shared_mutex> lock(m);
+        sample = s;
+    }
+};
+
+/* 多个读线程持续读取，一个写线程每10us写一次，返回每秒读取次数 */
+template<typename LockType>
+double bench_reads(LockType& lock, unsigned reader_count, std::chrono::milliseconds duration) {
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> total_reads(0);
+
+    std::vector<std::thread> readers;
+    for (unsigned i = 0; i < reader_count; i++) {
+        readers.emplace_back([&]() {
+            uint64_t reads = 0;
+            uint64_t sum = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                sum += lock.load().sec;
+                reads++;
+            }
+            total_reads += reads + (sum == 0xFFFFFFFFFFFFFFFFULL); // 使用sum防止读取被优化掉
+        });
+    }
+
+    std::thread writer([&]() {
+        uint64_t version = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            lock.store(make_sample(version++));
+            std::this_thread::sleep_for(std::chrono::microseconds(10));
+        }
+    });
+
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto& th : readers) {
+        th.join();
+    }
+    writer.join();
+    return total_reads.load() * 1000.0 / duration.count();
+}
+
+/* 没有默认构造函数的可平凡拷贝类型也可以load和update */
+struct Position {
+    int x;
+    int y;
+
+    Position(int x_, int y_) : x(x_), y(y_) {}
+};
+
+void test_no_default_constructor() {
+    zhaocc::SeqLock<Position> pos(Position(1, 2));
+    pos.update([](Position& p) { p.x += 10; });
+    Position p = pos.load();
+    assert(p.x == 11 && p.y == 2);
+    pos.store(Position(3, 4));
+    assert(pos.try_load(p) && p.x == 3 && p.y == 4);
+}
+
+int main() {
+    test_no_default_constructor();
+    torture_test(2, 4, 200000);
+
+    unsigned const reader_count = std::max(2u, std::thread::hardware_concurrency());
+    zhaocc::SeqLock<Sample> seq_lock(make_sample(0));
+    SharedMutexSample shared_mutex_sample(make_sample(0));
+    std::cout << "shared_mutex reads/s: "
+              << bench_reads(shared_mutex_sample, reader_count, std::chrono::milliseconds(1000)) << std::endl;
+    std::cout << "seqlock reads/s: "
+              << bench_reads(seq_lock, reader_count, std::chrono::milliseconds(1000)) << std::endl;
+}
@@ -0,0 +1,153 @@
+/**
+ * 使用concurrent_cache实现一个带过期时间、内存预算、negative缓存以及请求合并的DnsCache。
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <cassert>
+
+#include "concurrent_cache.hpp"
+
+class DnsEntry {
+public:
+    int val;
+
+    DnsEntry() : val(0) {}
+
+    DnsEntry(int val_) : val(val_) {
+    }
+};
+
+using DnsCache = zhaocc::ConcurrentCache<std::string, DnsEntry>;
+
+/* 没有默认构造函数的value */
+struct Endpoint {
+    std::string address;
+
+    explicit Endpoint(std::string address_) : address(std::move(address_)) {}
+};
+
+static std::atomic<bool> fail_copy(false); // 为true时拷贝FlakyEndpoint抛出异常
+
+/* 拷贝可能抛出异常的value，用于检查写缓存失败时请求不会一直留在inflight中 */
+struct FlakyEndpoint {
+    std::string address;
+
+    explicit FlakyEndpoint(std::string address_) : address(std::move(address_)) {}
+
+    FlakyEndpoint(const FlakyEndpoint& other) : address(other.address) {
+        if (fail_copy) {
+            throw std::runtime_error("copy failed");
+        }
+    }
+
+    FlakyEndpoint(FlakyEndpoint&&) noexcept = default;
+};
+
+static std::atomic<int> upstream_calls(0); // 访问上游的次数
+
+/* 模拟一次很慢的上游解析，以"nx-"开头的域名不存在 */
+std::optional<DnsEntry> resolve_upstream(const std::string& host) {
+    upstream_calls++;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (host.compare(0, 3, "nx-") == 0) {
+        return std::nullopt;
+    }
+    return DnsEntry(static_cast<int>(host.size()));
+}
+
+int main() {
+    using namespace std::chrono_literals;
+
+    /* 过期时间 */
+    DnsCache dns_cache(1 << 20, 200ms, 100ms);
+    dns_cache.put("123", DnsEntry(10));
+    DnsEntry entry;
+    assert(dns_cache.lookup("123", entry) == DnsCache::HIT && entry.val == 10);
+    dns_cache.put("456", DnsEntry(20), 10ms); // 单独指定过期时间
+    std::this_thread::sleep_for(20ms);
+    assert(dns_cache.lookup("456", entry) == DnsCache::MISS); // 已过期
+    assert(dns_cache.lookup("123", entry) == DnsCache::HIT);
+    std::cout << "ttl ok" << std::endl;
+
+    /* 请求合并：8个线程同时查询同一个未缓存的域名，只会访问一次上游 */
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; i++) {
+        threads.emplace_back([&]() {
+            std::optional<DnsEntry> res = dns_cache.get_or_fetch("www.example.com", [] {
+                return resolve_upstream("www.example.com");
+            });
+            assert(res && res->val == 15);
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    std::cout << "upstream calls for 8 concurrent misses: " << upstream_calls << std::endl;
+    assert(upstream_calls == 1);
+
+    /* negative缓存：不存在的域名在negative_ttl内不会再次访问上游 */
+    upstream_calls = 0;
+    for (int i = 0; i < 5; i++) {
+        auto res = dns_cache.get_or_fetch("nx-host", [] { return resolve_upstream("nx-host"); });
+        assert(!res);
+    }
+    assert(dns_cache.lookup("nx-host", entry) == DnsCache::NEGATIVE_HIT);
+    std::cout << "upstream calls for 5 lookups of a missing host: " << upstream_calls << std::endl;
+    assert(upstream_calls == 1);
+
+    /* 内存预算：每个元素按1计算，容量为100，不断写入时总量不会超过预算 */
+    DnsCache small_cache(100, 10s, 1s, 4, [](const std::string&, const DnsEntry&) { return 1; });
+    for (int i = 0; i < 1000; i++) {
+        small_cache.put("host-" + std::to_string(i), DnsEntry(i));
+        small_cache.lookup("host-0", entry); // 经常访问的元素会被保留
+    }
+    std::cout << "small cache size: " << small_cache.size() << std::endl;
+    assert(small_cache.size() <= 100);
+    assert(small_cache.lookup("host-0", entry) == DnsCache::HIT);
+
+    /* get_or_fetch不要求value可以默认构造 */
+    zhaocc::ConcurrentCache<std::string, Endpoint> endpoints(1 << 10, 10s, 1s);
+    for (int i = 0; i < 2; i++) { // 第二次命中缓存
+        std::optional<Endpoint> ep = endpoints.get_or_fetch("db", [] { return Endpoint("10.0.0.1:3306"); });
+        assert(ep && ep->address == "10.0.0.1:3306");
+    }
+
+    /* 获取成功但写缓存时拷贝value抛出异常：调用者和等待的线程都得到这个异常，之后的查询可以重新获取 */
+    zhaocc::ConcurrentCache<std::string, FlakyEndpoint> flaky(1 << 10, 10s, 1s);
+    fail_copy = true;
+    std::atomic<int> copy_failures(0);
+    std::vector<std::thread> flaky_threads;
+    for (int i = 0; i < 4; i++) {
+        flaky_threads.emplace_back([&]() {
+            try {
+                flaky.get_or_fetch("db", [] {
+                    std::this_thread::sleep_for(50ms); // 让其他线程等待这次获取的结果
+                    return FlakyEndpoint("10.0.0.2:3306");
+                });
+            } catch (const std::runtime_error&) { // 不是std::future_error(broken_promise)
+                copy_failures++;
+            }
+        });
+    }
+    for (auto& th : flaky_threads) {
+        th.join();
+    }
+    assert(copy_failures == 4);
+    fail_copy = false;
+    std::optional<FlakyEndpoint> recovered = flaky.get_or_fetch("db", [] { return FlakyEndpoint("10.0.0.2:3306"); });
+    assert(recovered && recovered->address == "10.0.0.2:3306");
+    std::cout << "get_or_fetch recovers after a failed cache insert" << std::endl;
+
+    std::this_thread::sleep_for(300ms);
+    dns_cache.purge_expired();
+    std::cout << "cache size after purge: " << dns_cache.size() << std::endl;
+    assert(dns_cache.size() == 0);
+}
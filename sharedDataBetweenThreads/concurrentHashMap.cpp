@@ -0,0 +1,144 @@
+/**
+ * 使用分段锁 + 无锁读的并发哈希表实现DnsCache，并与sharedMutex.cpp中std::map + boost::shared_mutex的实现对比查询吞吐。
+ * 共享锁在每次读取时都要修改同一个读者计数，多个读线程之间会争抢这个cache line；并发哈希表的读操作不写任何共享数据。
+ */
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cassert>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/shared_lock_guard.hpp>
+
+#include "concurrent_hash_map.hpp"
+
+class DnsEntry {
+public:
+    int val;
+
+    DnsEntry() : val(0) {}
+
+    DnsEntry(int val_) : val(val_) {
+    }
+};
+
+/* sharedMutex.cpp中的实现，作为对比 */
+class SharedMutexDnsCache {
+private:
+    std::map<std::string, DnsEntry> entries_map;
+    boost::shared_mutex entry_mutex;
+
+public:
+    DnsEntry find_entry(const std::string& str) {
+        boost::shared_lock_guard<boost::shared_mutex> lock(entry_mutex);
+        auto const it = entries_map.find(str);
+        return it == entries_map.end() ? DnsEntry() : it->second;
+    }
+
+    void update_or_add_entry(const std::string& str, const DnsEntry& entry) {
+        std::lock_guard<boost::shared_mutex> lock(entry_mutex);
+        entries_map[str] = entry;
+    }
+};
+
+/* 基于并发哈希表的实现，查询可以直接传入string_view */
+class DnsCache {
+private:
+    zhaocc::ConcurrentHashMap<std::string, DnsEntry> entries_map;
+
+public:
+    DnsEntry find_entry(std::string_view str) const {
+        DnsEntry entry;
+        entries_map.find(str, entry);
+        return entry;
+    }
+
+    void update_or_add_entry(const std::string& str, const DnsEntry& entry) {
+        entries_map.insert_or_assign(str, entry);
+    }
+};
+
+/* 多个读线程持续查询，一个写线程持续更新，返回每秒查询次数 */
+template<typename CacheType>
+double bench_lookups(CacheType& cache, std::vector<std::string> const& keys, unsigned reader_count,
+                     std::chrono::milliseconds duration) {
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> lookups(0);
+
+    std::vector<std::thread> readers;
+    for (unsigned r = 0; r < reader_count; r++) {
+        readers.emplace_back([&, r]() {
+            uint64_t local = 0;
+            size_t i = r;
+            while (!stop.load(std::memory_order_relaxed)) {
+                DnsEntry entry = cache.find_entry(keys[i % keys.size()]);
+                assert(entry.val >= 0);
+                i += 7;
+                local++;
+            }
+            lookups.fetch_add(local);
+        });
+    }
+
+    std::thread writer([&]() {
+        int v = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            cache.update_or_add_entry(keys[v % keys.size()], DnsEntry(v));
+            v++;
+            std::this_thread::sleep_for(std::chrono::microseconds(10));
+        }
+    });
+
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto& th : readers) {
+        th.join();
+    }
+    writer.join();
+    return lookups.load() * 1000.0 / duration.count();
+}
+
+int main() {
+    DnsCache dns_cache;
+    dns_cache.update_or_add_entry("123", DnsEntry(10));
+    std::cout << dns_cache.find_entry("123").val << std::endl;
+    dns_cache.update_or_add_entry("456", DnsEntry(20));
+    std::cout << dns_cache.find_entry(std::string_view("456")).val << std::endl;
+    dns_cache.update_or_add_entry("456", DnsEntry(30)); // 更新已有的key
+    std::cout << dns_cache.find_entry("456").val << std::endl;
+
+    // 插入足够多的元素触发渐进式扩容，期间所有数据都可以被查到
+    zhaocc::ConcurrentHashMap<std::string, int> map;
+    for (int i = 0; i < 100000; i++) {
+        map.insert_or_assign(std::to_string(i), i);
+        int val = -1;
+        assert(map.find(std::to_string(i / 2), val) && val == i / 2);
+    }
+    for (int i = 0; i < 100000; i += 2) {
+        assert(map.erase(std::to_string(i)));
+    }
+    assert(map.size() == 50000);
+    std::cout << "map size: " << map.size() << std::endl;
+
+    std::vector<std::string> keys;
+    for (int i = 0; i < 10000; i++) {
+        keys.emplace_back("host-" + std::to_string(i) + ".example.com");
+    }
+    SharedMutexDnsCache shared_mutex_cache;
+    for (auto const& key : keys) {
+        shared_mutex_cache.update_or_add_entry(key, DnsEntry(1));
+        dns_cache.update_or_add_entry(key, DnsEntry(1));
+    }
+
+    unsigned const reader_count = std::max(2u, std::thread::hardware_concurrency());
+    std::cout << "shared_mutex lookups/s: "
+              << bench_lookups(shared_mutex_cache, keys, reader_count, std::chrono::milliseconds(1000)) << std::endl;
+    std::cout << "concurrent hash map lookups/s: "
+              << bench_lookups(dns_cache, keys, reader_count, std::chrono::milliseconds(1000)) << std::endl;
+}
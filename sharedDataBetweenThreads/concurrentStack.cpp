@@ -0,0 +1,119 @@
+/**
+ * 测试include/concurrent_stack.hpp中互斥元与无锁两种ConcurrentStack：只能移动的类型、出栈顺序、节点池扩容，
+ * 以及多个线程回收4KB缓冲区（对象池）时与ThreadSafeStack的吞吐对比。ThreadSafeStack每次push/pop都要拷贝缓冲区，
+ * 栈为空时只能通过EmptyStack异常得知。
+ */
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <iterator>
+#include <cassert>
+
+#include "concurrent_stack.hpp"
+#include "thread_safe_stack.hpp"
+
+template<bool LockFree>
+void test_basic() {
+    zhaocc::ConcurrentStack<std::unique_ptr<int>, LockFree> stack;
+    std::unique_ptr<int> value;
+    assert(stack.empty() && !stack.try_pop(value));
+    stack.push(std::make_unique<int>(1));
+    stack.emplace(new int(2));
+    stack.push(std::make_unique<int>(3));
+    assert(stack.try_pop(value) && *value == 3);
+
+    std::vector<std::unique_ptr<int>> all;
+    assert(stack.pop_all(std::back_inserter(all)) == 2);
+    assert(*all[0] == 2 && *all[1] == 1 && stack.empty());
+}
+
+/* 元素数量跨越多个节点块，弹出的节点被复用 */
+template<bool LockFree>
+void test_many() {
+    zhaocc::ConcurrentStack<int, LockFree> stack;
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 100000; i++) {
+            stack.push(i);
+        }
+        int value;
+        assert(stack.try_pop(value) && value == 99999);
+        std::vector<int> all;
+        assert(stack.pop_all(std::back_inserter(all)) == 99999);
+        assert(all.front() == 99998 && all.back() == 0);
+    }
+    for (int i = 0; i < 10; i++) { // 析构时销毁剩余元素
+        stack.push(i);
+    }
+}
+
+using Buffer = std::vector<char>;
+constexpr size_t kBufferSize = 4096;
+constexpr int kRecycleThreads = 4;
+constexpr int kRecycleRounds = 50000;
+
+/* 每个线程取出一个缓冲区（没有时新建），写满自己的标记再放回，返回每秒回收次数 */
+template<typename Acquire, typename Release>
+double recycle(Acquire acquire, Release release, std::atomic<int>& created) {
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kRecycleThreads; t++) {
+        threads.emplace_back([&, t]() {
+            Buffer buffer;
+            for (int i = 0; i < kRecycleRounds; i++) {
+                if (!acquire(buffer)) {
+                    buffer.assign(kBufferSize, 0);
+                    created++;
+                }
+                assert(buffer.size() == kBufferSize && buffer.front() == buffer.back()); // 整块属于上一个使用者
+                buffer.front() = buffer.back() = static_cast<char>(t);
+                release(std::move(buffer));
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    std::chrono::duration<double> cost = std::chrono::steady_clock::now() - begin;
+    return kRecycleThreads * kRecycleRounds / cost.count();
+}
+
+template<bool LockFree>
+double recycle_concurrent_stack() {
+    zhaocc::ConcurrentStack<Buffer, LockFree> pool;
+    std::atomic<int> created(0);
+    double const rate = recycle([&pool](Buffer& b) { return pool.try_pop(b); },
+                                [&pool](Buffer&& b) { pool.push(std::move(b)); }, created);
+    std::vector<Buffer> left;
+    assert(pool.pop_all(std::back_inserter(left)) == static_cast<size_t>(created.load()));
+    assert(created <= kRecycleThreads); // 每个线程同时最多持有一个缓冲区
+    return rate;
+}
+
+double recycle_thread_safe_stack() {
+    zhaocc::ThreadSafeStack<Buffer> pool;
+    std::atomic<int> created(0);
+    return recycle([&pool](Buffer& b) {
+        try {
+            pool.pop(b); // 拷贝
+            return true;
+        } catch (const zhaocc::EmptyStack&) {
+            return false;
+        }
+    }, [&pool](Buffer&& b) { pool.push(b); }, created); // 拷贝
+}
+
+int main() {
+    test_basic<false>();
+    test_basic<true>();
+    test_many<false>();
+    test_many<true>();
+    double const old_rate = recycle_thread_safe_stack();
+    double const mutex_rate = recycle_concurrent_stack<false>();
+    double const lock_free_rate = recycle_concurrent_stack<true>();
+    std::cout << "recycle 4KB buffers: ThreadSafeStack " << old_rate << "/s, ConcurrentStack " << mutex_rate
+              << "/s, lock-free ConcurrentStack " << lock_free_rate << "/s" << std::endl;
+}
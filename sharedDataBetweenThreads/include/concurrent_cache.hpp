@@ -0,0 +1,361 @@
+/**
+ * 基于concurrent_hash_map实现的并发缓存，支持：
+ * 1. 每个元素单独的过期时间（TTL）。
+ * 2. 在内存预算下使用CLOCK算法近似LRU淘汰。
+ * 3. 缓存“查询结果不存在”（negative caching），防止不存在的key反复穿透到上游。
+ * 4. 请求合并，同一个key同时有多个线程未命中时只有一个线程去上游获取，其他线程等待它的结果。
+ * 读路径不加锁，命中时只在访问位尚未置位时写一次；淘汰相关的簿记按分片加锁，不存在全局链表。
+ */
+
+#ifndef SHAREDDATABETWEENTHREADS_CONCURRENT_CACHE_HPP
+#define SHAREDDATABETWEENTHREADS_CONCURRENT_CACHE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "concurrent_hash_map.hpp"
+
+namespace zhaocc {
+    template<typename Key, typename Value, typename Hash = TransparentHash<Key>>
+    class ConcurrentCache {
+    public:
+        using Clock = std::chrono::steady_clock;
+        using ChargeFunc = std::function<size_t(const Key&, const Value&)>; // 计算一个元素占用的内存
+
+        /* 查询结果 */
+        enum LookupStatus {
+            MISS, // 未命中或者已过期
+            HIT, // 命中
+            NEGATIVE_HIT // 命中“不存在”的缓存
+        };
+
+    private:
+        struct Entry {
+            std::optional<Value> value; // 为空表示negative缓存
+            Clock::time_point expire_at; // 过期时间点
+            mutable std::atomic<bool> referenced; // CLOCK算法的访问位，读线程命中时置位
+
+            Entry(std::optional<Value> value_, Clock::time_point expire_at_) : value(std::move(value_)),
+                                                                              expire_at(expire_at_),
+                                                                              referenced(false) {}
+
+            // 哈希表扩容时需要拷贝节点
+            Entry(const Entry& other) : value(other.value), expire_at(other.expire_at),
+                                        referenced(other.referenced.load(std::memory_order_relaxed)) {}
+        };
+
+        /* CLOCK环中的一个位置 */
+        struct Slot {
+            Key key;
+            size_t charge; // 该元素占用的内存
+        };
+
+        /* 分片，保护该分片内的CLOCK环和正在获取中的请求 */
+        struct alignas(64) Shard {
+            std::mutex m;
+            std::vector<Slot> ring; // CLOCK环
+            std::unordered_map<Key, size_t, Hash> positions; // key在环中的位置
+            size_t hand = 0; // CLOCK指针
+            size_t used = 0; // 已使用的内存
+            std::unordered_map<Key, std::shared_future<std::optional<Value>>, Hash> inflight; // 正在上游获取的请求
+        };
+
+        ConcurrentHashMap<Key, Entry, Hash> map; // 实际保存数据
+        size_t const shard_mask;
+        size_t const shard_capacity; // 每个分片的内存预算
+        std::unique_ptr<Shard[]> shards;
+        Clock::duration const ttl; // 默认过期时间
+        Clock::duration const negative_ttl; // negative缓存的过期时间
+        ChargeFunc charge_func;
+        Hash hasher;
+
+        static size_t round_up_pow2(size_t n) {
+            size_t res = 1;
+            while (res < n) {
+                res <<= 1;
+            }
+            return res;
+        }
+
+        Shard& shard_of(size_t hash) {
+            return shards[(hash >> 16) & shard_mask]; // 低位已经被哈希表的分段锁使用，这里取高一些的位
+        }
+
+        void insert_locked(Shard& shard, const Key& key, std::optional<Value> value, Clock::duration entry_ttl);
+        template<typename K, typename F>
+        LookupStatus lookup_with(const K& key, F&& on_hit) const; // 命中时以const Value&调用on_hit
+        void evict_locked(Shard& shard); // 持有分片锁时淘汰元素直到不超过预算
+        void remove_slot_locked(Shard& shard, size_t pos); // 从环中移除一个位置
+
+    public:
+        /**
+         * 构造函数
+         * @param capacity: 内存预算，单位与charge返回值一致
+         * @param ttl: 默认的过期时间
+         * @param negative_ttl: negative缓存的过期时间
+         * @param shard_count: 分片数量，会向上取整为2的幂
+         * @param charge: 计算元素占用的内存，为空时按照sizeof(Key) + sizeof(Value)估算
+         */
+        ConcurrentCache(size_t capacity, Clock::duration ttl, Clock::duration negative_ttl, size_t shard_count = 16,
+                        ChargeFunc charge = nullptr);
+
+        /**
+         * 查询
+         * @param key: 可以是Key或者能与Key比较的类型
+         * @param value: 命中时赋值
+         * @return 查询结果
+         */
+        template<typename K>
+        LookupStatus lookup(const K& key, Value& value) const;
+
+        /**
+         * 写入缓存
+         * @param entry_ttl: 过期时间，默认使用构造时指定的ttl
+         */
+        void put(const Key& key, Value value, Clock::duration entry_ttl = Clock::duration::zero());
+
+        /**
+         * 缓存“不存在”的结果
+         */
+        void put_negative(const Key& key, Clock::duration entry_ttl = Clock::duration::zero());
+
+        /**
+         * 删除缓存
+         */
+        void erase(const Key& key);
+
+        /**
+         * 查询，未命中时调用fetcher从上游获取并写入缓存，同一个key同时只会有一个fetcher在执行
+         * @param fetcher: 可调用对象，返回std::optional<Value>，为空表示上游不存在该key，会被negative缓存
+         * @return 获取到的值，为空表示不存在。fetcher或者写缓存（例如拷贝Value）抛出的异常会传递给所有等待的线程，并且不会被缓存
+         */
+        template<typename F>
+        std::optional<Value> get_or_fetch(const Key& key, F&& fetcher);
+
+        /**
+         * 扫描所有分片，清理已经过期的元素
+         */
+        void purge_expired();
+
+        size_t size() const {
+            return map.size();
+        }
+    };
+
+    template<typename Key, typename Value, typename Hash>
+    ConcurrentCache<Key, Value, Hash>::ConcurrentCache(size_t capacity, Clock::duration ttl_,
+                                                       Clock::duration negative_ttl_, size_t shard_count,
+                                                       ChargeFunc charge)
+            : shard_mask(round_up_pow2(shard_count) - 1),
+              shard_capacity(std::max<size_t>(capacity / (shard_mask + 1), 1)),
+              shards(new Shard[shard_mask + 1]), ttl(ttl_), negative_ttl(negative_ttl_), charge_func(std::move(charge)) {
+        if (!charge_func) {
+            charge_func = [](const Key&, const Value&) { return sizeof(Key) + sizeof(Value); };
+        }
+    }
+
+    template<typename Key, typename Value, typename Hash>
+    template<typename K>
+    typename ConcurrentCache<Key, Value, Hash>::LookupStatus
+    ConcurrentCache<Key, Value, Hash>::lookup(const K& key, Value& value) const {
+        return lookup_with(key, [&value](const Value& v) { value = v; });
+    }
+
+    template<typename Key, typename Value, typename Hash>
+    template<typename K, typename F>
+    typename ConcurrentCache<Key, Value, Hash>::LookupStatus
+    ConcurrentCache<Key, Value, Hash>::lookup_with(const K& key, F&& on_hit) const {
+        LookupStatus status = MISS;
+        Clock::time_point const now = Clock::now();
+        map.visit(key, [&](const Entry& entry) {
+            if (entry.expire_at <= now) { // 已过期的元素等待淘汰时清理
+                return;
+            }
+            if (!entry.referenced.load(std::memory_order_relaxed)) { // 已经置位时不再写，避免多个读线程争抢cache line
+                entry.referenced.store(true, std::memory_order_relaxed);
+            }
+            if (entry.value) {
+                on_hit(*entry.value);
+                status = HIT;
+            } else {
+                status = NEGATIVE_HIT;
+            }
+        });
+        return status;
+    }
+
+    template<typename Key, typename Value, typename Hash>
+    void ConcurrentCache<Key, Value, Hash>::insert_locked(Shard& shard, const Key& key, std::optional<Value> value,
+                                                          Clock::duration entry_ttl) {
+        size_t const charge = value ? charge_func(key, *value) : sizeof(Key);
+        map.insert_or_assign(key, Entry(std::move(value), Clock::now() + entry_ttl));
+
+        auto it = shard.positions.find(key);
+        if (it != shard.positions.end()) { // 已在环中则只更新占用的内存
+            Slot& slot = shard.ring[it->second];
+            shard.used = shard.used - slot.charge + charge;
+            slot.charge = charge;
+        } else {
+            shard.positions.emplace(key, shard.ring.size());
+            shard.ring.push_back({key, charge});
+            shard.used += charge;
+        }
+        evict_locked(shard);
+    }
+
+    template<typename Key, typename Value, typename Hash>
+    void ConcurrentCache<Key, Value, Hash>::remove_slot_locked(Shard& shard, size_t pos) {
+        shard.used -= shard.ring[pos].charge;
+        shard.positions.erase(shard.ring[pos].key);
+        if (pos != shard.ring.size() - 1) { // 用最后一个位置填补空位
+            shard.ring[pos] = std::move(shard.ring.back());
+            shard.positions[shard.ring[pos].key] = pos;
+        }
+        shard.ring.pop_back();
+    }
+
+    template<typename Key, typename Value, typename Hash>
+    void ConcurrentCache<Key, Value, Hash>::evict_locked(Shard& shard) {
+        Clock::time_point const now = Clock::now();
+
+        // 最多转两圈：第一圈清除所有访问位，第二圈一定能淘汰掉元素
+        size_t budget = shard.ring.size() * 2;
+        while (shard.used > shard_capacity && !shard.ring.empty() && budget-- > 0) {
+            if (shard.hand >= shard.ring.size()) {
+                shard.hand = 0;
+            }
+            Slot& slot = shard.ring[shard.hand];
+
+            bool evict = true;
+            map.visit(slot.key, [&](const Entry& entry) {
+                if (entry.expire_at > now && entry.referenced.load(std::memory_order_relaxed)) { // 最近被访问过，给第二次机会
+                    entry.referenced.store(false, std::memory_order_relaxed);
+                    evict = false;
+                }
+            });
+
+            if (evict) {
+                map.erase(slot.key);
+                remove_slot_locked(shard, shard.hand);
+            }
+            shard.hand++; // 淘汰时最新的元素被换到了hand位置，跳过它使其至少经历一圈才会被检查
+        }
+    }
+
+    template<typename Key, typename Value, typename Hash>
+    void ConcurrentCache<Key, Value, Hash>::put(const Key& key, Value value, Clock::duration entry_ttl) {
+        Shard& shard = shard_of(hasher(key));
+        std::lock_guard<std::mutex> lock(shard.m);
+        insert_locked(shard, key, std::move(value), entry_ttl == Clock::duration::zero() ? ttl : entry_ttl);
+    }
+
+    template<typename Key, typename Value, typename Hash>
+    void ConcurrentCache<Key, Value, Hash>::put_negative(const Key& key, Clock::duration entry_ttl) {
+        Shard& shard = shard_of(hasher(key));
+        std::lock_guard<std::mutex> lock(shard.m);
+        insert_locked(shard, key, std::nullopt, entry_ttl == Clock::duration::zero() ? negative_ttl : entry_ttl);
+    }
+
+    template<typename Key, typename Value, typename Hash>
+    void ConcurrentCache<Key, Value, Hash>::erase(const Key& key) {
+        Shard& shard = shard_of(hasher(key));
+        std::lock_guard<std::mutex> lock(shard.m);
+        auto it = shard.positions.find(key);
+        if (it != shard.positions.end()) {
+            map.erase(key);
+            remove_slot_locked(shard, it->second);
+        }
+    }
+
+    template<typename Key, typename Value, typename Hash>
+    template<typename F>
+    std::optional<Value> ConcurrentCache<Key, Value, Hash>::get_or_fetch(const Key& key, F&& fetcher) {
+        std::optional<Value> value; // Value不需要默认构造
+        auto const on_hit = [&value](const Value& v) { value.emplace(v); };
+        switch (lookup_with(key, on_hit)) {
+            case HIT:
+                return value;
+            case NEGATIVE_HIT:
+                return std::nullopt;
+            default:
+                break;
+        }
+
+        Shard& shard = shard_of(hasher(key));
+        std::promise<std::optional<Value>> promise;
+        {
+            std::unique_lock<std::mutex> lock(shard.m);
+            auto it = shard.inflight.find(key);
+            if (it != shard.inflight.end()) { // 已有线程在获取，等待它的结果
+                std::shared_future<std::optional<Value>> future = it->second;
+                lock.unlock();
+                return future.get();
+            }
+
+            // 在加锁前可能刚好有线程写入了结果
+            switch (lookup_with(key, on_hit)) {
+                case HIT:
+                    return value;
+                case NEGATIVE_HIT:
+                    return std::nullopt;
+                default:
+                    break;
+            }
+            shard.inflight.emplace(key, promise.get_future().share());
+        }
+
+        // 无论获取、写缓存是否成功都要移除请求，否则之后查询这个key的线程都会得到broken_promise
+        struct InflightGuard {
+            Shard& shard;
+            const Key& key;
+
+            ~InflightGuard() {
+                std::lock_guard<std::mutex> lock(shard.m);
+                shard.inflight.erase(key);
+            }
+        };
+
+        InflightGuard const guard{shard, key};
+        try {
+            std::optional<Value> result = fetcher();
+            {
+                std::lock_guard<std::mutex> lock(shard.m);
+                insert_locked(shard, key, result, result ? ttl : negative_ttl); // 先写缓存再移除请求，之后的线程直接命中
+            }
+            promise.set_value(result);
+            return result;
+        } catch (...) {
+            promise.set_exception(std::current_exception()); // 等待的线程得到同样的异常
+            throw;
+        }
+    }
+
+    template<typename Key, typename Value, typename Hash>
+    void ConcurrentCache<Key, Value, Hash>::purge_expired() {
+        Clock::time_point const now = Clock::now();
+        for (size_t i = 0; i <= shard_mask; i++) {
+            Shard& shard = shards[i];
+            std::lock_guard<std::mutex> lock(shard.m);
+            for (size_t pos = 0; pos < shard.ring.size();) {
+                bool expired = true;
+                map.visit(shard.ring[pos].key, [&](const Entry& entry) { expired = entry.expire_at <= now; });
+                if (expired) {
+                    map.erase(shard.ring[pos].key);
+                    remove_slot_locked(shard, pos); // 最后一个元素被换到pos，需要再次检查
+                } else {
+                    pos++;
+                }
+            }
+        }
+    }
+}
+
+#endif //SHAREDDATABETWEENTHREADS_CONCURRENT_CACHE_HPP
@@ -0,0 +1,389 @@
+/**
+ * 分段锁（lock striping）实现的并发哈希表。
+ * 读操作不加锁：在epoch临界区中沿着只读节点组成的链表查找，节点被替换或删除后延迟到宽限期之后再释放；
+ * 写操作只锁定key所在的分段锁；元素过多时渐进式扩容，每次写操作顺带迁移几个桶，不会出现所有读写都被阻塞的情况。
+ * 对std::string类型的key支持直接使用std::string_view查找，不需要构造临时string。
+ */
+
+#ifndef SHAREDDATABETWEENTHREADS_CONCURRENT_HASH_MAP_HPP
+#define SHAREDDATABETWEENTHREADS_CONCURRENT_HASH_MAP_HPP
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <utility>
+
+#include "epoch_reclaimer.hpp"
+
+namespace zhaocc {
+    /* 默认哈希函数 */
+    template<typename Key>
+    struct TransparentHash : std::hash<Key> {
+    };
+
+    /* std::string的透明哈希，std::hash<std::string>与std::hash<std::string_view>对相同字符序列的结果相同 */
+    template<>
+    struct TransparentHash<std::string> {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view str) const noexcept {
+            return std::hash<std::string_view>()(str);
+        }
+    };
+
+    template<typename Key, typename Value, typename Hash = TransparentHash<Key>, typename KeyEqual = std::equal_to<>>
+    class ConcurrentHashMap {
+    private:
+        /* 节点发布后key和value不再改变，更新value时用新节点替换旧节点 */
+        struct Node {
+            const Key key;
+            const Value value;
+            const size_t hash;
+            std::atomic<Node*> next;
+
+            template<typename K, typename V>
+            Node(K&& key_, V&& value_, size_t hash_, Node* next_) : key(std::forward<K>(key_)),
+                                                                   value(std::forward<V>(value_)),
+                                                                   hash(hash_), next(next_) {}
+        };
+
+        struct Bucket {
+            std::atomic<Node*> head{nullptr}; // 链表头
+            std::atomic<bool> migrated{false}; // 扩容时该桶是否已经迁移到新表
+        };
+
+        struct Table {
+            const size_t mask; // 桶数量减一，桶数量总是2的幂
+            std::unique_ptr<Bucket[]> buckets;
+            std::atomic<Table*> next{nullptr}; // 正在扩容时指向新表
+            std::atomic<size_t> migrate_cursor{0}; // 下一个待迁移的桶
+            std::atomic<size_t> migrated_count{0}; // 已经迁移完成的桶数量
+
+            explicit Table(size_t bucket_count) : mask(bucket_count - 1), buckets(new Bucket[bucket_count]) {}
+
+            Bucket& bucket(size_t hash) {
+                return buckets[hash & mask];
+            }
+
+            size_t bucket_count() const {
+                return mask + 1;
+            }
+        };
+
+        /* 分段锁，每个锁独占一个cache line */
+        struct alignas(64) Stripe {
+            std::mutex m;
+        };
+
+        // 分段数量不大于桶数量，并且都是2的幂，所以同一个key在新旧表中的桶总是对应同一把分段锁
+        static constexpr size_t kStripeCount = 64;
+        static constexpr size_t kMaxLoadFactor = 2; // 平均每个桶的元素超过该值时扩容
+        static constexpr size_t kMigrateBatch = 4; // 每次写操作顺带迁移的桶数量
+
+        std::atomic<Table*> table; // 当前表
+        std::unique_ptr<Stripe[]> stripes; // 分段锁
+        std::atomic<size_t> count; // 元素数量
+        std::mutex resize_mutex; // 保护新表的创建
+        Hash hasher;
+        KeyEqual key_equal;
+
+        std::mutex& stripe_of(size_t hash) {
+            return stripes[hash & (kStripeCount - 1)].m;
+        }
+
+        template<typename K>
+        Node* find_node(const K& key, size_t hash) const; // 无锁查找，必须在epoch临界区中调用
+        Table* locked_table(size_t hash); // 持有分段锁时找到key实际所在的表
+        template<typename K>
+        std::atomic<Node*>* find_link(Bucket& bucket, const K& key, size_t hash); // 持有分段锁时找到指向目标节点的指针
+        void maybe_grow(size_t new_count); // 元素过多时创建新表开始扩容
+        void help_migrate(); // 迁移若干个桶，全部迁移完成后切换到新表
+        void migrate_bucket(Table* from, Table* to, size_t index); // 持有分段锁时迁移一个桶
+        static void free_chain(Node* node);
+
+    public:
+        /**
+         * 构造函数
+         * @param bucket_count: 初始桶数量，会向上取整为2的幂
+         */
+        explicit ConcurrentHashMap(size_t bucket_count = kStripeCount);
+
+        ~ConcurrentHashMap();
+
+        // 不允许拷贝
+        ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+
+        ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+        /**
+         * 查找并拷贝value
+         * @param key: 可以是Key或者能与Key比较的类型，例如std::string_view
+         * @param value: 找到时赋值
+         * @return 是否找到
+         */
+        template<typename K>
+        bool find(const K& key, Value& value) const;
+
+        /**
+         * 查找并在读临界区中访问value，避免拷贝
+         * @param f: 可调用对象，参数为const Value&
+         * @return 是否找到
+         */
+        template<typename K, typename F>
+        bool visit(const K& key, F&& f) const;
+
+        template<typename K>
+        bool contains(const K& key) const;
+
+        /**
+         * 插入或者更新
+         * @return true表示新插入，false表示更新了已有元素
+         */
+        template<typename K, typename V>
+        bool insert_or_assign(K&& key, V&& value);
+
+        /**
+         * 删除
+         * @return 是否删除了元素
+         */
+        template<typename K>
+        bool erase(const K& key);
+
+        size_t size() const {
+            return count.load(std::memory_order_relaxed);
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+    };
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    ConcurrentHashMap<Key, Value, Hash, KeyEqual>::ConcurrentHashMap(size_t bucket_count)
+            : stripes(new Stripe[kStripeCount]), count(0) {
+        size_t n = kStripeCount;
+        while (n < bucket_count) {
+            n <<= 1;
+        }
+        table.store(new Table(n), std::memory_order_release);
+    }
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    ConcurrentHashMap<Key, Value, Hash, KeyEqual>::~ConcurrentHashMap() {
+        // 析构时不应再有其他线程访问，已迁移的桶中的节点已经退休，由回收域负责释放
+        Table* t = table.load(std::memory_order_acquire);
+        for (size_t i = 0; i < t->bucket_count(); i++) {
+            if (!t->buckets[i].migrated.load(std::memory_order_relaxed)) {
+                free_chain(t->buckets[i].head.load(std::memory_order_relaxed));
+            }
+        }
+
+        Table* n = t->next.load(std::memory_order_acquire);
+        if (n) { // 扩容尚未完成
+            for (size_t i = 0; i < n->bucket_count(); i++) {
+                free_chain(n->buckets[i].head.load(std::memory_order_relaxed));
+            }
+            delete n;
+        }
+        delete t;
+    }
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    void ConcurrentHashMap<Key, Value, Hash, KeyEqual>::free_chain(Node* node) {
+        while (node) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    template<typename K>
+    typename ConcurrentHashMap<Key, Value, Hash, KeyEqual>::Node*
+    ConcurrentHashMap<Key, Value, Hash, KeyEqual>::find_node(const K& key, size_t hash) const {
+        Table* t = table.load(std::memory_order_acquire);
+        while (t->bucket(hash).migrated.load(std::memory_order_acquire)) { // 已经迁移的桶到新表中去找
+            t = t->next.load(std::memory_order_acquire);
+        }
+
+        for (Node* node = t->bucket(hash).head.load(std::memory_order_acquire); node;
+             node = node->next.load(std::memory_order_acquire)) {
+            if (node->hash == hash && key_equal(node->key, key)) {
+                return node;
+            }
+        }
+        return nullptr;
+    }
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    template<typename K>
+    bool ConcurrentHashMap<Key, Value, Hash, KeyEqual>::find(const K& key, Value& value) const {
+        return visit(key, [&value](const Value& v) { value = v; });
+    }
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    template<typename K, typename F>
+    bool ConcurrentHashMap<Key, Value, Hash, KeyEqual>::visit(const K& key, F&& f) const {
+        EpochGuard guard; // 临界区中访问到的节点不会被释放
+        Node* node = find_node(key, hasher(key));
+        if (!node) {
+            return false;
+        }
+        f(node->value);
+        return true;
+    }
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    template<typename K>
+    bool ConcurrentHashMap<Key, Value, Hash, KeyEqual>::contains(const K& key) const {
+        EpochGuard guard;
+        return find_node(key, hasher(key)) != nullptr;
+    }
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    typename ConcurrentHashMap<Key, Value, Hash, KeyEqual>::Table*
+    ConcurrentHashMap<Key, Value, Hash, KeyEqual>::locked_table(size_t hash) {
+        // 持有分段锁时，该分段中桶的迁移状态不会改变
+        Table* t = table.load(std::memory_order_acquire);
+        while (t->bucket(hash).migrated.load(std::memory_order_acquire)) {
+            t = t->next.load(std::memory_order_acquire);
+        }
+        return t;
+    }
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    template<typename K>
+    std::atomic<typename ConcurrentHashMap<Key, Value, Hash, KeyEqual>::Node*>*
+    ConcurrentHashMap<Key, Value, Hash, KeyEqual>::find_link(Bucket& bucket, const K& key, size_t hash) {
+        std::atomic<Node*>* link = &bucket.head;
+        for (Node* node = link->load(std::memory_order_relaxed); node; node = link->load(std::memory_order_relaxed)) {
+            if (node->hash == hash && key_equal(node->key, key)) {
+                return link;
+            }
+            link = &node->next;
+        }
+        return nullptr;
+    }
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    template<typename K, typename V>
+    bool ConcurrentHashMap<Key, Value, Hash, KeyEqual>::insert_or_assign(K&& key, V&& value) {
+        EpochGuard guard; // 防止当前使用的表被扩容完成后释放
+        size_t const hash = hasher(key);
+        Node* old_node = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(stripe_of(hash));
+            Bucket& bucket = locked_table(hash)->bucket(hash);
+            std::atomic<Node*>* link = find_link(bucket, key, hash);
+            if (link) { // 已存在则用新节点替换旧节点，正在读旧节点的线程不受影响
+                old_node = link->load(std::memory_order_relaxed);
+                Node* node = new Node(std::forward<K>(key), std::forward<V>(value), hash,
+                                      old_node->next.load(std::memory_order_relaxed));
+                link->store(node, std::memory_order_release);
+            } else { // 不存在则插入到链表头部
+                Node* node = new Node(std::forward<K>(key), std::forward<V>(value), hash,
+                                      bucket.head.load(std::memory_order_relaxed));
+                bucket.head.store(node, std::memory_order_release);
+            }
+        }
+
+        if (old_node) {
+            EpochDomain::instance().retire(old_node);
+        } else {
+            maybe_grow(count.fetch_add(1, std::memory_order_relaxed) + 1);
+        }
+        help_migrate();
+        return old_node == nullptr;
+    }
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    template<typename K>
+    bool ConcurrentHashMap<Key, Value, Hash, KeyEqual>::erase(const K& key) {
+        EpochGuard guard;
+        size_t const hash = hasher(key);
+        Node* old_node = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(stripe_of(hash));
+            std::atomic<Node*>* link = find_link(locked_table(hash)->bucket(hash), key, hash);
+            if (link) {
+                old_node = link->load(std::memory_order_relaxed);
+                link->store(old_node->next.load(std::memory_order_relaxed), std::memory_order_release);
+            }
+        }
+
+        if (!old_node) {
+            return false;
+        }
+        EpochDomain::instance().retire(old_node);
+        count.fetch_sub(1, std::memory_order_relaxed);
+        help_migrate();
+        return true;
+    }
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    void ConcurrentHashMap<Key, Value, Hash, KeyEqual>::maybe_grow(size_t new_count) {
+        Table* t = table.load(std::memory_order_acquire);
+        if (new_count <= t->bucket_count() * kMaxLoadFactor || t->next.load(std::memory_order_acquire)) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(resize_mutex);
+        if (table.load(std::memory_order_acquire) != t || t->next.load(std::memory_order_acquire)) { // 其他线程已经开始扩容
+            return;
+        }
+        t->next.store(new Table(t->bucket_count() * 2), std::memory_order_release);
+    }
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    void ConcurrentHashMap<Key, Value, Hash, KeyEqual>::help_migrate() {
+        Table* t = table.load(std::memory_order_acquire);
+        Table* n = t->next.load(std::memory_order_acquire);
+        if (!n) { // 没有在扩容
+            return;
+        }
+
+        for (size_t i = 0; i < kMigrateBatch; i++) {
+            size_t const index = t->migrate_cursor.fetch_add(1, std::memory_order_relaxed);
+            if (index >= t->bucket_count()) {
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(stripe_of(index));
+                migrate_bucket(t, n, index);
+            }
+
+            if (t->migrated_count.fetch_add(1, std::memory_order_acq_rel) + 1 == t->bucket_count()) {
+                table.store(n, std::memory_order_release); // 所有桶迁移完成，切换到新表
+                EpochDomain::instance().retire(t); // 可能还有读线程持有旧表指针，延迟释放
+                return;
+            }
+        }
+    }
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    void ConcurrentHashMap<Key, Value, Hash, KeyEqual>::migrate_bucket(Table* from, Table* to, size_t index) {
+        Bucket& bucket = from->buckets[index];
+
+        // 旧桶中的元素拷贝到新表，旧桶i只会被分配到新桶i和i + n，在迁移完成之前新桶不会被其他线程写入
+        for (Node* node = bucket.head.load(std::memory_order_relaxed); node;
+             node = node->next.load(std::memory_order_relaxed)) {
+            Bucket& new_bucket = to->bucket(node->hash);
+            new_bucket.head.store(new Node(node->key, node->value, node->hash,
+                                           new_bucket.head.load(std::memory_order_relaxed)),
+                                  std::memory_order_release);
+        }
+        bucket.migrated.store(true, std::memory_order_release); // 之后的读写都转到新表
+
+        // 正在遍历旧链表的读线程仍然可以安全地读完，迁移后旧链表不再被修改，整条链表作为一个对象在宽限期之后释放
+        Node* head = bucket.head.load(std::memory_order_relaxed);
+        if (head) {
+            EpochDomain::instance().retire(head, [](void* p) { free_chain(static_cast<Node*>(p)); });
+        }
+    }
+}
+
+#endif //SHAREDDATABETWEENTHREADS_CONCURRENT_HASH_MAP_HPP
@@ -0,0 +1,263 @@
+/**
+ * 高性能的并发栈，针对thread_safe_stack.hpp中ThreadSafeStack的开销：push按值拷贝、pop通过make_shared再拷贝一次、栈为空时抛出异常。
+ * 1. push/emplace移动或者直接构造元素，try_pop(T&)把元素移动出来，栈为空时返回false，不抛出异常；
+ * 2. pop_all一次取出所有元素（后入栈的在前），适合批量消费；
+ * 3. LockFree为false时用互斥元保护std::vector，为true时是无锁的Treiber栈：
+ *    节点从分块的节点池中分配，弹出的节点放回空闲链表复用、直到栈析构才释放，读取到已经弹出的节点也不会访问已释放的内存；
+ *    栈顶保存32位节点下标和32位版本号，每次修改都把版本号加一，避免ABA问题，只需要64位的compare_exchange。
+ * 适合对象池这类LIFO回收的场景：刚放回的对象最先被取出，cache仍然是热的。
+ */
+
+#ifndef SHAREDDATABETWEENTHREADS_CONCURRENT_STACK_HPP
+#define SHAREDDATABETWEENTHREADS_CONCURRENT_STACK_HPP
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace zhaocc {
+    template<typename T, bool LockFree = false>
+    class ConcurrentStack {
+    private:
+        std::vector<T> data; // 栈顶在末尾
+        mutable std::mutex m;
+
+    public:
+        ConcurrentStack() = default;
+
+        ConcurrentStack(const ConcurrentStack&) = delete;
+
+        ConcurrentStack& operator=(const ConcurrentStack&) = delete;
+
+        /* 左值拷贝一次，右值不拷贝 */
+        void push(T new_val) {
+            std::lock_guard<std::mutex> lock(m);
+            data.push_back(std::move(new_val));
+        }
+
+        template<typename... Args>
+        void emplace(Args&& ... args) {
+            std::lock_guard<std::mutex> lock(m);
+            data.emplace_back(std::forward<Args>(args)...);
+        }
+
+        /**
+         * 把栈顶元素移动到value
+         * @return 栈为空时返回false
+         */
+        bool try_pop(T& value) {
+            std::lock_guard<std::mutex> lock(m);
+            if (data.empty()) {
+                return false;
+            }
+            value = std::move(data.back());
+            data.pop_back();
+            return true;
+        }
+
+        /**
+         * 一次加锁取出所有元素，按出栈顺序（后入栈的在前）移动到out
+         * @return 取出的元素数量
+         */
+        template<typename OutputIt>
+        size_t pop_all(OutputIt out) {
+            std::vector<T> taken;
+            {
+                std::lock_guard<std::mutex> lock(m);
+                taken.swap(data);
+            }
+            for (auto it = taken.rbegin(); it != taken.rend(); ++it) { // 在锁外移动元素
+                *out++ = std::move(*it);
+            }
+            return taken.size();
+        }
+
+        bool empty() const {
+            std::lock_guard<std::mutex> lock(m);
+            return data.empty();
+        }
+    };
+
+    template<typename T>
+    class ConcurrentStack<T, true> {
+    private:
+        static constexpr uint32_t kNull = UINT32_MAX; // 空下标
+        static constexpr unsigned kFirstChunkShift = 6; // 第一块64个节点，之后每块翻倍
+        static constexpr unsigned kMaxChunks = 26; // 总共64 * (2^26 - 1)个节点，下标不超过32位
+
+        struct Node {
+            std::atomic<uint32_t> next{kNull}; // 已经弹出的节点可能仍被其他线程读取，使用原子变量
+            alignas(T) unsigned char storage[sizeof(T)];
+
+            T* value() {
+                return std::launder(reinterpret_cast<T*>(storage));
+            }
+        };
+
+        alignas(64) std::atomic<uint64_t> head{kNull}; // 高32位为版本号，低32位为栈顶下标
+        alignas(64) std::atomic<uint64_t> free_head{kNull}; // 空闲节点链表
+        alignas(64) std::atomic<uint32_t> allocated{0}; // 已经分配出去过的节点数量
+        std::atomic<Node*> chunks[kMaxChunks] = {};
+        std::mutex grow_mutex; // 只在分配新的节点块时使用
+
+        static uint64_t pack(uint32_t index, uint64_t old) {
+            return ((old >> 32) + 1) << 32 | index; // 版本号加一
+        }
+
+        static uint32_t index_of(uint64_t top) {
+            return static_cast<uint32_t>(top);
+        }
+
+        Node& node(uint32_t index) {
+            uint64_t const v = static_cast<uint64_t>(index) + (1u << kFirstChunkShift);
+            unsigned const chunk = std::bit_width(v) - 1 - kFirstChunkShift;
+            return chunks[chunk].load(std::memory_order_acquire)[v - (uint64_t(1) << (chunk + kFirstChunkShift))];
+        }
+
+        void push_index(std::atomic<uint64_t>& top, uint32_t index); // 把节点压入top链表
+        bool pop_index(std::atomic<uint64_t>& top, uint32_t& index); // 从top链表弹出一个节点
+        uint32_t acquire_node(); // 优先复用空闲节点，没有时分配新节点
+        void release_node(uint32_t index) { push_index(free_head, index); }
+
+    public:
+        ConcurrentStack() = default;
+
+        ConcurrentStack(const ConcurrentStack&) = delete;
+
+        ConcurrentStack& operator=(const ConcurrentStack&) = delete;
+
+        ~ConcurrentStack();
+
+        void push(T new_val) {
+            emplace(std::move(new_val));
+        }
+
+        template<typename... Args>
+        void emplace(Args&& ... args);
+
+        /**
+         * 把栈顶元素移动到value，T的移动赋值不应抛出异常
+         * @return 栈为空时返回false
+         */
+        bool try_pop(T& value);
+
+        /**
+         * 一次CAS取下整条链表，按出栈顺序（后入栈的在前）移动到out
+         * @return 取出的元素数量
+         */
+        template<typename OutputIt>
+        size_t pop_all(OutputIt out);
+
+        bool empty() const {
+            return index_of(head.load(std::memory_order_relaxed)) == kNull;
+        }
+    };
+
+    template<typename T>
+    ConcurrentStack<T, true>::~ConcurrentStack() {
+        for (uint32_t i = index_of(head.load()); i != kNull;) {
+            Node& n = node(i);
+            n.value()->~T();
+            i = n.next.load(std::memory_order_relaxed);
+        }
+        for (auto& chunk : chunks) {
+            delete[] chunk.load();
+        }
+    }
+
+    template<typename T>
+    void ConcurrentStack<T, true>::push_index(std::atomic<uint64_t>& top, uint32_t index) {
+        Node& n = node(index);
+        uint64_t old = top.load(std::memory_order_relaxed);
+        do {
+            n.next.store(index_of(old), std::memory_order_relaxed);
+        } while (!top.compare_exchange_weak(old, pack(index, old), std::memory_order_release,
+                                            std::memory_order_relaxed));
+    }
+
+    template<typename T>
+    bool ConcurrentStack<T, true>::pop_index(std::atomic<uint64_t>& top, uint32_t& index) {
+        uint64_t old = top.load(std::memory_order_acquire);
+        while (index_of(old) != kNull) {
+            // 节点可能已经被其他线程弹出并重新压入，读到的next是旧值，但版本号已经变化，下面的CAS会失败
+            uint32_t const next = node(index_of(old)).next.load(std::memory_order_relaxed);
+            if (top.compare_exchange_weak(old, pack(next, old), std::memory_order_acquire,
+                                          std::memory_order_acquire)) {
+                index = index_of(old);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template<typename T>
+    uint32_t ConcurrentStack<T, true>::acquire_node() {
+        uint32_t index;
+        if (pop_index(free_head, index)) {
+            return index;
+        }
+        index = allocated.fetch_add(1, std::memory_order_relaxed);
+        if (index >= kNull - (1u << kFirstChunkShift)) {
+            throw std::bad_alloc();
+        }
+        uint64_t const v = static_cast<uint64_t>(index) + (1u << kFirstChunkShift);
+        unsigned const chunk = std::bit_width(v) - 1 - kFirstChunkShift;
+        if (chunks[chunk].load(std::memory_order_acquire) == nullptr) {
+            std::lock_guard<std::mutex> lock(grow_mutex);
+            if (chunks[chunk].load(std::memory_order_relaxed) == nullptr) {
+                chunks[chunk].store(new Node[size_t(1) << (chunk + kFirstChunkShift)], std::memory_order_release);
+            }
+        }
+        return index;
+    }
+
+    template<typename T>
+    template<typename... Args>
+    void ConcurrentStack<T, true>::emplace(Args&& ... args) {
+        uint32_t const index = acquire_node();
+        try {
+            new(node(index).storage) T(std::forward<Args>(args)...);
+        } catch (...) {
+            release_node(index);
+            throw;
+        }
+        push_index(head, index);
+    }
+
+    template<typename T>
+    bool ConcurrentStack<T, true>::try_pop(T& value) {
+        uint32_t index;
+        if (!pop_index(head, index)) {
+            return false;
+        }
+        Node& n = node(index);
+        value = std::move(*n.value());
+        n.value()->~T();
+        release_node(index);
+        return true;
+    }
+
+    template<typename T>
+    template<typename OutputIt>
+    size_t ConcurrentStack<T, true>::pop_all(OutputIt out) {
+        uint64_t old = head.load(std::memory_order_acquire);
+        while (index_of(old) != kNull && !head.compare_exchange_weak(old, pack(kNull, old), std::memory_order_acquire,
+                                                                     std::memory_order_acquire));
+        size_t count = 0;
+        for (uint32_t i = index_of(old); i != kNull; count++) {
+            Node& n = node(i);
+            *out++ = std::move(*n.value());
+            n.value()->~T();
+            uint32_t const next = n.next.load(std::memory_order_relaxed); // 放回空闲链表会改写next，先读出来
+            release_node(i);
+            i = next;
+        }
+        return count;
+    }
+}
+
+#endif //SHAREDDATABETWEENTHREADS_CONCURRENT_STACK_HPP
@@ -0,0 +1,306 @@
+/**
+ * 基于epoch的延迟内存回收（epoch based reclamation）。
+ * 读线程进入临界区时只在自己独占的cache line上记录当前的全局epoch，不会写任何共享数据；写线程把节点从数据结构中摘除后将其“退休”，
+ * 等所有读线程都离开了退休时所在的epoch（即经过一个宽限期，grace period）后再真正释放，这样读线程就可以无锁地遍历共享数据结构。
+ *
+ * linux下使用membarrier系统调用实现非对称内存屏障：读线程只需要编译器屏障，由很少执行的回收动作来承担完整内存屏障的开销。
+ * 退休的对象先放在每个线程自己的链表中，攒够kLocalBatch个才加锁交给回收域，写线程之间不会在每次退休时争抢同一把锁。
+ */
+
+#ifndef SHAREDDATABETWEENTHREADS_EPOCH_RECLAIMER_HPP
+#define SHAREDDATABETWEENTHREADS_EPOCH_RECLAIMER_HPP
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <thread>
+#include <cstdint>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/membarrier.h>
+#endif
+
+namespace zhaocc {
+    class EpochDomain {
+    private:
+        /* 已经退休等待回收的对象 */
+        struct Retired {
+            void* ptr;
+            void (* deleter)(void*);
+            uint64_t epoch; // 退休时的全局epoch
+        };
+
+        /* 每个线程对应一条记录，独占一个cache line防止伪共享 */
+        struct alignas(64) ThreadRecord {
+            std::atomic<uint64_t> epoch{0}; // 0表示当前线程不在临界区中，否则为进入临界区时看到的全局epoch
+            std::atomic<bool> in_use{false}; // 该记录是否被某个线程占用
+            unsigned depth = 0; // 临界区的嵌套深度，只会被占用该记录的线程访问
+            ThreadRecord* next = nullptr; // 所有记录组成一个只增不减的链表
+            std::vector<Retired> retired; // 当前线程退休、还没有交给回收域的对象，只会被占用该记录的线程访问
+        };
+
+        /* 线程退出时归还占用的记录，使得记录可以被后续新建的线程复用 */
+        class RecordHolder {
+        private:
+            EpochDomain* domain;
+            ThreadRecord* rec;
+        public:
+            RecordHolder(EpochDomain* domain_, ThreadRecord* rec_) : domain(domain_), rec(rec_) {}
+
+            ~RecordHolder() {
+                domain->flush(rec->retired); // 没攒够一批的退休对象交给回收域，由其他线程回收
+                rec->epoch.store(0, std::memory_order_release);
+                rec->depth = 0;
+                rec->in_use.store(false, std::memory_order_release);
+            }
+        };
+
+        static constexpr size_t kLocalBatch = 64; // 每个线程攒够这么多退休对象才交给回收域
+        static constexpr size_t kReclaimThreshold = 128; // 回收域每收到这么多对象尝试回收一次
+
+        std::atomic<uint64_t> global_epoch; // 全局epoch，从1开始
+        std::atomic<ThreadRecord*> records; // 所有线程记录链表头
+        std::mutex retired_mutex; // 保护退休链表
+        std::vector<Retired> retired; // 等待回收的对象
+        size_t reclaim_mark; // 退休链表长度达到该值时尝试回收
+        bool asymmetric; // 是否支持membarrier非对称屏障
+
+        EpochDomain();
+
+        EpochDomain(const EpochDomain&) = delete;
+
+        EpochDomain& operator=(const EpochDomain&) = delete;
+
+        ThreadRecord* local_record(); // 获取当前线程的记录，首次调用时注册
+        ThreadRecord* register_thread(); // 为当前线程申请一条记录
+        void light_barrier() const; // 读线程一侧的轻量屏障
+        void heavy_barrier() const; // 回收线程一侧的重量屏障
+        bool try_advance(); // 所有活跃的读线程都已经看到当前epoch时，推进全局epoch
+        std::vector<Retired> collect_locked(); // 在持有retired_mutex时取出所有可以安全释放的对象
+        void flush(std::vector<Retired>& local); // 把线程自己的退休对象交给回收域，必要时回收
+
+    public:
+        ~EpochDomain();
+
+        /* 全局唯一的回收域，使用局部静态变量实现线程安全的lazy-initialization */
+        static EpochDomain& instance();
+
+        void enter(); // 进入读临界区，可以嵌套
+        void leave(); // 离开读临界区
+
+        /**
+         * 退休一个已经从共享数据结构中摘除的对象，宽限期过后自动调用deleter释放
+         * @param ptr: 对象指针
+         * @param deleter: 释放函数
+         */
+        void retire(void* ptr, void (* deleter)(void*));
+
+        template<typename T>
+        void retire(T* ptr) {
+            retire(static_cast<void*>(ptr), [](void* p) { delete static_cast<T*>(p); });
+        }
+
+        /**
+         * 阻塞等待一个完整的宽限期，返回时当前线程在调用前退休的对象，以及其他线程已经交给回收域的对象都已经被释放。
+         * 不能在读临界区中调用，否则会死锁
+         */
+        void synchronize();
+    };
+
+    /* RAII方式进入和离开读临界区 */
+    class EpochGuard {
+    private:
+        EpochDomain& domain;
+    public:
+        EpochGuard() : domain(EpochDomain::instance()) {
+            domain.enter();
+        }
+
+        ~EpochGuard() {
+            domain.leave();
+        }
+
+        EpochGuard(const EpochGuard&) = delete;
+
+        EpochGuard& operator=(const EpochGuard&) = delete;
+    };
+
+    inline EpochDomain::EpochDomain() : global_epoch(1), records(nullptr), reclaim_mark(kReclaimThreshold),
+                                        asymmetric(false) {
+#if defined(__linux__) && defined(__NR_membarrier)
+        // 注册后才能使用MEMBARRIER_CMD_PRIVATE_EXPEDITED，内核不支持（或被seccomp拦截）时退化为对称的内存屏障
+        asymmetric = syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+#endif
+    }
+
+    inline EpochDomain::~EpochDomain() {
+        for (auto& r : retired) {
+            r.deleter(r.ptr);
+        }
+        ThreadRecord* rec = records.load(std::memory_order_acquire);
+        while (rec) {
+            for (auto& r : rec->retired) { // 仍在运行的线程（例如detach的线程）没有交出的对象
+                r.deleter(r.ptr);
+            }
+            ThreadRecord* next = rec->next;
+            delete rec;
+            rec = next;
+        }
+    }
+
+    inline EpochDomain& EpochDomain::instance() {
+        static EpochDomain domain;
+        return domain;
+    }
+
+    inline EpochDomain::ThreadRecord* EpochDomain::local_record() {
+        static thread_local ThreadRecord* rec = nullptr; // 常量初始化的thread_local，访问时没有额外的初始化检查
+        if (!rec) {
+            rec = register_thread();
+        }
+        return rec;
+    }
+
+    inline EpochDomain::ThreadRecord* EpochDomain::register_thread() {
+        ThreadRecord* rec = nullptr;
+        for (ThreadRecord* it = records.load(std::memory_order_acquire); it; it = it->next) { // 优先复用已退出线程的记录
+            bool expected = false;
+            if (!it->in_use.load(std::memory_order_relaxed) &&
+                it->in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                rec = it;
+                break;
+            }
+        }
+
+        if (!rec) {
+            rec = new ThreadRecord;
+            rec->in_use.store(true, std::memory_order_relaxed);
+            rec->next = records.load(std::memory_order_relaxed);
+            while (!records.compare_exchange_weak(rec->next, rec, std::memory_order_release,
+                                                  std::memory_order_relaxed));
+        }
+
+        static thread_local RecordHolder holder(this, rec); // 线程退出时析构，归还记录
+        return rec;
+    }
+
+    inline void EpochDomain::light_barrier() const {
+        if (asymmetric) {
+            std::atomic_signal_fence(std::memory_order_seq_cst); // 只阻止编译器重排，cpu层面的屏障由heavy_barrier补上
+        } else {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    inline void EpochDomain::heavy_barrier() const {
+#if defined(__linux__) && defined(__NR_membarrier)
+        if (asymmetric) {
+            syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0); // 使本进程所有正在运行的线程都执行一次完整内存屏障
+            return;
+        }
+#endif
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    inline void EpochDomain::enter() {
+        ThreadRecord* rec = local_record();
+        if (rec->depth++ == 0) {
+            rec->epoch.store(global_epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            light_barrier(); // 保证记录epoch的动作先于之后对共享数据的读取
+        }
+    }
+
+    inline void EpochDomain::leave() {
+        ThreadRecord* rec = local_record();
+        if (--rec->depth == 0) {
+            rec->epoch.store(0, std::memory_order_release); // 保证临界区中的读取先于离开动作
+        }
+    }
+
+    inline bool EpochDomain::try_advance() {
+        uint64_t epoch = global_epoch.load(std::memory_order_acquire);
+        heavy_barrier(); // 之前的摘除动作对所有读线程可见，同时读线程记录的epoch对当前线程可见
+        for (ThreadRecord* rec = records.load(std::memory_order_acquire); rec; rec = rec->next) {
+            uint64_t const e = rec->epoch.load(std::memory_order_acquire);
+            if (e != 0 && e != epoch) { // 还有读线程停留在旧的epoch
+                return false;
+            }
+        }
+        global_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel);
+        return true;
+    }
+
+    inline std::vector<EpochDomain::Retired> EpochDomain::collect_locked() {
+        try_advance();
+        uint64_t const epoch = global_epoch.load(std::memory_order_acquire);
+
+        // 在epoch e退休的对象，等全局epoch推进到e + 2时，所有可能看到它的读线程都已经离开了
+        std::vector<Retired> ready;
+        auto keep_end = retired.begin();
+        for (auto it = retired.begin(); it != retired.end(); ++it) {
+            if (it->epoch + 2 <= epoch) {
+                ready.push_back(*it);
+            } else {
+                *keep_end++ = *it;
+            }
+        }
+        retired.erase(keep_end, retired.end());
+        reclaim_mark = retired.size() + kReclaimThreshold;
+        return ready;
+    }
+
+    inline void EpochDomain::flush(std::vector<Retired>& local) {
+        std::vector<Retired> ready;
+        {
+            std::lock_guard<std::mutex> lock(retired_mutex);
+            retired.insert(retired.end(), local.begin(), local.end());
+            local.clear(); // 保留容量，下一批不用重新分配
+            if (retired.size() < reclaim_mark) {
+                return;
+            }
+            ready = collect_locked();
+        }
+
+        for (auto& r : ready) { // 在锁外释放，缩短临界区
+            r.deleter(r.ptr);
+        }
+    }
+
+    inline void EpochDomain::retire(void* ptr, void (* deleter)(void*)) {
+        ThreadRecord* rec = local_record();
+        // 记录的epoch不晚于交给回收域的时刻，延迟交出只会推迟释放，不影响安全性
+        rec->retired.push_back({ptr, deleter, global_epoch.load(std::memory_order_acquire)});
+        if (rec->retired.size() >= kLocalBatch) {
+            flush(rec->retired);
+        }
+    }
+
+    inline void EpochDomain::synchronize() {
+        ThreadRecord* rec = local_record();
+        {
+            std::lock_guard<std::mutex> lock(retired_mutex);
+            retired.insert(retired.end(), rec->retired.begin(), rec->retired.end());
+            rec->retired.clear();
+        }
+
+        uint64_t const target = global_epoch.load(std::memory_order_acquire) + 2;
+        while (global_epoch.load(std::memory_order_acquire) < target) {
+            if (!try_advance()) {
+                std::this_thread::yield(); // 等待停留在旧epoch的读线程离开
+            }
+        }
+
+        std::vector<Retired> ready;
+        {
+            std::lock_guard<std::mutex> lock(retired_mutex);
+            ready = collect_locked();
+        }
+        for (auto& r : ready) {
+            r.deleter(r.ptr);
+        }
+    }
+}
+
+#endif //SHAREDDATABETWEENTHREADS_EPOCH_RECLAIMER_HPP
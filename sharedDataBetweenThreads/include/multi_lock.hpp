@@ -0,0 +1,242 @@
+/**
+ * 锁定多个互斥元时避免死锁的工具，对应lockMultiMutex.cpp中std::lock + adopt_lock的用法：
+ * 1. MultiLock按固定的全局顺序（层级从高到低，同一层级内按地址从小到大）依次锁定最多MaxLocks个互斥元，析构时逆序解锁，
+ *    所有线程都按同一顺序加锁就不会形成环；重复的互斥元只锁一次（例如转账双方是同一个账户）。
+ *    与std::lock相比不需要try_lock + 回退重试，互斥元较多、竞争激烈时不会反复加锁解锁。
+ * 2. HierarchicalMutex给互斥元指定层级，未定义NDEBUG时由LockHierarchy检查每个线程的加锁顺序：
+ *    只能在已持有的锁之下加锁（层级更低，或者同一层级且地址更大），违反时在阻塞之前抛出LockOrderViolation，
+ *    不需要真的发生死锁就能发现错误的加锁顺序；定义NDEBUG时检查代码全部去掉，没有额外开销。
+ */
+
+#ifndef SHAREDDATABETWEENTHREADS_MULTI_LOCK_HPP
+#define SHAREDDATABETWEENTHREADS_MULTI_LOCK_HPP
+
+#include <array>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace zhaocc {
+    // 加锁顺序违反锁层级
+    struct LockOrderViolation : std::logic_error {
+        using std::logic_error::logic_error;
+    };
+
+    /* 每个线程已持有的层级锁，只在调试模式下记录 */
+    class LockHierarchy {
+    public:
+#ifdef NDEBUG
+        static constexpr bool kEnabled = false;
+#else
+        static constexpr bool kEnabled = true;
+#endif
+
+    private:
+        struct Held {
+            unsigned level;
+            const void* mutex;
+        };
+
+        static std::vector<Held>& held() {
+            thread_local std::vector<Held> locks;
+            return locks;
+        }
+
+    public:
+        /* 阻塞加锁之前检查：必须低于当前线程最后持有的锁 */
+        static void check(unsigned level, const void* mutex) {
+            std::vector<Held> const& locks = held();
+            if (locks.empty()) {
+                return;
+            }
+            Held const& last = locks.back();
+            if (level < last.level || (level == last.level && std::less<const void*>()(last.mutex, mutex))) {
+                return;
+            }
+            throw LockOrderViolation("lock hierarchy violated: locking level " + std::to_string(level) +
+                                     " while holding level " + std::to_string(last.level));
+        }
+
+        static void acquired(unsigned level, const void* mutex) {
+            held().push_back({level, mutex});
+        }
+
+        /* 解锁顺序不一定与加锁相反，从后向前查找 */
+        static void released(const void* mutex) {
+            std::vector<Held>& locks = held();
+            for (auto it = locks.rbegin(); it != locks.rend(); ++it) {
+                if (it->mutex == mutex) {
+                    locks.erase(std::next(it).base());
+                    return;
+                }
+            }
+        }
+    };
+
+    /**
+     * 带层级的互斥元，满足Lockable，可以用于lock_guard、unique_lock以及MultiLock
+     * @tparam Mutex: 实际的互斥元，例如std::mutex或者ProfiledMutex
+     */
+    template<typename Mutex = std::mutex>
+    class HierarchicalMutex {
+    private:
+        Mutex mutex;
+        unsigned const hierarchy_level;
+
+    public:
+        /**
+         * 构造函数
+         * @param level: 层级，持有高层级的锁时才能加低层级的锁
+         * @param args: 传给实际互斥元的参数
+         */
+        template<typename... Args>
+        explicit HierarchicalMutex(unsigned level, Args&& ... args)
+                : mutex(std::forward<Args>(args)...), hierarchy_level(level) {}
+
+        HierarchicalMutex(const HierarchicalMutex&) = delete;
+
+        HierarchicalMutex& operator=(const HierarchicalMutex&) = delete;
+
+        void lock() {
+            if constexpr (LockHierarchy::kEnabled) {
+                LockHierarchy::check(hierarchy_level, this);
+            }
+            mutex.lock();
+            if constexpr (LockHierarchy::kEnabled) {
+                LockHierarchy::acquired(hierarchy_level, this);
+            }
+        }
+
+        /* try_lock不会阻塞，不检查顺序，只记录 */
+        bool try_lock() {
+            if (!mutex.try_lock()) {
+                return false;
+            }
+            if constexpr (LockHierarchy::kEnabled) {
+                LockHierarchy::acquired(hierarchy_level, this);
+            }
+            return true;
+        }
+
+        void unlock() {
+            if constexpr (LockHierarchy::kEnabled) {
+                LockHierarchy::released(this);
+            }
+            mutex.unlock();
+        }
+
+        unsigned level() const {
+            return hierarchy_level;
+        }
+    };
+
+    /**
+     * 按全局顺序锁定多个互斥元，RAII方式解锁
+     * @tparam Mutex: 互斥元类型，有level()时先按层级从高到低排序
+     * @tparam MaxLocks: 最多锁定的互斥元数量，使用定长数组保存，不分配内存
+     */
+    template<typename Mutex, size_t MaxLocks = 8>
+    class MultiLock {
+    private:
+        std::array<Mutex*, MaxLocks> mutexes{};
+        size_t count = 0;
+
+        /* a是否应该在b之前加锁 */
+        static bool before(const Mutex* a, const Mutex* b) {
+            if constexpr (requires(const Mutex& m) { m.level(); }) {
+                if (a->level() != b->level()) {
+                    return a->level() > b->level();
+                }
+            }
+            return std::less<const Mutex*>()(a, b);
+        }
+
+        void add(Mutex& m) {
+            if (count == MaxLocks) {
+                throw std::length_error("MultiLock: too many mutexes");
+            }
+            mutexes[count++] = &m;
+        }
+
+        /* 对mutexes[0, count)插入排序并去重，元素最多MaxLocks个，插入排序足够快，
+         * 并且只访问下标小于count的元素（std::sort在GCC 12下会触发-Warray-bounds误报） */
+        void sort_unique() {
+            size_t unique_count = 0;
+            for (size_t i = 0; i < count; i++) {
+                Mutex* m = mutexes[i];
+                size_t j = unique_count;
+                while (j > 0 && before(m, mutexes[j - 1])) {
+                    j--;
+                }
+                if (j > 0 && mutexes[j - 1] == m) {
+                    continue; // 同一个互斥元只加锁一次
+                }
+                for (size_t k = unique_count; k > j; k--) {
+                    mutexes[k] = mutexes[k - 1];
+                }
+                mutexes[j] = m;
+                unique_count++;
+            }
+            count = unique_count;
+        }
+
+        /* 排序去重后依次加锁，加锁失败（例如层级检查抛出异常）时解开已经锁定的 */
+        void lock_all() {
+            sort_unique();
+            for (size_t i = 0; i < count; i++) {
+                try {
+                    mutexes[i]->lock();
+                } catch (...) {
+                    while (i > 0) {
+                        mutexes[--i]->unlock();
+                    }
+                    count = 0;
+                    throw;
+                }
+            }
+        }
+
+    public:
+        template<typename... Mutexes>
+        explicit MultiLock(Mutex& first, Mutexes& ... rest) {
+            add(first);
+            (add(rest), ...);
+            lock_all();
+        }
+
+        /* 锁定迭代器范围内的互斥元，元素为Mutex*或者Mutex& */
+        template<std::input_iterator InputIt>
+        MultiLock(InputIt first, InputIt last) {
+            for (; first != last; ++first) {
+                if constexpr (std::is_pointer_v<typename std::iterator_traits<InputIt>::value_type>) {
+                    add(**first);
+                } else {
+                    add(*first);
+                }
+            }
+            lock_all();
+        }
+
+        MultiLock(const MultiLock&) = delete;
+
+        MultiLock& operator=(const MultiLock&) = delete;
+
+        ~MultiLock() {
+            while (count > 0) {
+                mutexes[--count]->unlock();
+            }
+        }
+
+        /* 实际锁定的互斥元数量（去重之后） */
+        size_t size() const {
+            return count;
+        }
+    };
+}
+
+#endif //SHAREDDATABETWEENTHREADS_MULTI_LOCK_HPP
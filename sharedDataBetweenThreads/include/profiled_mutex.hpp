@@ -0,0 +1,228 @@
+/**
+ * 统计锁竞争的互斥元：ProfiledMutex按加锁点（lock site，构造时给定的名字，多个互斥元可以共用同一个加锁点，例如所有账户锁）
+ * 记录加锁次数、发生竞争（try_lock失败后阻塞）的次数、等待时间和持有时间。
+ * 计数写在每个线程自己的缓冲区中，只有所属线程修改，不需要原子的读-改-写，也没有线程之间的cache line争抢；
+ * LockProfiler::snapshot()汇总所有线程的缓冲区，按总等待时间排序，排在前面的就是需要拆分或者缩短临界区的热点锁。
+ * 可以与HierarchicalMutex组合：HierarchicalMutex<ProfiledMutex<>> m(level, "site")。
+ */
+
+#ifndef SHAREDDATABETWEENTHREADS_PROFILED_MUTEX_HPP
+#define SHAREDDATABETWEENTHREADS_PROFILED_MUTEX_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace zhaocc {
+    /* 一个加锁点的汇总统计 */
+    struct LockSiteStats {
+        std::string site;
+        uint64_t acquisitions = 0; // 加锁次数
+        uint64_t contended = 0; // 需要等待的次数
+        uint64_t wait_ns = 0; // 总等待时间
+        uint64_t max_wait_ns = 0; // 单次最长等待时间
+        uint64_t hold_ns = 0; // 总持有时间
+    };
+
+    class LockProfiler {
+    public:
+        static constexpr size_t kMaxSites = 256; // 最多的加锁点数量
+
+    private:
+        /* 只被所属线程写入，汇总线程读取，使用relaxed原子变量避免数据竞争 */
+        struct SiteCounters {
+            std::atomic<uint64_t> acquisitions{0};
+            std::atomic<uint64_t> contended{0};
+            std::atomic<uint64_t> wait_ns{0};
+            std::atomic<uint64_t> max_wait_ns{0};
+            std::atomic<uint64_t> hold_ns{0};
+        };
+
+        struct alignas(64) ThreadBuffer {
+            std::array<SiteCounters, kMaxSites> sites;
+        };
+
+        std::mutex registry_mutex; // 保护site_names和buffers
+        std::vector<std::string> site_names;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers; // 线程退出后缓冲区仍然保留，统计不会丢失
+
+        LockProfiler() = default;
+
+        /* 只有所属线程写，load + store即可 */
+        static void add(std::atomic<uint64_t>& counter, uint64_t value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        ThreadBuffer& local_buffer() {
+            thread_local ThreadBuffer* buffer = nullptr;
+            if (buffer == nullptr) {
+                std::lock_guard<std::mutex> lock(registry_mutex);
+                buffers.push_back(std::make_unique<ThreadBuffer>());
+                buffer = buffers.back().get();
+            }
+            return *buffer;
+        }
+
+    public:
+        LockProfiler(const LockProfiler&) = delete;
+
+        LockProfiler& operator=(const LockProfiler&) = delete;
+
+        /* 全局唯一的统计器，使用局部静态变量实现线程安全的lazy-initialization */
+        static LockProfiler& instance() {
+            static LockProfiler profiler;
+            return profiler;
+        }
+
+        /**
+         * 注册加锁点，同名的加锁点返回同一个编号
+         * @return 加锁点编号
+         */
+        uint32_t register_site(const std::string& name) {
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            auto it = std::find(site_names.begin(), site_names.end(), name);
+            if (it != site_names.end()) {
+                return static_cast<uint32_t>(it - site_names.begin());
+            }
+            if (site_names.size() == kMaxSites) {
+                throw std::length_error("LockProfiler: too many lock sites");
+            }
+            site_names.push_back(name);
+            return static_cast<uint32_t>(site_names.size() - 1);
+        }
+
+        /* 记录一次加锁，wait_ns为阻塞等待的时间，没有等待时为0 */
+        void record_acquire(uint32_t site, bool contended, uint64_t wait_ns) {
+            SiteCounters& counters = local_buffer().sites[site];
+            add(counters.acquisitions, 1);
+            if (contended) {
+                add(counters.contended, 1);
+                add(counters.wait_ns, wait_ns);
+                if (wait_ns > counters.max_wait_ns.load(std::memory_order_relaxed)) {
+                    counters.max_wait_ns.store(wait_ns, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void record_hold(uint32_t site, uint64_t hold_ns) {
+            add(local_buffer().sites[site].hold_ns, hold_ns);
+        }
+
+        /**
+         * 汇总所有线程的统计
+         * @return 每个加锁点的统计，按总等待时间从大到小排序
+         */
+        std::vector<LockSiteStats> snapshot() {
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            std::vector<LockSiteStats> stats(site_names.size());
+            for (size_t i = 0; i < site_names.size(); i++) {
+                stats[i].site = site_names[i];
+                for (auto& buffer : buffers) {
+                    SiteCounters const& counters = buffer->sites[i];
+                    stats[i].acquisitions += counters.acquisitions.load(std::memory_order_relaxed);
+                    stats[i].contended += counters.contended.load(std::memory_order_relaxed);
+                    stats[i].wait_ns += counters.wait_ns.load(std::memory_order_relaxed);
+                    stats[i].max_wait_ns = std::max(stats[i].max_wait_ns,
+                                                    counters.max_wait_ns.load(std::memory_order_relaxed));
+                    stats[i].hold_ns += counters.hold_ns.load(std::memory_order_relaxed);
+                }
+            }
+            std::sort(stats.begin(), stats.end(), [](const LockSiteStats& a, const LockSiteStats& b) {
+                return a.wait_ns > b.wait_ns;
+            });
+            return stats;
+        }
+
+        /* 清零所有统计，应在没有线程加锁时调用，否则可能丢失并发的更新 */
+        void reset() {
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            for (auto& buffer : buffers) {
+                for (auto& counters : buffer->sites) {
+                    counters.acquisitions.store(0, std::memory_order_relaxed);
+                    counters.contended.store(0, std::memory_order_relaxed);
+                    counters.wait_ns.store(0, std::memory_order_relaxed);
+                    counters.max_wait_ns.store(0, std::memory_order_relaxed);
+                    counters.hold_ns.store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /* 打印统计表 */
+        void print(std::ostream& os) {
+            os << std::left << std::setw(24) << "lock site" << std::right << std::setw(12) << "acquire"
+               << std::setw(12) << "contended" << std::setw(14) << "wait(us)" << std::setw(14) << "max wait(us)"
+               << std::setw(14) << "hold(us)" << '\n';
+            for (auto const& s : snapshot()) {
+                os << std::left << std::setw(24) << s.site << std::right << std::setw(12) << s.acquisitions
+                   << std::setw(12) << s.contended << std::setw(14) << s.wait_ns / 1000 << std::setw(14)
+                   << s.max_wait_ns / 1000 << std::setw(14) << s.hold_ns / 1000 << '\n';
+            }
+        }
+    };
+
+    /**
+     * 记录竞争情况的互斥元，满足Lockable
+     * @tparam Mutex: 实际的互斥元
+     */
+    template<typename Mutex = std::mutex>
+    class ProfiledMutex {
+    private:
+        Mutex mutex;
+        uint32_t const site;
+        uint64_t acquired_ns = 0; // 加锁成功的时间，只被持有锁的线程访问
+
+        static uint64_t now_ns() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+    public:
+        /**
+         * 构造函数
+         * @param site_name: 加锁点的名字，同名的互斥元汇总在一起统计
+         */
+        explicit ProfiledMutex(const std::string& site_name)
+                : site(LockProfiler::instance().register_site(site_name)) {}
+
+        ProfiledMutex(const ProfiledMutex&) = delete;
+
+        ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+        void lock() {
+            if (mutex.try_lock()) { // 没有竞争时不计时
+                acquired_ns = now_ns();
+                LockProfiler::instance().record_acquire(site, false, 0);
+                return;
+            }
+            uint64_t const start = now_ns();
+            mutex.lock();
+            acquired_ns = now_ns();
+            LockProfiler::instance().record_acquire(site, true, acquired_ns - start);
+        }
+
+        bool try_lock() {
+            if (!mutex.try_lock()) {
+                return false;
+            }
+            acquired_ns = now_ns();
+            LockProfiler::instance().record_acquire(site, false, 0);
+            return true;
+        }
+
+        void unlock() {
+            LockProfiler::instance().record_hold(site, now_ns() - acquired_ns);
+            mutex.unlock();
+        }
+    };
+}
+
+#endif //SHAREDDATABETWEENTHREADS_PROFILED_MUTEX_HPP
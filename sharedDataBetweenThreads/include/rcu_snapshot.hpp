@@ -0,0 +1,120 @@
+/**
+ * RCU（read-copy-update）风格的快照容器，适用于读多写极少的数据，例如每小时才变化几次的配置。
+ * 读线程获取当前版本只需要进入epoch临界区并load一次指针，不加锁也不写共享数据；
+ * 写线程拷贝一份新版本修改后原子地发布，旧版本在所有可能还在读它的线程离开临界区（宽限期）后才释放。
+ */
+
+#ifndef SHAREDDATABETWEENTHREADS_RCU_SNAPSHOT_HPP
+#define SHAREDDATABETWEENTHREADS_RCU_SNAPSHOT_HPP
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "epoch_reclaimer.hpp"
+
+namespace zhaocc {
+    template<typename T>
+    class Snapshot {
+    private:
+        std::atomic<const T*> current; // 当前版本
+        std::mutex write_mutex; // 串行化写线程，读线程不使用
+
+        void publish_locked(std::unique_ptr<T> value) {
+            const T* old = current.exchange(value.release(), std::memory_order_acq_rel);
+            EpochDomain::instance().retire(const_cast<T*>(old)); // 可能还有读线程持有旧版本，延迟释放
+        }
+
+    public:
+        /* 读句柄，存活期间指向的版本不会被释放，不要长期持有，否则旧版本迟迟无法回收 */
+        class ReadPtr {
+        private:
+            EpochGuard guard; // 必须先于ptr初始化，保证load指针时已经在临界区中
+            const T* ptr;
+        public:
+            explicit ReadPtr(const std::atomic<const T*>& cur) : ptr(cur.load(std::memory_order_acquire)) {}
+
+            ReadPtr(const ReadPtr&) = delete;
+
+            ReadPtr& operator=(const ReadPtr&) = delete;
+
+            const T* operator->() const {
+                return ptr;
+            }
+
+            const T& operator*() const {
+                return *ptr;
+            }
+
+            const T* get() const {
+                return ptr;
+            }
+        };
+
+        template<typename... Args>
+        explicit Snapshot(Args&& ... args) : current(new T(std::forward<Args>(args)...)) {}
+
+        ~Snapshot() {
+            delete current.load(std::memory_order_acquire);
+        }
+
+        // 不允许拷贝
+        Snapshot(const Snapshot&) = delete;
+
+        Snapshot& operator=(const Snapshot&) = delete;
+
+        /**
+         * 获取当前版本
+         * @return 读句柄，可以像指针一样使用
+         */
+        ReadPtr read() const {
+            return ReadPtr(current);
+        }
+
+        /**
+         * 在读临界区中访问当前版本
+         * @param f: 可调用对象，参数为const T&
+         * @return f的返回值
+         */
+        template<typename F>
+        auto read(F&& f) const -> decltype(f(std::declval<const T&>())) {
+            EpochGuard guard;
+            return f(*current.load(std::memory_order_acquire));
+        }
+
+        /**
+         * 发布一个新版本，旧版本延迟释放
+         */
+        void publish(std::unique_ptr<T> value) {
+            std::lock_guard<std::mutex> lock(write_mutex);
+            publish_locked(std::move(value));
+        }
+
+        template<typename... Args>
+        void store(Args&& ... args) {
+            publish(std::unique_ptr<T>(new T(std::forward<Args>(args)...)));
+        }
+
+        /**
+         * read-copy-update：拷贝当前版本，交给f修改后发布。多个写线程之间串行执行，不会丢失彼此的修改
+         * @param f: 可调用对象，参数为T&
+         */
+        template<typename F>
+        void update(F&& f) {
+            std::lock_guard<std::mutex> lock(write_mutex);
+            std::unique_ptr<T> copy(new T(*current.load(std::memory_order_acquire)));
+            f(*copy);
+            publish_locked(std::move(copy));
+        }
+
+        /**
+         * 等待一个宽限期，返回时之前发布时被替换的旧版本都已经释放。不能在读临界区中调用
+         */
+        void synchronize() {
+            EpochDomain::instance().synchronize();
+        }
+    };
+}
+
+#endif //SHAREDDATABETWEENTHREADS_RCU_SNAPSHOT_HPP
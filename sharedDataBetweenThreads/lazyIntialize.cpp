@@ -1,6 +1,7 @@
 /**
  * 对于一些只需要在初始化时赋值的对象，之后再也不用更新，可以在进行初始化的时候进行保护，初始化动作很可能发生在用的时候（lazy-initialization），
  * 保护的方法包含“使用互斥元”，“二次检查锁定”（有数据竞争的风险，不推荐），“call-once”用法，“局部静态变量”（安全单例模式的实现）。
+ * 初始化之后仍会偶尔更新的读多写少数据见rcuSnapshot.cpp。
  */
 
 #include <iostream>
@@ -5,6 +5,8 @@
 #include <iostream>
 #include <mutex>
 
+#include "multi_lock.hpp"
+
 class BigData {
 public:
     int val;
@@ -39,6 +41,7 @@ public:
 
     friend void swap(X &l, X &r);
     friend void swap2(X &l, X &r);
+    friend void swap3(X &l, X &r);
 };
 
 // 使用lock + lock_guard锁定与释放
@@ -69,6 +72,12 @@ void swap2(X &l, X &r) {
     // lock_r.unlock();
 }
 
+// 使用MultiLock按地址顺序锁定，同一个实例只锁一次，锁更多互斥元时也一样（见multiLock.cpp）
+void swap3(X &l, X &r) {
+    zhaocc::MultiLock<std::mutex> lock(l.m, r.m);
+    swap_data(l.data, r.data);
+}
+
 int main() {
     X a(BigData(5));
     X b(BigData(4));
@@ -78,4 +87,6 @@ int main() {
     std::cout << a.data.val << ", " << b.data.val << std::endl;
     swap2(a, b);
     std::cout << a.data.val << ", " << b.data.val << std::endl;
+    swap3(a, b);
+    std::cout << a.data.val << ", " << b.data.val << std::endl;
 }
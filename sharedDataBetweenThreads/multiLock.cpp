@@ -0,0 +1,171 @@
+/**
+ * 在lockMultiMutex.cpp的基础上测试include/multi_lock.hpp和include/profiled_mutex.hpp：
+ * 多个线程在64个账户之间转账，每次用MultiLock锁定最多8个账户（其中一个是手续费账户），检查总金额不变且没有死锁；
+ * 层级检查能在阻塞之前发现错误的加锁顺序；最后打印每个加锁点的竞争统计，所有转账都要锁定的手续费账户排在最前面。
+ */
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <random>
+#include <functional>
+#include <utility>
+#include <cassert>
+
+#include "multi_lock.hpp"
+#include "profiled_mutex.hpp"
+
+using AccountMutex = zhaocc::HierarchicalMutex<zhaocc::ProfiledMutex<>>;
+
+constexpr unsigned kAccountLevel = 100;
+constexpr unsigned kLedgerLevel = 50; // 账本在账户之下，持有账户锁时可以记账
+
+struct Account {
+    AccountMutex m;
+    long long balance;
+
+    Account(const char* site, long long balance_) : m(kAccountLevel, site), balance(balance_) {}
+};
+
+void test_transfers() {
+    constexpr int kAccounts = 64;
+    constexpr int kThreads = 4;
+    constexpr int kTransfers = 20000;
+    constexpr long long kInitial = 1000000;
+    std::vector<std::unique_ptr<Account>> accounts;
+    for (int i = 0; i < kAccounts; i++) {
+        accounts.push_back(std::make_unique<Account>(i == 0 ? "fee_account" : "account", kInitial));
+    }
+    zhaocc::HierarchicalMutex<zhaocc::ProfiledMutex<>> ledger_mutex(kLedgerLevel, "ledger");
+    long long ledger_entries = 0;
+
+    zhaocc::LockProfiler::instance().reset();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&, t]() {
+            std::mt19937 rng(t);
+            std::uniform_int_distribution<int> pick(1, kAccounts - 1); // 0号是手续费账户
+            for (int i = 0; i < kTransfers; i++) {
+                // 一个付款账户分给多个收款账户，手续费账户收取1，账户可能重复
+                std::vector<Account*> parties{accounts[0].get()};
+                for (int k = 0; k < 7; k++) {
+                    parties.push_back(accounts[pick(rng)].get());
+                }
+                std::vector<AccountMutex*> mutexes;
+                for (Account* a : parties) {
+                    mutexes.push_back(&a->m);
+                }
+                zhaocc::MultiLock<AccountMutex> lock(mutexes.begin(), mutexes.end()); // 不需要关心参数顺序
+                Account* payer = parties[1];
+                for (size_t k = 2; k < parties.size(); k++) {
+                    payer->balance -= 10;
+                    parties[k]->balance += 10;
+                }
+                payer->balance -= 1;
+                parties[0]->balance += 1;
+
+                std::lock_guard<AccountMutex> ledger(ledger_mutex); // 层级更低，允许
+                ledger_entries++;
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    long long total = 0;
+    for (auto& a : accounts) {
+        total += a->balance;
+    }
+    assert(total == kAccounts * kInitial && ledger_entries == kThreads * kTransfers);
+    assert(accounts[0]->balance == kInitial + kThreads * kTransfers);
+
+    std::vector<zhaocc::LockSiteStats> const stats = zhaocc::LockProfiler::instance().snapshot();
+    for (auto const& s : stats) {
+        if (s.site == "fee_account" || s.site == "ledger") {
+            assert(s.acquisitions == static_cast<uint64_t>(kThreads * kTransfers)); // 每次转账锁一次
+        }
+    }
+    zhaocc::LockProfiler::instance().print(std::cout);
+}
+
+void test_hierarchy() {
+    if constexpr (!zhaocc::LockHierarchy::kEnabled) {
+        return;
+    }
+    AccountMutex account(kAccountLevel, "hierarchy_account");
+    AccountMutex ledger(kLedgerLevel, "hierarchy_ledger");
+    [[maybe_unused]] bool caught = false;
+    {
+        std::lock_guard<AccountMutex> l(ledger);
+        try {
+            std::lock_guard<AccountMutex> a(account); // 持有低层级的锁时加高层级的锁
+        } catch (const zhaocc::LockOrderViolation& ex) {
+            caught = true;
+            std::cout << ex.what() << std::endl;
+        }
+    }
+    assert(caught);
+
+    // 同一层级的锁只能按地址从小到大锁定，MultiLock会自动排序
+    AccountMutex first(kAccountLevel, "hierarchy_account");
+    AccountMutex second(kAccountLevel, "hierarchy_account");
+    AccountMutex& low = std::less<AccountMutex*>()(&first, &second) ? first : second;
+    AccountMutex& high = &low == &first ? second : first;
+    {
+        zhaocc::MultiLock<AccountMutex> lock(high, low, high); // 重复的只锁一次
+        assert(lock.size() == 2);
+    }
+    caught = false;
+    {
+        std::lock_guard<AccountMutex> h(high);
+        try {
+            std::lock_guard<AccountMutex> l(low);
+        } catch (const zhaocc::LockOrderViolation&) {
+            caught = true;
+        }
+    }
+    assert(caught);
+
+    // MultiLock加锁失败时不会留下已经锁定的互斥元
+    caught = false;
+    {
+        std::lock_guard<AccountMutex> l(ledger);
+        try {
+            zhaocc::MultiLock<AccountMutex> lock(first, second);
+        } catch (const zhaocc::LockOrderViolation&) {
+            caught = true;
+        }
+    }
+    assert(caught && first.try_lock() && second.try_lock());
+    first.unlock();
+    second.unlock();
+}
+
+/* 普通互斥元按地址顺序锁定，改写lockMultiMutex.cpp中的swap */
+void test_plain_mutexes() {
+    std::mutex a;
+    std::mutex b;
+    int x = 5;
+    int y = 4;
+    std::thread t([&]() {
+        for (int i = 0; i < 10000; i++) {
+            zhaocc::MultiLock<std::mutex> lock(a, b);
+            std::swap(x, y);
+        }
+    });
+    for (int i = 0; i < 10000; i++) {
+        zhaocc::MultiLock<std::mutex> lock(b, a); // 参数顺序相反也不会死锁
+        std::swap(x, y);
+    }
+    t.join();
+    assert(x + y == 9);
+}
+
+int main() {
+    test_hierarchy();
+    test_plain_mutexes();
+    test_transfers();
+}
@@ -0,0 +1,121 @@
+/**
+ * lazyIntialize.cpp中的数据只初始化一次，之后不再改变。对于会偶尔更新、但被频繁读取的数据（例如配置），
+ * 使用RCU风格的Snapshot：读线程几乎只有一次指针解引用的开销，写线程拷贝-修改-发布，旧版本在宽限期后释放。
+ * 这里与每次读取都持有共享锁的方式做对比。
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cassert>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/shared_lock_guard.hpp>
+
+#include "rcu_snapshot.hpp"
+
+/* 读多写少的配置，不变式：timeout_ms == endpoints.size() * 100 */
+struct Config {
+    int version;
+    int timeout_ms;
+    std::vector<std::string> endpoints;
+};
+
+/* 使用共享锁保护的配置，作为对比 */
+class SharedMutexConfig {
+private:
+    Config config;
+    mutable boost::shared_mutex m;
+public:
+    explicit SharedMutexConfig(Config config_) : config(std::move(config_)) {}
+
+    int timeout_ms() const {
+        boost::shared_lock_guard<boost::shared_mutex> lock(m);
+        return config.timeout_ms;
+    }
+
+    void update(Config new_config) {
+        std::lock_guard<boost::shared_mutex> lock(m);
+        config = std::move(new_config);
+    }
+};
+
+template<typename ReadFunc>
+double bench_reads(ReadFunc read_func, unsigned reader_count, std::chrono::milliseconds duration) {
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> reads(0);
+    std::vector<std::thread> readers;
+    for (unsigned i = 0; i < reader_count; i++) {
+        readers.emplace_back([&]() {
+            uint64_t local = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                assert(read_func() > 0);
+                local++;
+            }
+            reads.fetch_add(local);
+        });
+    }
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto& th : readers) {
+        th.join();
+    }
+    return reads.load() * 1000.0 / duration.count();
+}
+
+int main() {
+    zhaocc::Snapshot<Config> config(Config{1, 100, {"10.0.0.1"}});
+
+    // 读者持有的快照在其存活期间不变，即使写者发布了新版本
+    {
+        auto snapshot = config.read();
+        config.update([](Config& c) {
+            c.version++;
+            c.endpoints.emplace_back("10.0.0.2");
+            c.timeout_ms = static_cast<int>(c.endpoints.size()) * 100;
+        });
+        assert(snapshot->version == 1 && snapshot->endpoints.size() == 1);
+        std::cout << "old snapshot version: " << snapshot->version << std::endl;
+    }
+    std::cout << "new snapshot version: " << config.read()->version << std::endl;
+
+    // 读线程不断检查不变式，写线程不断发布新版本
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++) {
+        readers.emplace_back([&]() {
+            int last_version = 0;
+            while (!stop.load()) {
+                config.read([&](const Config& c) {
+                    assert(c.timeout_ms == static_cast<int>(c.endpoints.size()) * 100);
+                    assert(c.version >= last_version); // 版本单调递增
+                    last_version = c.version;
+                });
+            }
+        });
+    }
+    for (int i = 0; i < 1000; i++) {
+        config.update([i](Config& c) {
+            c.version++;
+            c.endpoints.resize(i % 10 + 1, "10.0.0.3");
+            c.timeout_ms = static_cast<int>(c.endpoints.size()) * 100;
+        });
+    }
+    stop = true;
+    for (auto& th : readers) {
+        th.join();
+    }
+    config.synchronize(); // 等待宽限期，所有被替换的版本都已释放
+    std::cout << "final version: " << config.read()->version << std::endl;
+
+    unsigned const reader_count = std::max(2u, std::thread::hardware_concurrency());
+    SharedMutexConfig shared_mutex_config(Config{1, 100, {"10.0.0.1"}});
+    std::cout << "shared_mutex reads/s: "
+              << bench_reads([&]() { return shared_mutex_config.timeout_ms(); }, reader_count,
+                             std::chrono::milliseconds(1000)) << std::endl;
+    std::cout << "rcu snapshot reads/s: "
+              << bench_reads([&]() { return config.read()->timeout_ms; }, reader_count,
+                             std::chrono::milliseconds(1000)) << std::endl;
+}
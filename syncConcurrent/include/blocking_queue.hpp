@@ -0,0 +1,168 @@
+/**
+ * 通过条件变量实现一个线程安全的队列（一把锁保护整个std::deque，pop在队列为空时阻塞等待）。
+ * 与threadPool中细粒度锁的zhaocc::ThreadSafeQueue区分，命名为BlockingQueue。
+ * 入队出队都使用移动，支持只能移动的类型；emplace在锁内直接构造元素；drain_into在一次加锁中把整个内部deque换出来，
+ * 消费者按批处理时每批只需要加锁一次。notify_one在解锁之后调用，被唤醒的线程不会立刻阻塞在还没释放的锁上。
+ */
+
+#ifndef SYNCCONCURRENT_BLOCKING_QUEUE_HPP
+#define SYNCCONCURRENT_BLOCKING_QUEUE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace zhaocc {
+    template<class T>
+    class BlockingQueue {
+    private:
+        std::deque<T> data_queue;
+        mutable std::mutex queue_mutex; // 队列互斥元，mutable代表永久可变
+        std::condition_variable queue_cond; // 队列条件变量
+
+        /* 换出的元素追加到out，out为空的std::deque<T>时直接交换 */
+        template<typename Container>
+        static size_t append(std::deque<T>& drained, Container& out) {
+            size_t const count = drained.size();
+            if constexpr (std::is_same_v<Container, std::deque<T>>) {
+                if (out.empty()) {
+                    out.swap(drained);
+                    return count;
+                }
+            }
+            std::move(drained.begin(), drained.end(), std::back_inserter(out));
+            return count;
+        }
+
+    public:
+        BlockingQueue() {}
+
+        BlockingQueue(const BlockingQueue& other) {
+            std::lock_guard<std::mutex> lock(other.queue_mutex); // 锁定被拷贝对象的数据队列
+            data_queue = other.data_queue;
+        }
+
+        /* 返回队列是否为空，const表示该函数无法修改任何对象的属性，queue_mutex用mutable描述，代表它可变。 */
+        bool empty() const {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            return data_queue.empty();
+        }
+
+        size_t size() const {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            return data_queue.size();
+        }
+
+        /* 队尾增加元素，左值拷贝一次，右值不拷贝 */
+        void push(T new_val) {
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex);
+                data_queue.push_back(std::move(new_val));
+            }
+            queue_cond.notify_one(); // 解锁后再唤醒一个线程
+        }
+
+        /* 在队尾直接构造元素 */
+        template<typename... Args>
+        void emplace(Args&& ... args) {
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex);
+                data_queue.emplace_back(std::forward<Args>(args)...);
+            }
+            queue_cond.notify_one();
+        }
+
+        /* 使用引用方式获取队头的元素，如果队头无元素则阻塞等待 */
+        void pop(T& new_val) {
+            std::unique_lock<std::mutex> lock(queue_mutex); // 这里锁定不能使用lock_guard，因为lock_guard锁定后无法灵活的解锁，只能析构时解锁
+            queue_cond.wait(lock, [this]() { return !data_queue.empty(); }); // 锁会在wait过程中解锁，一直等到lambda表达式成立
+            new_val = std::move(data_queue.front());
+            data_queue.pop_front();
+        }
+
+        /* 使用智能指针获取对头的元素，如果队头无元素则阻塞等待 */
+        std::shared_ptr<T> pop() {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_cond.wait(lock, [this]() { return !data_queue.empty(); });
+            T value(std::move(data_queue.front()));
+            data_queue.pop_front();
+            lock.unlock();
+            return std::make_shared<T>(std::move(value)); // 在锁外分配内存
+        }
+
+        /**
+         * 使用引用方式获取队头的元素，如果队头无元素则最多等待timeout
+         * @return 是否取到元素
+         */
+        template<typename Rep, typename Period>
+        bool pop_for(T& new_val, const std::chrono::duration<Rep, Period>& timeout) {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            if (!queue_cond.wait_for(lock, timeout, [this]() { return !data_queue.empty(); })) {
+                return false;
+            }
+            new_val = std::move(data_queue.front());
+            data_queue.pop_front();
+            return true;
+        }
+
+        /* 使用引用方式获取队头的元素，如果队头无元素则立即返回 */
+        bool try_pop(T& new_val) {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            if (data_queue.empty()) {
+                return false;
+            }
+            new_val = std::move(data_queue.front());
+            data_queue.pop_front();
+            return true;
+        }
+
+        /* 使用智能指针获取对头的元素，如果队头无元素则立即返回 */
+        std::shared_ptr<T> try_pop() {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            if (data_queue.empty()) {
+                return std::shared_ptr<T>();
+            }
+            T value(std::move(data_queue.front()));
+            data_queue.pop_front();
+            lock.unlock();
+            return std::make_shared<T>(std::move(value));
+        }
+
+        /**
+         * 一次加锁取出队列中所有元素，按入队顺序追加到out（out为空的std::deque<T>时直接交换，不移动元素），不阻塞
+         * @return 取出的元素数量
+         */
+        template<typename Container>
+        size_t drain_into(Container& out) {
+            std::deque<T> drained;
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex);
+                drained.swap(data_queue);
+            }
+            return append(drained, out);
+        }
+
+        /**
+         * 与drain_into相同，但队列为空时阻塞等待到至少有一个元素
+         * @return 取出的元素数量
+         */
+        template<typename Container>
+        size_t wait_drain_into(Container& out) {
+            std::deque<T> drained;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                queue_cond.wait(lock, [this]() { return !data_queue.empty(); });
+                drained.swap(data_queue);
+            }
+            return append(drained, out);
+        }
+    };
+}
+
+#endif //SYNCCONCURRENT_BLOCKING_QUEUE_HPP
@@ -0,0 +1,197 @@
+/**
+ * 串行执行器：一个专用线程按提交顺序执行任务，用于packagedTask.cpp中gui线程那样独占非线程安全状态的单线程事件循环。
+ * 1. 任务队列是侵入式的MPSC队列（Vyukov），任务节点自带next指针，post只需要一次atomic exchange，不加锁。
+ * 2. 执行线程每次醒来把队列中已有的任务全部执行完（批量执行），队列为空时通过atomic::wait阻塞（park），不会忙等；
+ *    生产者只有在执行线程已经park时才需要一次exchange + notify唤醒它。
+ * 3. post提交不需要结果的任务，submit返回std::future。
+ * 析构时执行完已经提交的任务再退出，不能在执行线程中析构，也不能在析构之后提交任务。
+ */
+
+#ifndef SYNCCONCURRENT_SERIAL_EXECUTOR_HPP
+#define SYNCCONCURRENT_SERIAL_EXECUTOR_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "cpu_relax.hpp"
+
+namespace zhaocc {
+    class SerialExecutor {
+    private:
+        /* 侵入式队列节点，任务本身就是节点 */
+        struct TaskNode {
+            std::atomic<TaskNode*> next{nullptr};
+
+            virtual ~TaskNode() = default;
+
+            virtual void run() {}
+        };
+
+        template<typename F>
+        struct FuncNode : TaskNode {
+            F func;
+
+            explicit FuncNode(F&& f) : func(std::move(f)) {}
+
+            void run() override {
+                func();
+            }
+        };
+
+        alignas(64) std::atomic<TaskNode*> tail; // 生产者exchange的位置
+        alignas(64) TaskNode* head; // 只被执行线程访问
+        TaskNode stub; // 占位节点，队列为空时head和tail都指向它
+        uint64_t batches = 0; // 执行线程醒来执行任务的批次数，只被执行线程修改
+
+        alignas(64) std::atomic<uint32_t> sleeping{0}; // 1表示执行线程已经park
+        std::atomic<bool> stopping{false};
+        std::thread thread;
+
+        void push(TaskNode* node); // 生产者入队
+        TaskNode* pop(); // 执行线程出队，没有可取的任务时返回nullptr（队列为空或者生产者正在链接节点）
+        void wake(); // 执行线程已经park时唤醒它
+        void park(); // 队列为空时阻塞执行线程
+        void run_loop(); // 执行线程
+
+    public:
+        SerialExecutor() : tail(&stub), head(&stub), thread(&SerialExecutor::run_loop, this) {}
+
+        ~SerialExecutor();
+
+        SerialExecutor(const SerialExecutor&) = delete;
+
+        SerialExecutor& operator=(const SerialExecutor&) = delete;
+
+        /**
+         * 提交任务，不关心结果，任务不应抛出异常（需要异常时使用submit）
+         * @tparam FuncType: 函数类型
+         * @param f: 任务
+         */
+        template<typename FuncType>
+        void post(FuncType f) {
+            push(new FuncNode<FuncType>(std::move(f)));
+        }
+
+        /**
+         * 提交任务
+         * @tparam FuncType: 函数类型
+         * @param f: 任务
+         * @return future
+         */
+        template<typename FuncType>
+        std::future<std::invoke_result_t<FuncType>> submit(FuncType f) {
+            using result_type = std::invoke_result_t<FuncType>;
+            std::packaged_task<result_type()> task(std::move(f));
+            std::future<result_type> res(task.get_future());
+            post(std::move(task));
+            return res;
+        }
+
+        /* 当前线程是否是执行线程，用于检查独占状态只在执行线程上访问 */
+        bool running_in_this_thread() const {
+            return std::this_thread::get_id() == thread.get_id();
+        }
+
+        /* 执行线程醒来执行任务的批次数，只能在执行线程上调用 */
+        uint64_t batch_count() const {
+            return batches;
+        }
+    };
+
+    inline SerialExecutor::~SerialExecutor() {
+        stopping.store(true, std::memory_order_seq_cst);
+        wake();
+        thread.join();
+    }
+
+    inline void SerialExecutor::push(TaskNode* node) {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        TaskNode* prev = tail.exchange(node, std::memory_order_seq_cst); // 与park中的sleeping形成Dekker同步，不会错过唤醒
+        prev->next.store(node, std::memory_order_release); // exchange与这里之间执行线程看到的是"正在链接"
+        if (sleeping.load(std::memory_order_seq_cst) != 0) {
+            wake();
+        }
+    }
+
+    inline SerialExecutor::TaskNode* SerialExecutor::pop() {
+        TaskNode* h = head;
+        TaskNode* next = h->next.load(std::memory_order_acquire);
+        if (h == &stub) { // 跳过占位节点
+            if (next == nullptr) {
+                return nullptr;
+            }
+            head = next;
+            h = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next != nullptr) {
+            head = next;
+            return h;
+        }
+        if (h != tail.load(std::memory_order_acquire)) { // h后面还有节点正在链接
+            return nullptr;
+        }
+        push(&stub); // h是最后一个节点，放回占位节点后才能取出h
+        next = h->next.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            head = next;
+            return h;
+        }
+        return nullptr;
+    }
+
+    inline void SerialExecutor::wake() {
+        if (sleeping.exchange(0, std::memory_order_seq_cst) != 0) {
+#ifdef __cpp_lib_atomic_wait
+            sleeping.notify_one();
+#endif
+        }
+    }
+
+    inline void SerialExecutor::park() {
+        sleeping.store(1, std::memory_order_seq_cst);
+        // 置park标志后再检查一次，生产者要么在这里被看到，要么看到sleeping为1后唤醒
+        if (tail.load(std::memory_order_seq_cst) != &stub || stopping.load(std::memory_order_seq_cst)) {
+            sleeping.store(0, std::memory_order_relaxed);
+            return;
+        }
+#ifdef __cpp_lib_atomic_wait
+        sleeping.wait(1, std::memory_order_acquire);
+#else
+        while (sleeping.load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+#endif
+    }
+
+    inline void SerialExecutor::run_loop() {
+        bool running = false; // 本批次是否执行过任务
+        while (true) {
+            TaskNode* node = pop();
+            if (node != nullptr) {
+                if (!running) {
+                    running = true;
+                    batches++;
+                }
+                node->run();
+                delete node;
+                continue;
+            }
+            if (tail.load(std::memory_order_acquire) != &stub) { // 生产者正在链接节点，很快完成
+                cpu_relax();
+                continue;
+            }
+            running = false;
+            if (stopping.load(std::memory_order_acquire)) { // 队列已经执行完
+                break;
+            }
+            park();
+        }
+    }
+}
+
+#endif //SYNCCONCURRENT_SERIAL_EXECUTOR_HPP
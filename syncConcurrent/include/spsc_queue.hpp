@@ -0,0 +1,339 @@
+/**
+ * 单生产者单消费者（SPSC）的无锁有界环形队列，用于两个固定线程之间的流水线。
+ * 生产者只写tail，消费者只写head，两者位于不同的cache line；双方各自缓存对方的下标，只有缓存显示队列满/空时才去读取对方的cache line。
+ * 支持批量入队出队（一批只发布一次下标），Blocking为true时支持基于atomic::wait的阻塞push/pop，为false时没有任何额外开销。
+ */
+
+#ifndef SYNCCONCURRENT_SPSC_QUEUE_HPP
+#define SYNCCONCURRENT_SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <thread>
+#include <utility>
+
+#include "cpu_relax.hpp"
+
+namespace zhaocc {
+    template<typename T, bool Blocking = false>
+    class SpscQueue {
+    private:
+        static constexpr int kSpinCount = 128; // 阻塞前自旋的次数
+
+        size_t const capacity;
+        size_t const mask;
+        T* const slots; // 未初始化的存储
+
+        alignas(64) std::atomic<size_t> tail; // 下一个写入位置，只被生产者修改
+        size_t head_cache; // 生产者缓存的head
+
+        alignas(64) std::atomic<size_t> head; // 下一个读取位置，只被消费者修改
+        size_t tail_cache; // 消费者缓存的tail
+
+        alignas(64) std::atomic<bool> consumer_waiting; // 消费者是否在等待数据
+        std::atomic<bool> producer_waiting; // 生产者是否在等待空位
+
+        static size_t round_up_pow2(size_t n) {
+            size_t res = 1;
+            while (res < n) {
+                res <<= 1;
+            }
+            return res;
+        }
+
+        size_t free_slots(size_t t); // 生产者可写入的数量
+        size_t ready_slots(size_t h); // 消费者可读取的数量
+        void publish_tail(size_t t); // 生产者发布新的tail
+        void publish_head(size_t h); // 消费者发布新的head
+        void wait_for_change(std::atomic<size_t>& index, size_t old, std::atomic<bool>& waiting); // 阻塞等待index变化
+        template<typename InputIt>
+        size_t push_some(InputIt& first, size_t count); // 批量入队并把first推进到下一个未入队的元素
+
+    public:
+        /**
+         * 构造函数
+         * @param capacity: 队列容量，会向上取整为2的幂
+         */
+        explicit SpscQueue(size_t capacity);
+
+        ~SpscQueue();
+
+        // 不允许拷贝
+        SpscQueue(const SpscQueue&) = delete;
+
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        /**
+         * 尝试原地构造一个元素，只能被生产者线程调用
+         * @return 队列满时返回false
+         */
+        template<typename... Args>
+        bool try_emplace(Args&& ... args);
+
+        bool try_push(T value) {
+            return try_emplace(std::move(value));
+        }
+
+        /**
+         * 批量入队，只发布一次tail
+         * @param first: 输入迭代器，元素会被move
+         * @param count: 期望入队的数量
+         * @return 实际入队的数量
+         */
+        template<typename InputIt>
+        size_t try_push_bulk(InputIt first, size_t count);
+
+        /**
+         * 尝试出队，只能被消费者线程调用
+         * @return 队列空时返回false
+         */
+        bool try_pop(T& value);
+
+        /**
+         * 批量出队，只发布一次head
+         * @param out: 输出迭代器
+         * @param max_count: 最多出队的数量
+         * @return 实际出队的数量
+         */
+        template<typename OutputIt>
+        size_t try_pop_bulk(OutputIt out, size_t max_count);
+
+        /**
+         * 阻塞入队，队列满时先自旋再阻塞，只有Blocking为true时可用
+         */
+        void push(T value);
+
+        /**
+         * 阻塞批量入队，直到所有元素都入队。first只向前读取一遍，可以是istream_iterator这样的单遍输入迭代器
+         */
+        template<typename InputIt>
+        void push_bulk(InputIt first, size_t count);
+
+        /**
+         * 阻塞出队，队列空时先自旋再阻塞，只有Blocking为true时可用
+         */
+        void pop(T& value);
+
+        /**
+         * 阻塞批量出队，至少出队一个元素
+         */
+        template<typename OutputIt>
+        size_t pop_bulk(OutputIt out, size_t max_count);
+
+        /* 近似的元素数量 */
+        size_t size() const {
+            return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+    };
+
+    template<typename T, bool Blocking>
+    SpscQueue<T, Blocking>::SpscQueue(size_t capacity_)
+            : capacity(round_up_pow2(capacity_)), mask(capacity - 1),
+              slots(static_cast<T*>(::operator new(sizeof(T) * capacity))),
+              tail(0), head_cache(0), head(0), tail_cache(0), consumer_waiting(false), producer_waiting(false) {}
+
+    template<typename T, bool Blocking>
+    SpscQueue<T, Blocking>::~SpscQueue() {
+        size_t const t = tail.load(std::memory_order_relaxed);
+        for (size_t h = head.load(std::memory_order_relaxed); h != t; h++) {
+            slots[h & mask].~T();
+        }
+        ::operator delete(slots);
+    }
+
+    template<typename T, bool Blocking>
+    size_t SpscQueue<T, Blocking>::free_slots(size_t t) {
+        size_t free = capacity - (t - head_cache);
+        if (free == 0) { // 缓存显示队列已满，才去读取消费者的cache line
+            head_cache = head.load(std::memory_order_acquire);
+            free = capacity - (t - head_cache);
+        }
+        return free;
+    }
+
+    template<typename T, bool Blocking>
+    size_t SpscQueue<T, Blocking>::ready_slots(size_t h) {
+        size_t ready = tail_cache - h;
+        if (ready == 0) { // 缓存显示队列为空，才去读取生产者的cache line
+            tail_cache = tail.load(std::memory_order_acquire);
+            ready = tail_cache - h;
+        }
+        return ready;
+    }
+
+    template<typename T, bool Blocking>
+    void SpscQueue<T, Blocking>::publish_tail(size_t t) {
+        tail.store(t, std::memory_order_release); // 元素的构造先于tail的发布
+        if (Blocking) {
+            std::atomic_thread_fence(std::memory_order_seq_cst); // 与消费者“先置等待标志再检查tail”构成Dekker同步
+            if (consumer_waiting.load(std::memory_order_relaxed)) {
+#ifdef __cpp_lib_atomic_wait
+                tail.notify_one();
+#endif
+            }
+        }
+    }
+
+    template<typename T, bool Blocking>
+    void SpscQueue<T, Blocking>::publish_head(size_t h) {
+        head.store(h, std::memory_order_release); // 元素的析构先于head的发布
+        if (Blocking) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (producer_waiting.load(std::memory_order_relaxed)) {
+#ifdef __cpp_lib_atomic_wait
+                head.notify_one();
+#endif
+            }
+        }
+    }
+
+    template<typename T, bool Blocking>
+    void SpscQueue<T, Blocking>::wait_for_change(std::atomic<size_t>& index, size_t old,
+                                                 std::atomic<bool>& waiting) {
+        waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst); // 先置等待标志，再检查下标，防止错过唤醒
+#ifdef __cpp_lib_atomic_wait
+        index.wait(old, std::memory_order_acquire);
+#else
+        while (index.load(std::memory_order_acquire) == old) {
+            std::this_thread::yield();
+        }
+#endif
+        waiting.store(false, std::memory_order_relaxed);
+    }
+
+    template<typename T, bool Blocking>
+    template<typename... Args>
+    bool SpscQueue<T, Blocking>::try_emplace(Args&& ... args) {
+        size_t const t = tail.load(std::memory_order_relaxed);
+        if (free_slots(t) == 0) {
+            return false;
+        }
+        new(&slots[t & mask]) T(std::forward<Args>(args)...);
+        publish_tail(t + 1);
+        return true;
+    }
+
+    template<typename T, bool Blocking>
+    template<typename InputIt>
+    size_t SpscQueue<T, Blocking>::try_push_bulk(InputIt first, size_t count) {
+        return push_some(first, count);
+    }
+
+    template<typename T, bool Blocking>
+    template<typename InputIt>
+    size_t SpscQueue<T, Blocking>::push_some(InputIt& first, size_t count) {
+        size_t const t = tail.load(std::memory_order_relaxed);
+        size_t free = free_slots(t);
+        size_t const n = count < free ? count : free;
+        for (size_t i = 0; i < n; i++, ++first) {
+            new(&slots[(t + i) & mask]) T(std::move(*first));
+        }
+        if (n > 0) {
+            publish_tail(t + n);
+        }
+        return n;
+    }
+
+    template<typename T, bool Blocking>
+    bool SpscQueue<T, Blocking>::try_pop(T& value) {
+        size_t const h = head.load(std::memory_order_relaxed);
+        if (ready_slots(h) == 0) {
+            return false;
+        }
+        T& slot = slots[h & mask];
+        value = std::move(slot);
+        slot.~T();
+        publish_head(h + 1);
+        return true;
+    }
+
+    template<typename T, bool Blocking>
+    template<typename OutputIt>
+    size_t SpscQueue<T, Blocking>::try_pop_bulk(OutputIt out, size_t max_count) {
+        size_t const h = head.load(std::memory_order_relaxed);
+        size_t ready = ready_slots(h);
+        size_t const n = max_count < ready ? max_count : ready;
+        for (size_t i = 0; i < n; i++) {
+            T& slot = slots[(h + i) & mask];
+            *out++ = std::move(slot);
+            slot.~T();
+        }
+        if (n > 0) {
+            publish_head(h + n);
+        }
+        return n;
+    }
+
+    template<typename T, bool Blocking>
+    void SpscQueue<T, Blocking>::push(T value) {
+        static_assert(Blocking, "push() requires SpscQueue<T, true>");
+        for (int spin = 0; !try_emplace(std::move(value)); spin++) { // 失败时value不会被move
+            if (spin < kSpinCount) {
+                cpu_relax();
+                continue;
+            }
+            size_t const h = head.load(std::memory_order_relaxed);
+            if (tail.load(std::memory_order_relaxed) - h == capacity) {
+                wait_for_change(head, h, producer_waiting);
+            }
+        }
+    }
+
+    template<typename T, bool Blocking>
+    template<typename InputIt>
+    void SpscQueue<T, Blocking>::push_bulk(InputIt first, size_t count) {
+        static_assert(Blocking, "push_bulk() requires SpscQueue<T, true>");
+        for (int spin = 0; count > 0; spin++) {
+            size_t const n = push_some(first, count); // 直接推进first，不再用副本重复推进
+            if (n > 0) {
+                count -= n;
+                spin = 0;
+                continue;
+            }
+            if (spin < kSpinCount) {
+                cpu_relax();
+                continue;
+            }
+            size_t const h = head.load(std::memory_order_relaxed);
+            if (tail.load(std::memory_order_relaxed) - h == capacity) {
+                wait_for_change(head, h, producer_waiting);
+            }
+        }
+    }
+
+    template<typename T, bool Blocking>
+    void SpscQueue<T, Blocking>::pop(T& value) {
+        static_assert(Blocking, "pop() requires SpscQueue<T, true>");
+        for (int spin = 0; !try_pop(value); spin++) {
+            if (spin < kSpinCount) {
+                cpu_relax();
+                continue;
+            }
+            wait_for_change(tail, head.load(std::memory_order_relaxed), consumer_waiting);
+        }
+    }
+
+    template<typename T, bool Blocking>
+    template<typename OutputIt>
+    size_t SpscQueue<T, Blocking>::pop_bulk(OutputIt out, size_t max_count) {
+        static_assert(Blocking, "pop_bulk() requires SpscQueue<T, true>");
+        size_t n = 0;
+        for (int spin = 0; (n = try_pop_bulk(out, max_count)) == 0; spin++) {
+            if (spin < kSpinCount) {
+                cpu_relax();
+                continue;
+            }
+            wait_for_change(tail, head.load(std::memory_order_relaxed), consumer_waiting);
+        }
+        return n;
+    }
+}
+
+#endif //SYNCCONCURRENT_SPSC_QUEUE_HPP
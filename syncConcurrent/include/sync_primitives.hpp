@@ -0,0 +1,251 @@
+/**
+ * 基于std::atomic::wait/notify_all的同步原语：Latch、可重复使用的Barrier（带完成函数）、一次性的Event和ManualResetEvent。
+ * 状态都是一个32位的原子变量，Linux上atomic::wait直接使用futex，notify_all一次系统调用唤醒所有等待者，
+ * 不像condition_variable那样每个被唤醒的线程都要依次抢同一把互斥锁（mutex convoy）；等待前先自旋kSpinCount次，短等待不进入内核。
+ * 每个等待函数都有一个接收线程池的重载，等待期间通过pool.run_pending_task()帮助执行任务，
+ * 在线程池的工作线程中等待不会占住工作线程导致死锁。
+ */
+
+#ifndef SYNCCONCURRENT_SYNC_PRIMITIVES_HPP
+#define SYNCCONCURRENT_SYNC_PRIMITIVES_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+
+#include "cpu_relax.hpp"
+
+namespace zhaocc {
+    namespace sync_detail {
+        constexpr int kSpinCount = 128; // 阻塞前自旋的次数
+
+        /* 等待到done(value)成立：先自旋，再阻塞在atomic::wait上 */
+        template<typename T, typename Pred>
+        void spin_wait(const std::atomic<T>& value, Pred done) {
+            for (int spin = 0; spin < kSpinCount; spin++) {
+                if (done(value.load(std::memory_order_acquire))) {
+                    return;
+                }
+                cpu_relax();
+            }
+            T current = value.load(std::memory_order_acquire);
+            while (!done(current)) {
+#ifdef __cpp_lib_atomic_wait
+                value.wait(current, std::memory_order_acquire); // 值不等于current时立即返回，不会错过唤醒
+#else
+                std::this_thread::yield();
+#endif
+                current = value.load(std::memory_order_acquire);
+            }
+        }
+
+        /* 等待到done(value)成立，期间帮助线程池执行任务 */
+        template<typename T, typename Pred, typename Pool>
+        void help_wait(const std::atomic<T>& value, Pred done, Pool& pool) {
+            while (!done(value.load(std::memory_order_acquire))) {
+                pool.run_pending_task(); // 没有任务时run_pending_task会让出CPU
+            }
+        }
+
+        template<typename T>
+        void notify_all(std::atomic<T>& value) {
+#ifdef __cpp_lib_atomic_wait
+            value.notify_all();
+#else
+            (void) value;
+#endif
+        }
+    }
+
+    /**
+     * 一次性的倒计数器，与std::latch相同：计数减到0后所有等待者返回，之后不能重置
+     */
+    class Latch {
+    private:
+        std::atomic<int32_t> count;
+
+    public:
+        explicit Latch(int32_t expected) : count(expected) {}
+
+        Latch(const Latch&) = delete;
+
+        Latch& operator=(const Latch&) = delete;
+
+        /* 计数减n，减到0时唤醒所有等待者 */
+        void count_down(int32_t n = 1) {
+            if (count.fetch_sub(n, std::memory_order_acq_rel) == n) {
+                sync_detail::notify_all(count);
+            }
+        }
+
+        bool try_wait() const {
+            return count.load(std::memory_order_acquire) == 0;
+        }
+
+        void wait() const {
+            sync_detail::spin_wait(count, [](int32_t c) { return c == 0; });
+        }
+
+        template<typename Pool>
+        void wait(Pool& pool) const {
+            sync_detail::help_wait(count, [](int32_t c) { return c == 0; }, pool);
+        }
+
+        void arrive_and_wait(int32_t n = 1) {
+            count_down(n);
+            wait();
+        }
+    };
+
+    /* Barrier默认的完成函数，什么也不做 */
+    struct NoopCompletion {
+        void operator()() noexcept {}
+    };
+
+    /**
+     * 可重复使用的屏障，与std::barrier相同：每一阶段expected个线程到达后，最后到达的线程执行completion()，然后进入下一阶段并唤醒所有等待者。
+     * 等待者阻塞在阶段号phase上，completion()执行完之前不会有等待者返回。
+     * @tparam CompletionFunction: 每阶段结束时调用的函数，不应抛出异常
+     */
+    template<typename CompletionFunction = NoopCompletion>
+    class Barrier {
+    public:
+        using arrival_token = uint32_t; // 到达时的阶段号
+
+    private:
+        std::atomic<int32_t> expected; // 每阶段需要到达的线程数
+        std::atomic<int32_t> arrived; // 本阶段已经到达的线程数
+        std::atomic<int32_t> dropped; // 本阶段调用arrive_and_drop的线程数，阶段结束时从expected中减去
+        std::atomic<uint32_t> phase; // 阶段号，回绕不影响比较
+        CompletionFunction completion;
+
+        /* 最后到达的线程结束本阶段 */
+        void complete() {
+            completion();
+            expected.fetch_sub(dropped.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+            arrived.store(0, std::memory_order_relaxed);
+            phase.fetch_add(1, std::memory_order_release); // 下一阶段的到达者一定在看到新的阶段号之后，重置的计数对它们可见
+            sync_detail::notify_all(phase);
+        }
+
+    public:
+        explicit Barrier(int32_t expected_, CompletionFunction completion_ = CompletionFunction())
+                : expected(expected_), arrived(0), dropped(0), phase(0), completion(std::move(completion_)) {}
+
+        Barrier(const Barrier&) = delete;
+
+        Barrier& operator=(const Barrier&) = delete;
+
+        /**
+         * 到达屏障，不等待
+         * @return 到达时的阶段号，传给wait等待本阶段结束
+         */
+        [[nodiscard]] arrival_token arrive() {
+            arrival_token const token = phase.load(std::memory_order_acquire);
+            if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == expected.load(std::memory_order_relaxed)) {
+                complete();
+            }
+            return token;
+        }
+
+        void wait(arrival_token token) const {
+            sync_detail::spin_wait(phase, [token](uint32_t p) { return p != token; });
+        }
+
+        template<typename Pool>
+        void wait(arrival_token token, Pool& pool) const {
+            sync_detail::help_wait(phase, [token](uint32_t p) { return p != token; }, pool);
+        }
+
+        void arrive_and_wait() {
+            wait(arrive());
+        }
+
+        template<typename Pool>
+        void arrive_and_wait(Pool& pool) {
+            wait(arrive(), pool);
+        }
+
+        /* 到达本阶段，并且从下一阶段开始不再参与 */
+        void arrive_and_drop() {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            (void) arrive();
+        }
+    };
+
+    /**
+     * 一次性事件：set()之后所有正在等待和之后等待的线程都立即返回，不能重置。
+     * set()之前的写入对wait()返回后的线程可见，可以代替promise + shared_future向多个线程广播一个值。
+     */
+    class Event {
+    private:
+        std::atomic<uint32_t> state{0}; // 1表示已经触发
+
+    public:
+        Event() = default;
+
+        Event(const Event&) = delete;
+
+        Event& operator=(const Event&) = delete;
+
+        void set() {
+            if (state.exchange(1, std::memory_order_release) == 0) {
+                sync_detail::notify_all(state);
+            }
+        }
+
+        bool is_set() const {
+            return state.load(std::memory_order_acquire) == 1;
+        }
+
+        void wait() const {
+            sync_detail::spin_wait(state, [](uint32_t s) { return s == 1; });
+        }
+
+        template<typename Pool>
+        void wait(Pool& pool) const {
+            sync_detail::help_wait(state, [](uint32_t s) { return s == 1; }, pool);
+        }
+    };
+
+    /**
+     * 手动重置事件：set()后保持触发状态，等待者都返回，直到reset()
+     */
+    class ManualResetEvent {
+    private:
+        std::atomic<uint32_t> state;
+
+    public:
+        explicit ManualResetEvent(bool initially_set = false) : state(initially_set ? 1 : 0) {}
+
+        ManualResetEvent(const ManualResetEvent&) = delete;
+
+        ManualResetEvent& operator=(const ManualResetEvent&) = delete;
+
+        void set() {
+            if (state.exchange(1, std::memory_order_release) == 0) {
+                sync_detail::notify_all(state);
+            }
+        }
+
+        void reset() {
+            state.store(0, std::memory_order_relaxed);
+        }
+
+        bool is_set() const {
+            return state.load(std::memory_order_acquire) == 1;
+        }
+
+        void wait() const {
+            sync_detail::spin_wait(state, [](uint32_t s) { return s == 1; });
+        }
+
+        template<typename Pool>
+        void wait(Pool& pool) const {
+            sync_detail::help_wait(state, [](uint32_t s) { return s == 1; }, pool);
+        }
+    };
+}
+
+#endif //SYNCCONCURRENT_SYNC_PRIMITIVES_HPP
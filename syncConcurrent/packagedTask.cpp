@@ -1,6 +1,7 @@
 /**
  * 通过packagedTask（包含可调用对象和future）并在线程之间传递任务，例如gui线程在工作时会接收其他线程的信息并刷新ui，这时可以传递一个task，
  * 其他线程还可以使用future等待它的task运行结束
+ * 这里的gui线程在队列为空时加锁忙等，可复用的无锁实现见include/serial_executor.hpp（serialExecutor.cpp）
  */
 
 #include <iostream>
@@ -1,20 +1,22 @@
 /**
- * FP(Functional Programming)风格实现一个并行快速排序
+ * FP(Functional Programming)风格实现一个并行快速排序。
+ * spawn_task原来为每次递归创建一个detach的std::thread，百万元素的排序需要创建几十万个线程，超过限制时抛出std::system_error；
+ * 现在交给全局线程池的pool_async（threadPool/include/global_async.hpp），线程数量固定，线程池饱和时直接在本线程执行。
  */
 
 #include <iostream>
 #include <list>
-#include <future>
+#include <random>
+#include <chrono>
 #include <algorithm>
+#include <cassert>
+#include <string>
+
+#include "global_async.hpp" // threadPool/include
 
 template<typename F, typename A>
-std::future<typename std::result_of<F(A &&)>::type> spawn_task(F &&f, A &&a) { // 参数均使用万能引用
-    using result_type = typename std::result_of<F(A &&)>::type;
-    std::packaged_task<result_type(A &&)> task(std::forward<F>(f)); // 使用完美转发转移参数
-    std::future<result_type> res(task.get_future());
-    std::thread t(std::move(task), std::forward<A>(a)); // 使用完美转发转移参数
-    t.detach();
-    return res;
+zhaocc::AsyncFuture<std::invoke_result_t<F, A &&>> spawn_task(F &&f, A &&a) { // 参数均使用万能引用
+    return zhaocc::pool_async(std::forward<F>(f), std::forward<A>(a)); // 使用完美转发转移参数
 }
 
 template<typename T>
@@ -33,23 +35,37 @@ std::list<T> parallel_quick_sort(std::list<T> input) {
     std::list<T> lower_part;
     lower_part.splice(lower_part.end(), input, input.begin(), divide_point);
 
-    // 递归排序小区域部分，并且放到单独线程中来做
+    // 递归排序小区域部分，放到线程池中来做
     // std::future<std::list<T>> sorted_lower(std::async(&parallel_quick_sort<T>, std::move(lower_part)));
-    std::future<std::list<T>> sorted_lower_future = spawn_task(&parallel_quick_sort<T>, std::move(lower_part));
+    zhaocc::AsyncFuture<std::list<T>> sorted_lower_future = spawn_task(&parallel_quick_sort<T>, std::move(lower_part));
 
     // 递归排序大区域部分，在本线程中作
     auto sorted_higher(parallel_quick_sort(std::move(input)));
 
     result.splice(result.end(), sorted_higher);
-    result.splice(result.begin(), sorted_lower_future.get()); // 等待异步线程执行完毕
+    result.splice(result.begin(), sorted_lower_future.get()); // 等待异步任务执行完毕，任务还没开始时在本线程执行
 
     return result;
 }
 
-int main() {
+int main(int argc, char** argv) {
     std::list<int> nums = {2, 3, 1, 5, 4, 2};
     std::list<int> res = parallel_quick_sort(nums);
     for (auto &num : res) {
         std::cout << num << ", ";
     }
+    std::cout << std::endl;
+
+    int const count = argc > 1 ? std::stoi(argv[1]) : 1000000; // TSan下可以传入较小的数量
+    std::mt19937 rng(42);
+    std::list<int> big;
+    for (int i = 0; i < count; i++) {
+        big.push_back(static_cast<int>(rng()));
+    }
+    auto begin = std::chrono::steady_clock::now();
+    std::list<int> sorted = parallel_quick_sort(big);
+    std::chrono::duration<double, std::milli> cost = std::chrono::steady_clock::now() - begin;
+    assert(sorted.size() == big.size() && std::is_sorted(sorted.begin(), sorted.end()));
+    std::cout << "sorted " << count << " elements in " << cost.count() << "ms with "
+              << zhaocc::GlobalPool::instance().thread_count() << " pool threads" << std::endl;
 }
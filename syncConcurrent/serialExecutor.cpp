@@ -0,0 +1,159 @@
+/**
+ * 使用include/serial_executor.hpp改写packagedTask.cpp中的gui线程：gui状态只在执行线程上访问，其他线程通过post/submit传递任务，
+ * 队列为空时执行线程阻塞而不是加锁忙等，也不需要每个任务后sleep。
+ * 最后与std::deque + mutex + 条件变量的gui线程对比多个线程post任务的吞吐。
+ */
+
+#include <iostream>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <cassert>
+
+#include "serial_executor.hpp"
+
+/* gui状态，非线程安全，只能在gui执行线程上访问 */
+struct GuiState {
+    std::vector<std::string> lines;
+    std::vector<int> last_seq; // 每个生产者最后一条消息的序号
+};
+
+void test_gui_thread() {
+    constexpr int kProducers = 4;
+    constexpr int kPerProducer = 10000;
+    GuiState state;
+    state.last_seq.assign(kProducers, -1);
+    bool ordered = true;
+    {
+        zhaocc::SerialExecutor gui;
+        std::vector<std::thread> producers;
+        for (int p = 0; p < kProducers; p++) {
+            producers.emplace_back([&, p]() {
+                for (int i = 0; i < kPerProducer; i++) {
+                    gui.post([&, p, i]() {
+                        assert(gui.running_in_this_thread());
+                        ordered = ordered && state.last_seq[p] == i - 1; // 同一个生产者的任务按提交顺序执行
+                        state.last_seq[p] = i;
+                        state.lines.push_back("producer " + std::to_string(p));
+                    });
+                }
+            });
+        }
+        for (auto& t : producers) {
+            t.join();
+        }
+
+        std::future<size_t> lines = gui.submit([&state]() { return state.lines.size(); }); // 排在所有post之后
+        assert(lines.get() == kProducers * kPerProducer);
+        std::future<void> error = gui.submit([]() { throw std::runtime_error("gui error"); });
+        bool caught = false;
+        try {
+            error.get();
+        } catch (const std::runtime_error&) {
+            caught = true;
+        }
+        assert(caught);
+    } // 析构时执行完剩余任务
+    assert(ordered);
+}
+
+/* 执行线程被一个任务阻塞期间提交的任务在下一次醒来时一批执行完 */
+void test_batch() {
+    zhaocc::SerialExecutor gui;
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    gui.post([released]() { released.wait(); });
+    std::future<uint64_t> before = gui.submit([&gui]() { return gui.batch_count(); });
+    for (int i = 0; i < 1000; i++) {
+        gui.post([]() {});
+    }
+    std::future<uint64_t> after = gui.submit([&gui]() { return gui.batch_count(); });
+    release.set_value();
+    assert(before.get() == after.get()); // 阻塞期间提交的1000多个任务没有让执行线程多醒一次
+}
+
+/* 原packagedTask.cpp的结构（去掉忙等和sleep）：deque + mutex + 条件变量 */
+class MutexGuiThread {
+private:
+    std::deque<std::function<void()>> task_queue;
+    std::mutex queue_mutex;
+    std::condition_variable queue_cond;
+    bool stop = false;
+    std::thread thread;
+
+public:
+    MutexGuiThread() : thread([this]() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                queue_cond.wait(lock, [this]() { return stop || !task_queue.empty(); });
+                if (task_queue.empty()) {
+                    return;
+                }
+                task = std::move(task_queue.front());
+                task_queue.pop_front();
+            }
+            task();
+        }
+    }) {}
+
+    ~MutexGuiThread() {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            stop = true;
+        }
+        queue_cond.notify_one();
+        thread.join();
+    }
+
+    void post(std::function<void()> f) {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            task_queue.push_back(std::move(f));
+        }
+        queue_cond.notify_one();
+    }
+};
+
+/* 4个线程各post count个计数任务，返回每秒执行的任务数 */
+template<typename Executor>
+double bench_post(int count) {
+    constexpr int kProducers = 4;
+    long long counter = 0; // 只在执行线程上修改
+    auto begin = std::chrono::steady_clock::now();
+    {
+        Executor gui;
+        std::vector<std::thread> producers;
+        for (int p = 0; p < kProducers; p++) {
+            producers.emplace_back([&]() {
+                for (int i = 0; i < count; i++) {
+                    gui.post([&counter]() { counter++; });
+                }
+            });
+        }
+        for (auto& t : producers) {
+            t.join();
+        }
+    }
+    assert(counter == (long long) kProducers * count);
+    std::chrono::duration<double> cost = std::chrono::steady_clock::now() - begin;
+    return kProducers * count / cost.count();
+}
+
+int main() {
+    test_gui_thread();
+    test_batch();
+    constexpr int kCount = 200000;
+    double const mutex_rate = bench_post<MutexGuiThread>(kCount);
+    double const serial_rate = bench_post<zhaocc::SerialExecutor>(kCount);
+    std::cout << "deque + mutex: " << mutex_rate << " tasks/s, SerialExecutor: " << serial_rate << " tasks/s"
+              << std::endl;
+}
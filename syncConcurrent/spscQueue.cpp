@@ -0,0 +1,141 @@
+/**
+ * 使用SPSC无锁环形队列在两个固定线程之间传递任务，改写packagedTask.cpp中的gui线程：
+ * 原实现每次取任务都要锁全局mutex，队列为空时持续加锁忙等；这里队列为空时先短暂自旋再通过atomic::wait阻塞，入队出队都不加锁。
+ * 最后与std::deque + mutex的实现对比传递消息的吞吐。
+ */
+
+#include <iostream>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <cassert>
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+
+#include "spsc_queue.hpp"
+
+static zhaocc::SpscQueue<std::packaged_task<int()>, true> gui_task_queue(64); // 只有main线程生产，gui线程消费
+
+void gui_thread() {
+    while (true) {
+        std::packaged_task<int()> task;
+        gui_task_queue.pop(task); // 队列为空时阻塞，不会忙等
+        if (!task.valid()) { // 空任务表示退出
+            break;
+        }
+        task();
+    }
+}
+
+template<typename func>
+std::future<int> post_msg_to_gui(func f) {
+    std::packaged_task<int()> task(f);
+    std::future<int> res_future = task.get_future();
+    gui_task_queue.push(std::move(task));
+    return res_future;
+}
+
+/* 使用std::deque + mutex + 条件变量传递count个整数 */
+double bench_mutex_deque(int count) {
+    std::deque<int> queue;
+    std::mutex m;
+    std::condition_variable cond;
+    auto begin = std::chrono::steady_clock::now();
+
+    std::thread consumer([&]() {
+        long long sum = 0;
+        for (int i = 0; i < count; i++) {
+            std::unique_lock<std::mutex> lock(m);
+            cond.wait(lock, [&]() { return !queue.empty(); });
+            sum += queue.front();
+            queue.pop_front();
+        }
+        assert(sum == (long long) count * (count - 1) / 2);
+    });
+    for (int i = 0; i < count; i++) {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            queue.push_back(i);
+        }
+        cond.notify_one();
+    }
+    consumer.join();
+
+    std::chrono::duration<double, std::nano> cost = std::chrono::steady_clock::now() - begin;
+    return cost.count() / count;
+}
+
+/* 使用SPSC队列批量传递count个整数 */
+double bench_spsc_queue(int count) {
+    zhaocc::SpscQueue<int, true> queue(4096);
+    auto begin = std::chrono::steady_clock::now();
+
+    std::thread consumer([&]() {
+        long long sum = 0;
+        int buf[256];
+        for (int received = 0; received < count;) {
+            size_t n = queue.pop_bulk(buf, 256); // 一次取走所有已就绪的元素
+            for (size_t i = 0; i < n; i++) {
+                sum += buf[i];
+            }
+            received += static_cast<int>(n);
+        }
+        assert(sum == (long long) count * (count - 1) / 2);
+    });
+    int batch[64];
+    for (int i = 0; i < count; i += 64) { // 生产者每64个元素发布一次
+        int n = std::min(64, count - i);
+        for (int j = 0; j < n; j++) {
+            batch[j] = i + j;
+        }
+        queue.push_bulk(batch, n);
+    }
+    consumer.join();
+
+    std::chrono::duration<double, std::nano> cost = std::chrono::steady_clock::now() - begin;
+    return cost.count() / count;
+}
+
+int main() {
+    std::thread t1(gui_thread);
+
+    for (int i = 0; i < 10; i++) {
+        std::future<int> res_future = post_msg_to_gui([i]() {
+            std::cout << "task [" << i << "] running..." << std::endl;
+            return i * 100;
+        });
+        std::cout << "task [" << i << "] return " << res_future.get() << std::endl;
+    }
+    gui_task_queue.push(std::packaged_task<int()>()); // 通知gui线程退出
+    t1.join();
+
+    // 批量接口
+    zhaocc::SpscQueue<int> queue(8);
+    std::vector<int> in{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    assert(queue.try_push_bulk(in.begin(), in.size()) == 8); // 容量为8
+    std::vector<int> out(10);
+    assert(queue.try_pop_bulk(out.begin(), 10) == 8);
+    assert(out[7] == 8 && queue.empty());
+
+    // 单遍输入迭代器：容量小于元素数量，push_bulk分多批入队，每个元素只读取一次
+    zhaocc::SpscQueue<int, true> stream_queue(4);
+    std::thread consumer([&stream_queue]() {
+        for (int expected = 1; expected <= 10; expected++) {
+            int value;
+            stream_queue.pop(value);
+            assert(value == expected);
+        }
+    });
+    std::istringstream numbers("1 2 3 4 5 6 7 8 9 10");
+    stream_queue.push_bulk(std::istream_iterator<int>(numbers), 10);
+    consumer.join();
+
+    int const count = 1000000;
+    std::cout << "mutex deque ns/msg: " << bench_mutex_deque(count) << std::endl;
+    std::cout << "spsc queue ns/msg: " << bench_spsc_queue(count) << std::endl;
+}
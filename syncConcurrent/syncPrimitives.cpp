@@ -0,0 +1,173 @@
+/**
+ * 测试include/sync_primitives.hpp中的Latch、Barrier、Event、ManualResetEvent，
+ * 并对比64个等待者时Event与promise + shared_future（内部是mutex + condition_variable）的广播唤醒耗时。
+ * 线程池的工作线程中等待时使用接收线程池的重载，帮助执行任务，只有一个工作线程也不会死锁。
+ */
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <future>
+#include <chrono>
+#include <atomic>
+#include <cassert>
+
+#include "sync_primitives.hpp"
+#include "multi_queue_thread_pool.hpp" // threadPool/include
+
+constexpr int kWaiters = 64;
+
+void test_latch() {
+    zhaocc::Latch latch(kWaiters);
+    std::atomic<int> passed(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kWaiters; i++) {
+        threads.emplace_back([&latch, &passed]() {
+            latch.arrive_and_wait();
+            passed++;
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    assert(latch.try_wait() && passed == kWaiters);
+}
+
+void test_barrier() {
+    constexpr int kThreads = 4;
+    constexpr int kPhases = 1000;
+    std::atomic<int> sum(0);
+    int phases = 0;
+    bool consistent = true;
+    zhaocc::Barrier barrier(kThreads, [&]() noexcept { // 最后到达的线程执行，此时本阶段所有加法都已完成
+        consistent = consistent && sum.load() == kThreads * (phases + 1);
+        phases++;
+    });
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; i++) {
+        threads.emplace_back([&]() {
+            for (int p = 0; p < kPhases; p++) {
+                sum++;
+                barrier.arrive_and_wait();
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    assert(consistent && phases == kPhases);
+
+    // arrive_and_drop之后下一阶段只需要剩下的线程
+    zhaocc::Barrier<> shrinking(2);
+    std::thread dropper([&shrinking]() { shrinking.arrive_and_drop(); });
+    shrinking.arrive_and_wait();
+    dropper.join();
+    shrinking.arrive_and_wait(); // 只剩本线程，立即完成
+}
+
+/* 一个线程写入值后set，多个线程等待后读取，代替promise + shared_future */
+void test_event_broadcast() {
+    zhaocc::Event ready;
+    int value = 0;
+    std::atomic<int> sum(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; i++) {
+        threads.emplace_back([&]() {
+            ready.wait();
+            sum += value;
+        });
+    }
+    value = 100;
+    ready.set();
+    ready.set(); // 重复set没有影响
+    for (auto& t : threads) {
+        t.join();
+    }
+    assert(ready.is_set() && sum == 800);
+}
+
+void test_manual_reset_event() {
+    zhaocc::ManualResetEvent gate;
+    std::atomic<int> round(0);
+    std::thread worker([&]() {
+        for (int i = 0; i < 100; i++) {
+            gate.wait();
+            gate.reset();
+            round++;
+        }
+    });
+    for (int i = 0; i < 100; i++) {
+        gate.set();
+        while (round.load() == i) {
+            std::this_thread::yield();
+        }
+    }
+    worker.join();
+    assert(round == 100 && !gate.is_set());
+}
+
+/* 只有一个工作线程：等待的任务帮助执行后提交的count_down任务 */
+void test_pool_cooperation() {
+    zhaocc::MultiQueueThreadPool pool(1);
+    zhaocc::Latch latch(1);
+    zhaocc::Event finished;
+    pool.post([&]() {
+        pool.post([&latch]() { latch.count_down(); });
+        latch.wait(pool);
+        finished.set();
+    });
+    finished.wait();
+
+    zhaocc::Barrier<> barrier(2);
+    zhaocc::Latch both(2);
+    for (int i = 0; i < 2; i++) {
+        pool.post([&]() {
+            barrier.arrive_and_wait(pool);
+            both.count_down();
+        });
+    }
+    both.wait();
+}
+
+/* 64个线程等待，测量从触发到最后一个线程醒来的时间（微秒） */
+template<typename Wait, typename Fire>
+double wake_all(Wait wait, Fire fire) {
+    std::atomic<int> waiting(0);
+    std::atomic<int64_t> last_wake(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kWaiters; i++) {
+        threads.emplace_back([&]() {
+            waiting++;
+            wait();
+            int64_t const now = std::chrono::steady_clock::now().time_since_epoch().count();
+            int64_t prev = last_wake.load();
+            while (prev < now && !last_wake.compare_exchange_weak(prev, now)) {}
+        });
+    }
+    while (waiting.load() < kWaiters) {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // 让等待者都进入阻塞
+    int64_t const begin = std::chrono::steady_clock::now().time_since_epoch().count();
+    fire();
+    for (auto& t : threads) {
+        t.join();
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::duration(last_wake - begin)).count();
+}
+
+int main() {
+    test_latch();
+    test_barrier();
+    test_event_broadcast();
+    test_manual_reset_event();
+    test_pool_cooperation();
+
+    zhaocc::Event event;
+    double const event_us = wake_all([&event]() { event.wait(); }, [&event]() { event.set(); });
+    std::promise<void> prom;
+    std::shared_future<void> future = prom.get_future().share();
+    double const future_us = wake_all([future]() { future.wait(); }, [&prom]() { prom.set_value(); });
+    std::cout << "wake " << kWaiters << " waiters: Event " << event_us << "us, shared_future " << future_us << "us"
+              << std::endl;
+}
@@ -1,108 +1,136 @@
 /**
- * 通过条件变量实现一个线程安全的队列
+ * 通过条件变量实现一个线程安全的队列，实现见include/blocking_queue.hpp。
+ * 测试只能移动的类型、元素拷贝次数、pop_for超时，以及日志发送场景下（200字节的字符串）逐个pop与drain_into批量取出的吞吐对比。
  */
 
 #include <iostream>
-#include <queue>
+#include <string>
+#include <vector>
+#include <deque>
 #include <memory>
 #include <thread>
-#include <mutex>
-#include <condition_variable>
-
-template<class T>
-class ThreadSafeQueue {
-private:
-    std::queue<T> data_queue;
-    mutable std::mutex queue_mutex; // 队列互斥元，mutable代表永久可变
-    std::condition_variable queue_cond; // 队列条件变量
-
-public:
-    ThreadSafeQueue() {}
-
-    ThreadSafeQueue(const ThreadSafeQueue &other) {
-        std::lock_guard<std::mutex> lock(other.queue_mutex); // 锁定被拷贝对象的数据队列
-        data_queue = other.data_queue;
-    }
+#include <chrono>
+#include <atomic>
+#include <cassert>
 
-    /* 返回队列是否为空，const表示该函数无法修改任何对象的属性，queue_mutex用mutable描述，代表它可变。 */
-    bool empty() const {
-        std::lock_guard<std::mutex> lock(queue_mutex);
-        return data_queue.empty();
-    }
+#include "blocking_queue.hpp"
 
-    /* 队尾增加元素 */
-    void push(T new_val) {
-        std::lock_guard<std::mutex> lock(queue_mutex);
-        data_queue.push(new_val);
-        queue_cond.notify_one(); // 随机唤醒一个线程
-    }
+/* 统计拷贝次数的元素 */
+struct Counted {
+    static std::atomic<int> copies;
+    std::string payload;
 
+    explicit Counted(std::string p) : payload(std::move(p)) {}
 
-    /* 使用引用方式获取队头的元素，如果队头无元素则阻塞等待 */
-    void pop(T &new_val) {
-        std::unique_lock<std::mutex> lock(queue_mutex); // 这里锁定不能使用lock_guard，因为lock_guard锁定后无法灵活的解锁，只能析构时解锁
-        queue_cond.wait(lock, [this]() { return !data_queue.empty(); }); // 锁会在wait过程中解锁，一直等到lambda表达式成立
-        new_val = data_queue.front();
-        data_queue.pop();
+    Counted(const Counted& other) : payload(other.payload) {
+        copies++;
     }
 
-    /* 使用智能指针获取对头的元素，如果队头无元素则阻塞等待 */
-    std::shared_ptr<T> pop() {
-        std::unique_lock<std::mutex> lock(queue_mutex); // 这里锁定不能使用lock_guard，因为lock_guard锁定后无法灵活的解锁，只能析构时解锁
-        queue_cond.wait(lock, [this]() { return !data_queue.empty(); }); // 锁会在wait过程中解锁，一直等到lambda表达式成立
-        std::shared_ptr<T> res(data_queue.front());
-        data_queue.pop();
-        return res;
-    }
+    Counted(Counted&&) noexcept = default;
 
-    /* 使用引用方式获取队头的元素，如果队头无元素则立即返回 */
-    bool try_pop(T &new_val) {
-        std::lock_guard<std::mutex> lock(queue_mutex);
-        if (data_queue.empty()) {
-            return false;
-        }
-        new_val = data_queue.front();
-        data_queue.pop();
-        return true;
+    Counted& operator=(const Counted& other) {
+        payload = other.payload;
+        copies++;
+        return *this;
     }
 
-    /* 使用智能指针获取对头的元素，如果队头无元素则立即返回 */
-    std::shared_ptr<T> try_pop() {
-        std::lock_guard<std::mutex> lock(queue_mutex);
-        if (data_queue.empty()) {
-            return std::shared_ptr<T>();
-        }
-        std::shared_ptr<T> res(data_queue.front());
-        data_queue.pop();
-        return res;
-    }
+    Counted& operator=(Counted&&) noexcept = default;
 };
 
-int main() {
-    ThreadSafeQueue<int> thread_safe_queue;
-    std::thread t1([&]() {
-        for (int i = 0; i < 1000; i++) {
-            thread_safe_queue.push(i);
-        }
-    });
+std::atomic<int> Counted::copies(0);
 
-    std::thread t2([&]() {
-        while (true) {
-            int res;
-            thread_safe_queue.pop(res);
-            std::cout << std::this_thread::get_id() << "--" << res << std::endl;
-        }
+void test_move_only() {
+    zhaocc::BlockingQueue<std::unique_ptr<int>> queue;
+    queue.push(std::make_unique<int>(1));
+    queue.emplace(new int(2));
+    std::unique_ptr<int> value;
+    queue.pop(value);
+    assert(*value == 1);
+    std::shared_ptr<std::unique_ptr<int>> ptr = queue.pop();
+    assert(**ptr == 2);
+    assert(!queue.try_pop(value) && queue.try_pop() == nullptr);
+}
+
+void test_copies() {
+    zhaocc::BlockingQueue<Counted> queue;
+    Counted const line(std::string(200, 'x'));
+    queue.push(line); // 左值：拷贝一次
+    queue.push(Counted(std::string(200, 'y'))); // 右值：不拷贝
+    queue.emplace(std::string(200, 'z')); // 直接构造：不拷贝
+    Counted out("");
+    queue.pop(out);
+    std::shared_ptr<Counted> ptr = queue.pop();
+    assert(queue.try_pop(out));
+    std::cout << "copies: " << Counted::copies << std::endl;
+    assert(Counted::copies == 1);
+}
+
+void test_pop_for() {
+    zhaocc::BlockingQueue<int> queue;
+    int value = 0;
+    auto begin = std::chrono::steady_clock::now();
+    assert(!queue.pop_for(value, std::chrono::milliseconds(20)));
+    assert(std::chrono::steady_clock::now() - begin >= std::chrono::milliseconds(20));
+
+    std::thread producer([&queue]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        queue.push(42);
     });
+    assert(queue.pop_for(value, std::chrono::seconds(10)) && value == 42);
+    producer.join();
+}
+
+/* 4个生产者push 200字节的日志，一个消费者逐个pop或者批量drain，返回每秒处理的条数 */
+double ship_logs(bool batch, int& lock_rounds) {
+    constexpr int kProducers = 4;
+    constexpr int kPerProducer = 50000;
+    zhaocc::BlockingQueue<std::string> queue;
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; p++) {
+        producers.emplace_back([&queue]() {
+            for (int i = 0; i < kPerProducer; i++) {
+                queue.push(std::string(200, static_cast<char>('a' + i % 26)));
+            }
+        });
+    }
 
-    std::thread t3([&]() {
-        while (true) {
-            int res;
-            thread_safe_queue.pop(res);
-            std::cout << std::this_thread::get_id() << "--" << res << std::endl;
+    size_t shipped = 0;
+    size_t bytes = 0;
+    lock_rounds = 0;
+    std::deque<std::string> lines;
+    std::string line;
+    while (shipped < static_cast<size_t>(kProducers * kPerProducer)) {
+        if (batch) {
+            queue.wait_drain_into(lines);
+            for (auto& l : lines) {
+                bytes += l.size();
+            }
+            shipped += lines.size();
+            lines.clear();
+        } else {
+            queue.pop(line);
+            bytes += line.size();
+            shipped++;
         }
-    });
+        lock_rounds++;
+    }
+    for (auto& t : producers) {
+        t.join();
+    }
+    assert(bytes == shipped * 200);
+    std::chrono::duration<double> cost = std::chrono::steady_clock::now() - begin;
+    return static_cast<double>(shipped) / cost.count();
+}
 
-    t1.join();
-    t2.join();
-    t3.join();
-}
\ No newline at end of file
+int main() {
+    test_move_only();
+    test_copies();
+    test_pop_for();
+    int pops = 0;
+    int drains = 0;
+    double const one_by_one = ship_logs(false, pops);
+    double const batched = ship_logs(true, drains);
+    std::cout << "pop: " << one_by_one << " lines/s (" << pops << " lock rounds), drain_into: " << batched
+              << " lines/s (" << drains << " lock rounds)" << std::endl;
+}
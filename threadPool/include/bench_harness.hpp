@@ -0,0 +1,396 @@
+/**
+ * 自包含的微基准测试框架：每个用例在1、2、4...N个线程下分别运行，先预热若干次再正式重复若干次，
+ * 测试线程按CpuTopology绑定到不同的CPU，吞吐取多次重复的中位数，延迟按每kSampleEvery（16）次操作采样一次，
+ * 汇总后给出p50/p90/p99/p999。结果打印为表格，并可以输出为JSON文件，便于不同版本之间比较、发现性能回退。
+ *
+ * 用例是一个函数BenchSample(BenchRun&)：在run.threads个线程下完成一次测试，返回完成的操作数和耗时，
+ * 延迟采样写入run.latencies。需要多个测试线程同时开始时使用run.run_threads。
+ */
+
+#ifndef THREADPOOL_BENCH_HARNESS_HPP
+#define THREADPOOL_BENCH_HARNESS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+
+#include <unistd.h>
+
+#endif
+
+#include "cpu_topology.hpp"
+
+namespace zhaocc {
+    /* 命令行参数 */
+    struct BenchOptions {
+        unsigned max_threads = std::max(1u, std::thread::hardware_concurrency()); // 测试的最大线程数
+        unsigned warmup = 1; // 每个线程数下预热的次数，不计入结果
+        unsigned repetitions = 5; // 每个线程数下正式重复的次数
+        bool pin = true; // 测试线程是否绑核
+        std::string filter; // 只运行名字包含filter的用例
+        std::string json_path; // 非空时把结果写入该JSON文件
+
+        static void usage(const char* program) {
+            std::cout << "usage: " << program
+                      << " [--threads N] [--warmup N] [--repetitions N] [--filter SUBSTR] [--json FILE] [--no-pin]"
+                      << std::endl;
+        }
+
+        /**
+         * 解析命令行参数
+         * @throw std::invalid_argument 参数不合法
+         */
+        static BenchOptions parse(int argc, char** argv) {
+            BenchOptions options;
+            for (int i = 1; i < argc; i++) {
+                std::string const arg = argv[i];
+                auto value = [&]() -> std::string {
+                    if (i + 1 >= argc) {
+                        throw std::invalid_argument("missing value for " + arg);
+                    }
+                    return argv[++i];
+                };
+                if (arg == "--threads") {
+                    options.max_threads = static_cast<unsigned>(std::stoul(value()));
+                } else if (arg == "--warmup") {
+                    options.warmup = static_cast<unsigned>(std::stoul(value()));
+                } else if (arg == "--repetitions") {
+                    options.repetitions = static_cast<unsigned>(std::stoul(value()));
+                } else if (arg == "--filter") {
+                    options.filter = value();
+                } else if (arg == "--json") {
+                    options.json_path = value();
+                } else if (arg == "--no-pin") {
+                    options.pin = false;
+                } else {
+                    throw std::invalid_argument("unknown argument " + arg);
+                }
+            }
+            if (options.max_threads == 0 || options.repetitions == 0) {
+                throw std::invalid_argument("threads and repetitions must be positive");
+            }
+            return options;
+        }
+    };
+
+    /* 一次测试的结果 */
+    struct BenchSample {
+        uint64_t ops = 0; // 完成的操作数
+        double seconds = 0; // 耗时
+    };
+
+    /* 测试线程私有的延迟采样，不和其他线程共享，避免测量本身引入争用 */
+    class LatencyRecorder {
+    public:
+        static constexpr unsigned kSampleEvery = 16; // 每16次操作采样一次，必须是2的幂
+
+    private:
+        std::vector<uint64_t> samples;
+        unsigned tick = 0;
+
+    public:
+        static uint64_t now_ns() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        /* 执行一次操作，采样的操作记录耗时 */
+        template<typename Op>
+        void measure(Op&& op) {
+            if ((++tick & (kSampleEvery - 1)) != 0) {
+                op();
+                return;
+            }
+            uint64_t const start = now_ns();
+            op();
+            samples.push_back(now_ns() - start);
+        }
+
+        /* 直接记录一个延迟，用于操作的开始和结束不在同一个线程的情况 */
+        void record(uint64_t ns) {
+            samples.push_back(ns);
+        }
+
+        std::vector<uint64_t>& data() {
+            return samples;
+        }
+    };
+
+    /* 一次测试的上下文 */
+    struct BenchRun {
+        unsigned threads = 1; // 本次测试的线程数
+        bool pin = true;
+        std::vector<uint64_t> latencies; // 本次测试的延迟采样（纳秒）
+
+        /**
+         * 启动count个（绑核的）测试线程，所有线程就绪后同时开始执行body(index, recorder)，
+         * 各线程的延迟采样在结束后并入latencies
+         * @return 从开始到所有线程结束的秒数
+         */
+        template<typename Body>
+        double run_threads(unsigned count, Body body) {
+            std::vector<LatencyRecorder> recorders(count);
+            std::atomic<unsigned> ready(0);
+            std::atomic<bool> go(false);
+            std::vector<std::thread> workers;
+            for (unsigned i = 0; i < count; i++) {
+                workers.emplace_back([&, i]() {
+                    if (pin) {
+                        CpuTopology::instance().pin_current_thread(Placement::PIN_CORE, i);
+                    }
+                    ready.fetch_add(1);
+                    while (!go.load(std::memory_order_acquire)) {
+                        std::this_thread::yield();
+                    }
+                    body(i, recorders[i]);
+                });
+            }
+            while (ready.load() < count) {
+                std::this_thread::yield();
+            }
+            auto const begin = std::chrono::steady_clock::now();
+            go.store(true, std::memory_order_release);
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            std::chrono::duration<double> const cost = std::chrono::steady_clock::now() - begin;
+            for (auto& recorder : recorders) {
+                latencies.insert(latencies.end(), recorder.data().begin(), recorder.data().end());
+            }
+            return cost.count();
+        }
+    };
+
+    /* 一个用例在一个线程数下的汇总结果 */
+    struct BenchResult {
+        std::string name;
+        unsigned threads = 0;
+        std::vector<BenchSample> samples; // 每次正式重复的结果
+        double ops_per_sec_median = 0;
+        double ops_per_sec_min = 0;
+        double ops_per_sec_max = 0;
+        double ns_per_op = 0; // 中位数吞吐对应的每次操作耗时（所有线程合计）
+        uint64_t latency_samples = 0;
+        uint64_t p50 = 0, p90 = 0, p99 = 0, p999 = 0, max = 0; // 延迟分位数（纳秒），没有采样时为0
+    };
+
+    class BenchSuite {
+    public:
+        using BenchFunc = std::function<BenchSample(BenchRun&)>;
+
+    private:
+        struct Case {
+            std::string name;
+            BenchFunc func;
+            unsigned min_threads; // 用例需要的最少线程数，例如生产者-消费者至少需要2个线程
+        };
+
+        std::vector<Case> cases;
+        std::vector<BenchResult> results;
+
+        /* 1、2、4...直到max_threads，最后总是包含max_threads本身 */
+        static std::vector<unsigned> thread_counts(unsigned min_threads, unsigned max_threads) {
+            std::vector<unsigned> counts;
+            for (unsigned n = 1; n < max_threads; n *= 2) {
+                if (n >= min_threads) {
+                    counts.push_back(n);
+                }
+            }
+            counts.push_back(std::max(min_threads, max_threads));
+            return counts;
+        }
+
+        static uint64_t percentile(const std::vector<uint64_t>& sorted, double q) {
+            if (sorted.empty()) {
+                return 0;
+            }
+            return sorted[static_cast<size_t>(q * static_cast<double>(sorted.size() - 1))];
+        }
+
+        static BenchResult summarize(const std::string& name, unsigned threads, std::vector<BenchSample> samples,
+                                     std::vector<uint64_t> latencies) {
+            BenchResult result;
+            result.name = name;
+            result.threads = threads;
+            std::vector<double> rates;
+            for (auto const& sample : samples) {
+                rates.push_back(sample.seconds > 0 ? static_cast<double>(sample.ops) / sample.seconds : 0);
+            }
+            std::sort(rates.begin(), rates.end());
+            result.ops_per_sec_median = rates.size() % 2 == 1 ? rates[rates.size() / 2] :
+                                        (rates[rates.size() / 2 - 1] + rates[rates.size() / 2]) / 2;
+            result.ops_per_sec_min = rates.front();
+            result.ops_per_sec_max = rates.back();
+            result.ns_per_op = result.ops_per_sec_median > 0 ? 1e9 / result.ops_per_sec_median : 0;
+            result.samples = std::move(samples);
+
+            std::sort(latencies.begin(), latencies.end());
+            result.latency_samples = latencies.size();
+            result.p50 = percentile(latencies, 0.5);
+            result.p90 = percentile(latencies, 0.9);
+            result.p99 = percentile(latencies, 0.99);
+            result.p999 = percentile(latencies, 0.999);
+            result.max = latencies.empty() ? 0 : latencies.back();
+            return result;
+        }
+
+        // 先格式化到ostringstream再输出，不修改std::cout的格式标志
+        static void print_header() {
+            std::ostringstream line;
+            line << std::left << std::setw(40) << "benchmark" << std::right << std::setw(8) << "threads"
+                 << std::setw(14) << "ops/s" << std::setw(12) << "ns/op" << std::setw(10) << "p50(ns)"
+                 << std::setw(10) << "p99(ns)" << std::setw(12) << "p999(ns)";
+            std::cout << line.str() << std::endl;
+        }
+
+        static void print(const BenchResult& r) {
+            std::ostringstream line;
+            line << std::left << std::setw(40) << r.name << std::right << std::setw(8) << r.threads
+                 << std::setw(14) << std::fixed << std::setprecision(0) << r.ops_per_sec_median
+                 << std::setw(12) << std::setprecision(1) << r.ns_per_op << std::setw(10) << r.p50
+                 << std::setw(10) << r.p99 << std::setw(12) << r.p999;
+            std::cout << line.str() << std::endl;
+        }
+
+        static std::string json_escape(const std::string& s) {
+            std::string out;
+            for (char c : s) {
+                if (c == '"' || c == '\\') {
+                    out += '\\';
+                    out += c;
+                } else if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+            }
+            return out;
+        }
+
+        static std::string host_name() {
+#ifdef __linux__
+            char name[256] = {0};
+            if (gethostname(name, sizeof(name) - 1) == 0) {
+                return name;
+            }
+#endif
+            return "unknown";
+        }
+
+    public:
+        /**
+         * 注册一个用例
+         * @param name: 用例名，建议用"被测对象/场景"的形式
+         * @param func: 用例函数
+         * @param min_threads: 用例需要的最少线程数
+         */
+        void add(std::string name, BenchFunc func, unsigned min_threads = 1) {
+            cases.push_back({std::move(name), std::move(func), min_threads});
+        }
+
+        /* 按options运行所有匹配的用例并打印结果 */
+        void run(const BenchOptions& options) {
+            print_header();
+            for (auto const& c : cases) {
+                if (!options.filter.empty() && c.name.find(options.filter) == std::string::npos) {
+                    continue;
+                }
+                for (unsigned threads : thread_counts(c.min_threads, options.max_threads)) {
+                    for (unsigned i = 0; i < options.warmup; i++) {
+                        BenchRun warmup{threads, options.pin, {}};
+                        c.func(warmup);
+                    }
+                    std::vector<BenchSample> samples;
+                    std::vector<uint64_t> latencies;
+                    for (unsigned i = 0; i < options.repetitions; i++) {
+                        BenchRun run{threads, options.pin, {}};
+                        samples.push_back(c.func(run));
+                        latencies.insert(latencies.end(), run.latencies.begin(), run.latencies.end());
+                    }
+                    results.push_back(summarize(c.name, threads, std::move(samples), std::move(latencies)));
+                    print(results.back());
+                }
+            }
+        }
+
+        const std::vector<BenchResult>& get_results() const {
+            return results;
+        }
+
+        /* 结果转换为JSON，context中记录机器和编译信息，便于判断两份结果是否可比 */
+        std::string to_json(const BenchOptions& options) const {
+            std::ostringstream out;
+            out << std::setprecision(12);
+            std::time_t const now = std::time(nullptr);
+            char date[32];
+            std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+            CpuTopology const& topology = CpuTopology::instance();
+            out << "{\n  \"context\": {\n"
+                << "    \"date\": \"" << date << "\",\n"
+                << "    \"host\": \"" << json_escape(host_name()) << "\",\n"
+                << "    \"cpus\": " << topology.cpu_count() << ",\n"
+                << "    \"numa_nodes\": " << topology.node_count() << ",\n"
+#ifdef __VERSION__
+                << "    \"compiler\": \"" << json_escape(__VERSION__) << "\",\n"
+#endif
+#ifdef NDEBUG
+                << "    \"build_type\": \"release\",\n"
+#else
+                << "    \"build_type\": \"debug\",\n"
+#endif
+                << "    \"pinned\": " << (options.pin ? "true" : "false") << ",\n"
+                << "    \"warmup\": " << options.warmup << ",\n"
+                << "    \"repetitions\": " << options.repetitions << ",\n"
+                << "    \"latency_sample_every\": " << LatencyRecorder::kSampleEvery << "\n"
+                << "  },\n  \"benchmarks\": [";
+            for (size_t i = 0; i < results.size(); i++) {
+                BenchResult const& r = results[i];
+                out << (i == 0 ? "\n" : ",\n")
+                    << "    {\"name\": \"" << json_escape(r.name) << "\", \"threads\": " << r.threads
+                    << ", \"ops_per_sec\": {\"median\": " << r.ops_per_sec_median << ", \"min\": "
+                    << r.ops_per_sec_min << ", \"max\": " << r.ops_per_sec_max << "}, \"ns_per_op\": "
+                    << r.ns_per_op << ",\n     \"latency_ns\": {\"samples\": " << r.latency_samples
+                    << ", \"p50\": " << r.p50 << ", \"p90\": " << r.p90 << ", \"p99\": " << r.p99
+                    << ", \"p999\": " << r.p999 << ", \"max\": " << r.max << "},\n     \"runs\": [";
+                for (size_t j = 0; j < r.samples.size(); j++) {
+                    out << (j == 0 ? "" : ", ") << "{\"ops\": " << r.samples[j].ops << ", \"seconds\": "
+                        << r.samples[j].seconds << "}";
+                }
+                out << "]}";
+            }
+            out << "\n  ]\n}\n";
+            return out.str();
+        }
+
+        /**
+         * 结果写入JSON文件
+         * @return 是否写入成功
+         */
+        bool write_json(const BenchOptions& options) const {
+            std::ofstream out(options.json_path);
+            if (!out) {
+                return false;
+            }
+            out << to_json(options);
+            return static_cast<bool>(out);
+        }
+    };
+}
+
+#endif //THREADPOOL_BENCH_HARNESS_HPP
@@ -0,0 +1,85 @@
+/**
+ * 协作式的任务取消与线程池的关闭方式。
+ * CancellationSource发出取消，CancellationToken可以拷贝到任务中，长时间运行的任务定期检查is_cancelled()或者调用
+ * throw_if_cancelled()提前结束；线程池自己也有一个source，以CANCEL_PENDING关闭时取消，此时尚未开始的submit任务
+ * 不再执行，future中得到OperationCancelled，而不是std::future_errc::broken_promise。
+ */
+
+#ifndef THREADPOOL_CANCELLATION_HPP
+#define THREADPOOL_CANCELLATION_HPP
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace zhaocc {
+    /* 线程池的关闭方式 */
+    enum class ShutdownMode {
+        DRAIN, // 执行完所有已提交的任务（包括执行期间新提交的任务）后关闭
+        CANCEL_PENDING, // 取消线程池的token，尚未开始的submit任务不执行，future中得到OperationCancelled；正在执行的任务可以检查token提前结束
+        ABANDON // 正在执行的任务结束后立即关闭，尚未开始的任务被丢弃，future中得到broken_promise
+    };
+
+    /* 任务因为取消而没有执行或者提前结束 */
+    class OperationCancelled : public std::runtime_error {
+    public:
+        OperationCancelled() : std::runtime_error("operation cancelled") {}
+    };
+
+    class CancellationToken {
+    private:
+        friend class CancellationSource;
+
+        std::shared_ptr<const std::atomic<bool>> flag;
+
+        explicit CancellationToken(std::shared_ptr<const std::atomic<bool>> flag_) : flag(std::move(flag_)) {}
+
+    public:
+        CancellationToken() = default; // 永远不会被取消的token
+
+        bool is_cancelled() const {
+            return flag && flag->load(std::memory_order_acquire);
+        }
+
+        void throw_if_cancelled() const {
+            if (is_cancelled()) {
+                throw OperationCancelled();
+            }
+        }
+    };
+
+    class CancellationSource {
+    private:
+        std::shared_ptr<std::atomic<bool>> flag;
+
+    public:
+        CancellationSource() : flag(std::make_shared<std::atomic<bool>>(false)) {}
+
+        CancellationToken token() const {
+            return CancellationToken(flag);
+        }
+
+        void cancel() {
+            flag->store(true, std::memory_order_release);
+        }
+
+        bool is_cancelled() const {
+            return flag->load(std::memory_order_acquire);
+        }
+    };
+
+    /**
+     * 给任务加上取消检查：开始执行时token已经被取消则不执行f，抛出OperationCancelled
+     */
+    template<typename FuncType>
+    auto with_cancellation(CancellationToken token, FuncType f) {
+        return [token = std::move(token), f = std::move(f)]() mutable -> std::invoke_result_t<FuncType&> {
+            token.throw_if_cancelled();
+            return f();
+        };
+    }
+}
+
+#endif //THREADPOOL_CANCELLATION_HPP
@@ -0,0 +1,360 @@
+/**
+ * 支持组合的future：then、when_all、when_any。
+ * std::future只能阻塞get或者像ParallelQuickSort那样轮询，这里的Future在结果就绪时由完成它的线程触发回调：
+ * then的后继任务被post到线程池（在MultiQueueThreadPool的工作线程上完成时会进入该工作线程自己的任务队列），
+ * when_all/when_any只在完成线程上做计数，整个流水线不需要任何线程阻塞等待。
+ */
+
+#ifndef THREADPOOL_COMPOSABLE_FUTURE_HPP
+#define THREADPOOL_COMPOSABLE_FUTURE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "function_wrapper.hpp"
+
+namespace zhaocc {
+    template<typename T>
+    class Future;
+
+    template<typename T>
+    class Promise;
+
+    namespace detail {
+        struct Unit {}; // 代替void保存结果
+
+        /* Promise与Future共享的状态 */
+        template<typename T>
+        class SharedState {
+        public:
+            using Storage = std::conditional_t<std::is_void<T>::value, Unit, T>;
+
+        private:
+            std::mutex m;
+            std::condition_variable ready_cond; // 用于阻塞的get/wait
+            bool ready = false;
+            std::optional<Storage> value;
+            std::exception_ptr error;
+            FunctionWrapper callback; // 结果就绪时调用，最多一个
+
+            void complete(std::unique_lock<std::mutex>& lock) {
+                if (ready) {
+                    throw std::logic_error("promise already satisfied");
+                }
+                ready = true;
+                FunctionWrapper cb = std::move(callback);
+                lock.unlock(); // 在锁外唤醒和执行回调
+                ready_cond.notify_all();
+                if (cb) {
+                    cb();
+                }
+            }
+
+        public:
+            void set_value(Storage v) {
+                std::unique_lock<std::mutex> lock(m);
+                if (!ready) {
+                    value.emplace(std::move(v));
+                }
+                complete(lock);
+            }
+
+            void set_exception(std::exception_ptr e) {
+                std::unique_lock<std::mutex> lock(m);
+                if (!ready) {
+                    error = std::move(e);
+                }
+                complete(lock);
+            }
+
+            /* 设置就绪回调，已经就绪时在当前线程立即调用 */
+            void on_ready(FunctionWrapper cb) {
+                std::unique_lock<std::mutex> lock(m);
+                if (!ready) {
+                    callback = std::move(cb);
+                    return;
+                }
+                lock.unlock();
+                cb();
+            }
+
+            bool is_ready() {
+                std::lock_guard<std::mutex> lock(m);
+                return ready;
+            }
+
+            void wait() {
+                std::unique_lock<std::mutex> lock(m);
+                ready_cond.wait(lock, [this]() { return ready; });
+            }
+
+            /* 就绪后取出结果，有异常时重新抛出 */
+            Storage take() {
+                wait();
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+                return std::move(*value);
+            }
+        };
+
+        template<typename T>
+        std::vector<std::shared_ptr<SharedState<T>>> collect_states(const std::vector<Future<T>>& futures);
+
+        /* 执行f，把结果或异常写入promise */
+        template<typename R, typename F, typename... Args>
+        void fulfill(Promise<R>& promise, F& f, Args&& ... args) {
+            try {
+                if constexpr (std::is_void<R>::value) {
+                    f(std::forward<Args>(args)...);
+                    promise.set_value();
+                } else {
+                    promise.set_value(f(std::forward<Args>(args)...));
+                }
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        }
+    }
+
+    template<typename T>
+    class Promise {
+    private:
+        std::shared_ptr<detail::SharedState<T>> state;
+        bool future_retrieved = false;
+
+    public:
+        Promise() : state(std::make_shared<detail::SharedState<T>>()) {}
+
+        Promise(Promise&&) noexcept = default;
+
+        Promise& operator=(Promise&&) noexcept = default;
+
+        ~Promise() {
+            if (state && !state->is_ready()) { // 与std::promise一致，未设置结果就析构时设置broken_promise
+                state->set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+            }
+        }
+
+        Future<T> get_future() {
+            if (future_retrieved) {
+                throw std::future_error(std::future_errc::future_already_retrieved);
+            }
+            future_retrieved = true;
+            return Future<T>(state);
+        }
+
+        template<typename... Args>
+        void set_value(Args&& ... args) {
+            state->set_value(typename detail::SharedState<T>::Storage(std::forward<Args>(args)...));
+        }
+
+        void set_exception(std::exception_ptr e) {
+            state->set_exception(std::move(e));
+        }
+    };
+
+    template<typename T>
+    class Future {
+    private:
+        template<typename U> friend
+        class Promise;
+
+        template<typename U> friend
+        class Future;
+
+        template<typename U> friend
+        std::vector<std::shared_ptr<detail::SharedState<U>>> detail::collect_states(const std::vector<Future<U>>&);
+
+        std::shared_ptr<detail::SharedState<T>> state;
+
+        explicit Future(std::shared_ptr<detail::SharedState<T>> state_) : state(std::move(state_)) {}
+
+    public:
+        Future() = default;
+
+        Future(Future&&) noexcept = default;
+
+        Future& operator=(Future&&) noexcept = default;
+
+        bool valid() const {
+            return state != nullptr;
+        }
+
+        bool is_ready() const {
+            return state->is_ready();
+        }
+
+        /**
+         * 阻塞等待结果，只应在流水线的最终消费者上调用，不要在工作线程上调用
+         */
+        void wait() const {
+            state->wait();
+        }
+
+        /**
+         * 阻塞获取结果，有异常时重新抛出；调用后Future失效
+         */
+        T get() {
+            std::shared_ptr<detail::SharedState<T>> s = std::move(state);
+            if constexpr (std::is_void<T>::value) {
+                s->take();
+            } else {
+                return s->take();
+            }
+        }
+
+        /**
+         * 设置就绪后的后继任务，调用后本Future失效
+         * @param pool: 执行后继任务的线程池，需要提供post
+         * @param f: 可调用对象，参数为已就绪的Future<T>，在其中调用get获取结果或异常
+         * @return 与f的返回值关联的Future
+         */
+        template<typename ThreadPoolType, typename F>
+        auto then(ThreadPoolType& pool, F f) -> Future<std::invoke_result_t<F, Future<T>>>;
+
+        /**
+         * 设置就绪后的后继任务，在完成本Future的线程上直接执行，只适用于很轻量的f
+         */
+        template<typename F>
+        auto then_inline(F f) -> Future<std::invoke_result_t<F, Future<T>>>;
+    };
+
+    template<typename T>
+    template<typename ThreadPoolType, typename F>
+    auto Future<T>::then(ThreadPoolType& pool, F f) -> Future<std::invoke_result_t<F, Future<T>>> {
+        using R = std::invoke_result_t<F, Future<T>>;
+
+        Promise<R> promise;
+        Future<R> result = promise.get_future();
+        std::shared_ptr<detail::SharedState<T>> s = std::move(state);
+        detail::SharedState<T>* const raw = s.get();
+        raw->on_ready([&pool, s = std::move(s), promise = std::move(promise), f = std::move(f)]() mutable {
+            // 就绪回调运行在完成线程上，只把后继任务post出去，不占用完成线程
+            pool.post([s = std::move(s), promise = std::move(promise), f = std::move(f)]() mutable {
+                detail::fulfill(promise, f, Future<T>(std::move(s)));
+            });
+        });
+        return result;
+    }
+
+    template<typename T>
+    template<typename F>
+    auto Future<T>::then_inline(F f) -> Future<std::invoke_result_t<F, Future<T>>> {
+        using R = std::invoke_result_t<F, Future<T>>;
+
+        Promise<R> promise;
+        Future<R> result = promise.get_future();
+        std::shared_ptr<detail::SharedState<T>> s = std::move(state);
+        detail::SharedState<T>* const raw = s.get();
+        raw->on_ready([s = std::move(s), promise = std::move(promise), f = std::move(f)]() mutable {
+            detail::fulfill(promise, f, Future<T>(std::move(s)));
+        });
+        return result;
+    }
+
+    /**
+     * 在线程池中执行f，返回可组合的Future
+     */
+    template<typename ThreadPoolType, typename F>
+    auto spawn(ThreadPoolType& pool, F f) -> Future<std::invoke_result_t<F>> {
+        using R = std::invoke_result_t<F>;
+
+        Promise<R> promise;
+        Future<R> result = promise.get_future();
+        pool.post([promise = std::move(promise), f = std::move(f)]() mutable {
+            detail::fulfill(promise, f);
+        });
+        return result;
+    }
+
+    namespace detail {
+        /* 在注册回调期间持有所有输入的状态：回调可能同步执行并把futures交出去，交出去的Future可能被立即析构 */
+        template<typename T>
+        std::vector<std::shared_ptr<SharedState<T>>> collect_states(const std::vector<Future<T>>& futures) {
+            std::vector<std::shared_ptr<SharedState<T>>> states;
+            states.reserve(futures.size());
+            for (auto& future : futures) {
+                states.push_back(future.state);
+            }
+            return states;
+        }
+    }
+
+    /**
+     * 所有输入都就绪后就绪，结果为就绪的输入（顺序不变），每个输入的结果或异常通过get获取
+     */
+    template<typename T>
+    Future<std::vector<Future<T>>> when_all(std::vector<Future<T>> futures) {
+        struct Context {
+            std::vector<Future<T>> futures;
+            std::atomic<size_t> remaining;
+            Promise<std::vector<Future<T>>> promise;
+        };
+
+        auto context = std::make_shared<Context>();
+        Future<std::vector<Future<T>>> result = context->promise.get_future();
+        if (futures.empty()) {
+            context->promise.set_value(std::move(futures));
+            return result;
+        }
+
+        auto states = detail::collect_states(futures);
+        context->remaining.store(futures.size());
+        context->futures = std::move(futures);
+        for (auto& state : states) {
+            state->on_ready([context]() {
+                if (context->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) { // 最后一个就绪的输入
+                    context->promise.set_value(std::move(context->futures));
+                }
+            });
+        }
+        return result;
+    }
+
+    template<typename T>
+    struct WhenAnyResult {
+        size_t index; // 第一个就绪的输入的位置
+        std::vector<Future<T>> futures; // 所有输入，顺序不变
+    };
+
+    /**
+     * 任意一个输入就绪后就绪
+     */
+    template<typename T>
+    Future<WhenAnyResult<T>> when_any(std::vector<Future<T>> futures) {
+        if (futures.empty()) {
+            throw std::invalid_argument("when_any requires at least one future");
+        }
+
+        struct Context {
+            std::vector<Future<T>> futures;
+            std::atomic<bool> done{false};
+            Promise<WhenAnyResult<T>> promise;
+        };
+
+        auto context = std::make_shared<Context>();
+        Future<WhenAnyResult<T>> result = context->promise.get_future();
+        auto states = detail::collect_states(futures);
+        context->futures = std::move(futures);
+        for (size_t i = 0; i < states.size(); i++) {
+            states[i]->on_ready([context, i]() {
+                if (!context->done.exchange(true)) { // 第一个就绪的输入
+                    context->promise.set_value(WhenAnyResult<T>{i, std::move(context->futures)});
+                }
+            });
+        }
+        return result;
+    }
+}
+
+#endif //THREADPOOL_COMPOSABLE_FUTURE_HPP
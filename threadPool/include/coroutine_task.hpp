@@ -0,0 +1,340 @@
+/**
+ * C++20协程与线程池的结合：Task<T>协程类型，以及co_await schedule(pool)、yield(pool)、sleep_for(timer, pool, duration)。
+ * 协程挂起时不占用任何线程，恢复时通过pool.post投递（在MultiQueueThreadPool的工作线程上会进入该线程自己的任务队列），
+ * 大量进行中的异步操作可以共享固定数量的工作线程，不需要为每个操作分配线程或者std::future。
+ * Task是惰性的：创建时不执行，被co_await或者co_spawn时才开始执行，结束时通过对称转移直接恢复等待它的协程。
+ * 恢复任务在执行前被销毁（线程池以ABANDON关闭、定时器容器停止）时，销毁co_spawn启动的整条协程链，Future得到broken_promise；
+ * 被其他类型的协程co_await的Task不知道谁拥有最外层的协程，这种情况下不会销毁，协程帧会泄漏。
+ */
+
+#ifndef THREADPOOL_COROUTINE_TASK_HPP
+#define THREADPOOL_COROUTINE_TASK_HPP
+
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "composable_future.hpp"
+#include "thread_pool_timer_container.h"
+
+namespace zhaocc {
+    template<typename T = void>
+    class Task;
+
+    namespace detail {
+        /* Task结束时恢复等待它的协程 */
+        struct FinalAwaiter {
+            bool await_ready() noexcept {
+                return false;
+            }
+
+            template<typename PromiseType>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<PromiseType> h) noexcept {
+                std::coroutine_handle<> continuation = h.promise().continuation;
+                return continuation ? continuation : std::noop_coroutine(); // 对称转移，不增加调用栈深度
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        /* 拥有h所在协程链的最外层协程，恢复任务被丢弃时销毁它，未知时为空 */
+        template<typename PromiseType>
+        std::coroutine_handle<> owner_of(std::coroutine_handle<PromiseType> h) noexcept;
+
+        struct TaskPromiseBase {
+            std::coroutine_handle<> continuation; // 等待本Task的协程
+            std::coroutine_handle<> owner; // co_spawn启动的最外层协程，销毁它会依次销毁它持有的Task
+            std::exception_ptr error;
+
+            std::suspend_always initial_suspend() noexcept { // 惰性启动
+                return {};
+            }
+
+            FinalAwaiter final_suspend() noexcept {
+                return {};
+            }
+
+            void unhandled_exception() noexcept {
+                error = std::current_exception();
+            }
+        };
+
+        template<typename T>
+        struct TaskPromise : TaskPromiseBase {
+            std::optional<T> value;
+
+            Task<T> get_return_object() noexcept;
+
+            template<typename U>
+            void return_value(U&& v) {
+                value.emplace(std::forward<U>(v));
+            }
+
+            T result() {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+                return std::move(*value);
+            }
+        };
+
+        template<>
+        struct TaskPromise<void> : TaskPromiseBase {
+            Task<void> get_return_object() noexcept;
+
+            void return_void() noexcept {}
+
+            void result() {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+        };
+    }
+
+    template<typename T>
+    class Task {
+    public:
+        using promise_type = detail::TaskPromise<T>;
+
+    private:
+        std::coroutine_handle<promise_type> handle;
+
+        /* co_await Task使用的awaiter */
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() noexcept {
+                return !handle || handle.done();
+            }
+
+            template<typename PromiseType>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<PromiseType> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                handle.promise().owner = detail::owner_of(awaiting);
+                return handle;
+            }
+
+            T await_resume() {
+                return handle.promise().result();
+            }
+        };
+
+    public:
+        explicit Task(std::coroutine_handle<promise_type> handle_) : handle(handle_) {}
+
+        Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+        Task& operator=(Task&& other) noexcept {
+            if (this != &other) {
+                if (handle) {
+                    handle.destroy();
+                }
+                handle = std::exchange(other.handle, nullptr);
+            }
+            return *this;
+        }
+
+        // 不允许拷贝
+        Task(const Task&) = delete;
+
+        Task& operator=(const Task&) = delete;
+
+        ~Task() {
+            if (handle) {
+                handle.destroy();
+            }
+        }
+
+        /* co_await一个Task：记录等待者，然后转移到Task开始执行 */
+        auto operator co_await() && noexcept {
+            return Awaiter{handle};
+        }
+    };
+
+    namespace detail {
+        template<typename T>
+        Task<T> TaskPromise<T>::get_return_object() noexcept {
+            return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+        }
+
+        inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+            return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+        }
+
+        /* 恢复协程的任务，只能移动，没有执行就被销毁时销毁owner，防止挂起的协程链泄漏 */
+        class ResumeHandle {
+        private:
+            std::coroutine_handle<> handle;
+            std::coroutine_handle<> owner;
+
+        public:
+            ResumeHandle(std::coroutine_handle<> handle_, std::coroutine_handle<> owner_) noexcept
+                    : handle(handle_), owner(owner_) {}
+
+            ResumeHandle(ResumeHandle&& other) noexcept
+                    : handle(std::exchange(other.handle, nullptr)), owner(std::exchange(other.owner, nullptr)) {}
+
+            ResumeHandle& operator=(ResumeHandle&&) = delete;
+
+            ~ResumeHandle() {
+                if (handle && owner) {
+                    owner.destroy();
+                }
+            }
+
+            void operator()() {
+                owner = nullptr;
+                std::exchange(handle, nullptr).resume();
+            }
+
+            /* 不再负责恢复，也不会销毁 */
+            void release() noexcept {
+                handle = nullptr;
+                owner = nullptr;
+            }
+        };
+
+        /* 把协程的恢复投递到线程池 */
+        template<typename ThreadPoolType>
+        void resume_on(ThreadPoolType& pool, ResumeHandle resume) {
+            pool.post(std::move(resume));
+        }
+
+        template<typename ThreadPoolType>
+        struct ScheduleAwaiter {
+            ThreadPoolType& pool;
+
+            bool await_ready() noexcept {
+                return false;
+            }
+
+            template<typename PromiseType>
+            void await_suspend(std::coroutine_handle<PromiseType> h) {
+                resume_on(pool, ResumeHandle(h, owner_of(h)));
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        template<typename ThreadPoolType>
+        struct SleepAwaiter {
+            common::ThreadPoolTimerContainer& timer;
+            ThreadPoolType& pool;
+            std::chrono::milliseconds duration;
+
+            bool await_ready() noexcept {
+                return duration.count() <= 0;
+            }
+
+            template<typename PromiseType>
+            bool await_suspend(std::coroutine_handle<PromiseType> h) {
+                ThreadPoolType* const p = &pool;
+                // timer的回调是std::function，需要可以拷贝，由最后一份回调负责销毁未执行的恢复
+                auto resume = std::make_shared<ResumeHandle>(h, owner_of(h));
+                int64_t const timer_id = timer.AddTimer([p, resume](void*) { resume_on(*p, std::move(*resume)); },
+                                                        nullptr, static_cast<int>(duration.count()), nullptr,
+                                                        common::ThreadPoolTimerContainer::MS, false);
+                if (timer_id == 0) { // timer未启动时不挂起，直接继续执行
+                    resume->release();
+                    return false;
+                }
+                return true;
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        /* co_spawn使用的分离协程，结束时自动销毁 */
+        struct DetachedTask {
+            struct promise_type {
+                DetachedTask get_return_object() noexcept {
+                    return {};
+                }
+
+                std::suspend_never initial_suspend() noexcept {
+                    return {};
+                }
+
+                std::suspend_never final_suspend() noexcept {
+                    return {};
+                }
+
+                void return_void() noexcept {}
+
+                void unhandled_exception() noexcept {
+                    std::terminate();
+                }
+            };
+        };
+
+        template<typename PromiseType>
+        std::coroutine_handle<> owner_of(std::coroutine_handle<PromiseType> h) noexcept {
+            if constexpr (std::is_base_of<TaskPromiseBase, PromiseType>::value) {
+                return h.promise().owner;
+            } else if constexpr (std::is_same<PromiseType, DetachedTask::promise_type>::value) {
+                return h; // 分离协程没有其他拥有者
+            } else {
+                return nullptr;
+            }
+        }
+
+        template<typename ThreadPoolType, typename T>
+        DetachedTask co_spawn_driver(ThreadPoolType& pool, Task<T> task, Promise<T> promise) {
+            co_await ScheduleAwaiter<ThreadPoolType>{pool}; // 切换到线程池中执行
+            try {
+                if constexpr (std::is_void<T>::value) {
+                    co_await std::move(task);
+                    promise.set_value();
+                } else {
+                    promise.set_value(co_await std::move(task));
+                }
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        }
+    }
+
+    /**
+     * 切换到线程池中继续执行：co_await schedule(pool)
+     */
+    template<typename ThreadPoolType>
+    detail::ScheduleAwaiter<ThreadPoolType> schedule(ThreadPoolType& pool) {
+        return {pool};
+    }
+
+    /**
+     * 让出工作线程：把自己重新放到任务队列尾部，让排在前面的任务先执行
+     */
+    template<typename ThreadPoolType>
+    detail::ScheduleAwaiter<ThreadPoolType> yield(ThreadPoolType& pool) {
+        return {pool};
+    }
+
+    /**
+     * 挂起duration后在线程池中恢复，挂起期间不占用任何线程
+     * @param timer: 已经Start的定时器容器，只负责计时，到期后把恢复投递到pool
+     */
+    template<typename ThreadPoolType>
+    detail::SleepAwaiter<ThreadPoolType> sleep_for(common::ThreadPoolTimerContainer& timer, ThreadPoolType& pool,
+                                                   std::chrono::milliseconds duration) {
+        return {timer, pool, duration};
+    }
+
+    /**
+     * 在线程池中启动Task，返回可组合的Future，可以继续then/when_all，或者在非工作线程上get
+     */
+    template<typename ThreadPoolType, typename T>
+    Future<T> co_spawn(ThreadPoolType& pool, Task<T> task) {
+        Promise<T> promise;
+        Future<T> future = promise.get_future();
+        detail::co_spawn_driver(pool, std::move(task), std::move(promise));
+        return future;
+    }
+}
+
+#endif //THREADPOOL_COROUTINE_TASK_HPP
@@ -0,0 +1,185 @@
+/**
+ * 通过解析/sys获取CPU与NUMA节点的对应关系（不依赖libnuma），以及工作线程的绑核策略。
+ * 工作线程的位置（slot）按节点依次映射到CPU：先排满节点0的CPU，再排节点1，超过CPU数量后从头循环，
+ * 这样相邻位置的工作线程位于同一个节点，窃取任务时可以优先选择同一节点的线程。
+ */
+
+#ifndef THREADPOOL_CPU_TOPOLOGY_HPP
+#define THREADPOOL_CPU_TOPOLOGY_HPP
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+
+#include <pthread.h>
+#include <sched.h>
+
+#endif
+
+namespace zhaocc {
+    /* 工作线程的放置策略 */
+    enum class Placement {
+        NONE, // 不绑定，由操作系统调度
+        PIN_CORE, // 每个工作线程绑定到一个CPU
+        PIN_NODE // 每个工作线程绑定到一个NUMA节点的所有CPU，可以在节点内迁移
+    };
+
+    class CpuTopology {
+    private:
+        std::vector<std::vector<int>> node_cpus; // 每个节点可用的CPU
+        std::vector<int> cpus; // 所有可用的CPU，按节点排列
+        std::vector<unsigned> cpu_nodes; // 与cpus对应的节点序号（node_cpus中的位置）
+
+        static bool read_line(const std::string& path, std::string& line) {
+            std::ifstream in(path);
+            return static_cast<bool>(std::getline(in, line));
+        }
+
+        /* 当前进程允许运行的CPU，容器中可能只是一部分 */
+        static std::vector<int> allowed_cpus() {
+            std::vector<int> result;
+#ifdef __linux__
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+                for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                    if (CPU_ISSET(cpu, &set)) {
+                        result.push_back(cpu);
+                    }
+                }
+            }
+#endif
+            if (result.empty()) {
+                for (int cpu = 0; cpu < static_cast<int>(std::max(1u, std::thread::hardware_concurrency())); cpu++) {
+                    result.push_back(cpu);
+                }
+            }
+            return result;
+        }
+
+        CpuTopology() {
+            std::vector<int> const allowed = allowed_cpus();
+
+            std::string line;
+            if (read_line("/sys/devices/system/node/online", line)) {
+                for (int node : parse_cpu_list(line)) {
+                    std::string cpu_line;
+                    if (!read_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist", cpu_line)) {
+                        continue;
+                    }
+                    std::vector<int> node_list;
+                    for (int cpu : parse_cpu_list(cpu_line)) {
+                        if (std::binary_search(allowed.begin(), allowed.end(), cpu)) {
+                            node_list.push_back(cpu);
+                        }
+                    }
+                    if (!node_list.empty()) { // 忽略没有CPU或者CPU都不可用的节点
+                        node_cpus.push_back(std::move(node_list));
+                    }
+                }
+            }
+            if (node_cpus.empty()) { // 没有/sys/devices/system/node时作为一个节点
+                node_cpus.push_back(allowed);
+            }
+
+            for (unsigned node = 0; node < node_cpus.size(); node++) {
+                for (int cpu : node_cpus[node]) {
+                    cpus.push_back(cpu);
+                    cpu_nodes.push_back(node);
+                }
+            }
+        }
+
+    public:
+        /* 进程内只解析一次 */
+        static const CpuTopology& instance() {
+            static CpuTopology const topology;
+            return topology;
+        }
+
+        /**
+         * 解析sysfs中的CPU列表，例如"0-3,8-11"
+         * @return 升序的CPU序号
+         */
+        static std::vector<int> parse_cpu_list(const std::string& list) {
+            std::vector<int> result;
+            std::stringstream ss(list);
+            std::string range;
+            while (std::getline(ss, range, ',')) {
+                if (range.empty()) {
+                    continue;
+                }
+                size_t const dash = range.find('-');
+                try {
+                    int const first = std::stoi(range.substr(0, dash));
+                    int const last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                    for (int cpu = first; cpu <= last; cpu++) {
+                        result.push_back(cpu);
+                    }
+                } catch (const std::exception&) { // 格式错误的部分直接忽略
+                }
+            }
+            std::sort(result.begin(), result.end());
+            result.erase(std::unique(result.begin(), result.end()), result.end());
+            return result;
+        }
+
+        unsigned node_count() const {
+            return static_cast<unsigned>(node_cpus.size());
+        }
+
+        unsigned cpu_count() const {
+            return static_cast<unsigned>(cpus.size());
+        }
+
+        const std::vector<int>& cpus_of_node(unsigned node) const {
+            return node_cpus[node];
+        }
+
+        /* 工作线程位置对应的CPU */
+        int cpu_for_slot(unsigned slot) const {
+            return cpus[slot % cpus.size()];
+        }
+
+        /* 工作线程位置对应的节点 */
+        unsigned node_for_slot(unsigned slot) const {
+            return cpu_nodes[slot % cpus.size()];
+        }
+
+        /**
+         * 按放置策略绑定当前线程
+         * @param placement: 放置策略
+         * @param slot: 当前线程作为工作线程的位置
+         * @return 是否绑定成功，Placement::NONE或者非Linux平台时返回false
+         */
+        bool pin_current_thread(Placement placement, unsigned slot) const {
+#ifdef __linux__
+            if (placement == Placement::NONE) {
+                return false;
+            }
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (placement == Placement::PIN_CORE) {
+                CPU_SET(cpu_for_slot(slot), &set);
+            } else {
+                for (int cpu : node_cpus[node_for_slot(slot)]) {
+                    CPU_SET(cpu, &set);
+                }
+            }
+            return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+            (void) placement;
+            (void) slot;
+            return false;
+#endif
+        }
+    };
+}
+
+#endif //THREADPOOL_CPU_TOPOLOGY_HPP
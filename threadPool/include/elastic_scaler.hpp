@@ -0,0 +1,231 @@
+/**
+ * 线程池的弹性伸缩：工作线程数量在[min_threads, max_threads]之间变化。
+ * 提交和执行任务时只累加两个计数，由单独的supervisor线程定期根据计数估算排队时间（积压数量 / 出队速率，
+ * 以及积压时出队停滞的时长），超过阈值时创建新的工作线程，线程的创建不在submit路径上；
+ * 工作线程空闲超过idle_timeout后自行退出，supervisor在复用它的位置前join它。
+ * 工作线程保存在固定大小（max_threads）的数组中，每个位置依次经历EMPTY -> RUNNING -> EXITED -> RUNNING ...
+ */
+
+#ifndef THREADPOOL_ELASTIC_SCALER_HPP
+#define THREADPOOL_ELASTIC_SCALER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace zhaocc {
+    /* 弹性伸缩的参数，min_threads == max_threads时线程数量固定，不会启动supervisor */
+    struct ElasticOptions {
+        unsigned min_threads = 1;
+        unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+        std::chrono::microseconds grow_wait_threshold{2000}; // 估算的排队时间超过该值时扩容
+        std::chrono::milliseconds idle_timeout{1000}; // 工作线程连续空闲超过该值时退出
+        std::chrono::milliseconds check_interval{5}; // supervisor的检查间隔，每次最多扩容一个线程
+    };
+
+    class ElasticScaler {
+    private:
+        enum SlotState {
+            EMPTY, // 从未使用
+            RUNNING, // 工作线程正在运行
+            EXITED // 工作线程已经退出或即将退出，等待被join
+        };
+
+        ElasticOptions const options;
+        std::vector<std::thread>& threads; // 线程池的工作线程数组，大小为max_threads
+        std::unique_ptr<std::atomic<int>[]> slot_states;
+        std::mutex threads_mutex; // 保护threads中线程对象的创建、回收
+        std::function<std::thread(unsigned)> make_worker; // 在指定位置创建工作线程
+
+        std::atomic<unsigned> live{0}; // 运行中的工作线程数量
+        alignas(64) std::atomic<uint64_t> enqueued{0}; // 累计入队任务数
+        alignas(64) std::atomic<uint64_t> dequeued{0}; // 累计开始执行的任务数
+
+        std::thread supervisor;
+        std::mutex supervisor_mutex;
+        std::condition_variable supervisor_cond;
+        bool stopping = false;
+
+        bool spawn(); // 在一个空闲位置创建工作线程
+        void supervise(); // supervisor线程执行的函数
+
+    public:
+        ElasticScaler(const ElasticOptions& options_, std::vector<std::thread>& threads_)
+                : options(options_), threads(threads_), slot_states(new std::atomic<int>[options_.max_threads]) {
+            if (options.min_threads > options.max_threads) {
+                throw std::invalid_argument("min_threads must not be greater than max_threads");
+            }
+            threads.resize(options.max_threads);
+            for (unsigned i = 0; i < options.max_threads; i++) {
+                slot_states[i].store(EMPTY);
+            }
+        }
+
+        ~ElasticScaler() {
+            stop();
+        }
+
+        // 不允许拷贝
+        ElasticScaler(const ElasticScaler&) = delete;
+
+        ElasticScaler& operator=(const ElasticScaler&) = delete;
+
+        /**
+         * 创建min_threads个工作线程，弹性模式下启动supervisor
+         * @param make_worker_: 可调用对象，参数为位置，返回该位置上的工作线程
+         */
+        void start(std::function<std::thread(unsigned)> make_worker_);
+
+        /* 停止supervisor，之后不会再创建工作线程；必须在join工作线程之前调用 */
+        void stop();
+
+        bool elastic() const {
+            return options.min_threads < options.max_threads;
+        }
+
+        void on_enqueue(size_t count = 1) {
+            enqueued.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        void on_dequeue(size_t count = 1) {
+            dequeued.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        /**
+         * 工作线程空闲时调用，空闲超过idle_timeout并且线程数量大于min_threads时，登记退出
+         * @param slot: 工作线程的位置
+         * @param idle: 已经连续空闲的时长
+         * @return 是否应该退出
+         */
+        bool try_retire(unsigned slot, std::chrono::steady_clock::duration idle);
+
+        /* 累计入队任务数 */
+        uint64_t enqueued_count() const {
+            return enqueued.load(std::memory_order_acquire);
+        }
+
+        /* 已提交、尚未开始执行的任务数量，近似值 */
+        int64_t backlog() const {
+            return static_cast<int64_t>(enqueued.load(std::memory_order_relaxed) -
+                                        dequeued.load(std::memory_order_relaxed));
+        }
+
+        /* 运行中的工作线程数量 */
+        unsigned thread_count() const {
+            return live.load(std::memory_order_relaxed);
+        }
+
+        unsigned max_threads() const {
+            return options.max_threads;
+        }
+
+        std::mutex& mutex() {
+            return threads_mutex;
+        }
+    };
+
+    inline bool ElasticScaler::spawn() {
+        std::lock_guard<std::mutex> lock(threads_mutex);
+        for (unsigned i = 0; i < options.max_threads; i++) {
+            int const state = slot_states[i].load(std::memory_order_acquire);
+            if (state == RUNNING) {
+                continue;
+            }
+            if (state == EXITED && threads[i].joinable()) {
+                threads[i].join(); // 退出的线程已经不再访问线程池，join很快返回
+            }
+            slot_states[i].store(RUNNING, std::memory_order_relaxed);
+            live.fetch_add(1, std::memory_order_relaxed);
+            try {
+                threads[i] = make_worker(i);
+            } catch (...) {
+                slot_states[i].store(EMPTY, std::memory_order_relaxed);
+                live.fetch_sub(1, std::memory_order_relaxed);
+                throw;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    inline void ElasticScaler::start(std::function<std::thread(unsigned)> make_worker_) {
+        make_worker = std::move(make_worker_);
+        for (unsigned i = 0; i < options.min_threads; i++) {
+            spawn();
+        }
+        if (elastic()) {
+            supervisor = std::thread(&ElasticScaler::supervise, this);
+        }
+    }
+
+    inline void ElasticScaler::stop() {
+        {
+            std::lock_guard<std::mutex> lock(supervisor_mutex);
+            stopping = true;
+        }
+        supervisor_cond.notify_one();
+        if (supervisor.joinable()) {
+            supervisor.join();
+        }
+    }
+
+    inline bool ElasticScaler::try_retire(unsigned slot, std::chrono::steady_clock::duration idle) {
+        if (!elastic() || idle < options.idle_timeout) {
+            return false;
+        }
+        unsigned n = live.load(std::memory_order_relaxed);
+        while (n > options.min_threads) {
+            if (live.compare_exchange_weak(n, n - 1, std::memory_order_relaxed)) {
+                slot_states[slot].store(EXITED, std::memory_order_release);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline void ElasticScaler::supervise() {
+        using Clock = std::chrono::steady_clock;
+        uint64_t last_dequeued = dequeued.load(std::memory_order_relaxed);
+        Clock::time_point last_check = Clock::now();
+        Clock::time_point last_progress = last_check; // 积压期间最后一次有任务开始执行的时间
+
+        std::unique_lock<std::mutex> lock(supervisor_mutex);
+        while (!supervisor_cond.wait_for(lock, options.check_interval, [this]() { return stopping; })) {
+            Clock::time_point const now = Clock::now();
+            uint64_t const d = dequeued.load(std::memory_order_relaxed);
+            int64_t const backlog = static_cast<int64_t>(enqueued.load(std::memory_order_relaxed) - d);
+
+            if (backlog <= 0 || d != last_dequeued) {
+                last_progress = now;
+            }
+            if (backlog > 0 && live.load(std::memory_order_relaxed) < options.max_threads) {
+                // 估算排队时间：按最近的出队速率消化积压所需的时间，与积压后出队停滞的时长取较大值
+                std::chrono::duration<double, std::micro> estimated = now - last_progress;
+                if (d != last_dequeued) {
+                    std::chrono::duration<double, std::micro> const elapsed = now - last_check;
+                    estimated = std::max(estimated, elapsed * (static_cast<double>(backlog) / (d - last_dequeued)));
+                }
+                if (estimated > options.grow_wait_threshold) {
+                    try {
+                        spawn();
+                    } catch (...) {
+                        // 创建线程失败时保持当前线程数量，下次检查再尝试
+                    }
+                }
+            }
+
+            last_dequeued = d;
+            last_check = now;
+        }
+    }
+}
+
+#endif //THREADPOOL_ELASTIC_SCALER_HPP
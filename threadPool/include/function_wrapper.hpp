@@ -0,0 +1,80 @@
+/**
+ * 对任意类型的可调用对象进行封装，只支持move，不支持copy，可以保存packaged_task、捕获了promise的lambda等只能移动的对象。
+ * 原先在futured_thread_pool和multi_queue_thread_pool中各定义了一份，抽出来供线程池与composable_future共用。
+ */
+
+#ifndef THREADPOOL_FUNCTION_WRAPPER_HPP
+#define THREADPOOL_FUNCTION_WRAPPER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace zhaocc {
+    class FunctionWrapper {
+        /* 封装可调用对象基类 */
+        class ImplBase {
+        public:
+            virtual void call() = 0; // 纯虚函数
+            virtual ~ImplBase() {} // 定义基类析构为虚函数防止内存泄露
+        };
+
+        std::unique_ptr<ImplBase> impl;
+        uint64_t enqueue_time_ns = 0; // 线程池统计采样时记录的入队时间，0表示未采样
+
+        /* 封装任意类型的可调用对象 */
+        template<typename F>
+        class ImplType : public ImplBase {
+        private:
+            F f; // 保存可调用对象
+        public:
+            template<typename U>
+            explicit ImplType(U&& f_) : f(std::forward<U>(f_)) {}
+
+            void call() {
+                f();
+            }
+        };
+
+    public:
+        template<typename F>
+        FunctionWrapper(F&& f) : impl(new ImplType<std::decay_t<F>>(std::forward<F>(f))) {} // 万能引用接受任意参数，左值会被拷贝
+
+        void operator()() { // 定义为函数对象类型
+            impl->call();
+        }
+
+        explicit operator bool() const {
+            return impl != nullptr;
+        }
+
+        void set_enqueue_time(uint64_t ns) {
+            enqueue_time_ns = ns;
+        }
+
+        uint64_t enqueue_time() const {
+            return enqueue_time_ns;
+        }
+
+        FunctionWrapper() = default; // 默认的构造函数
+
+        FunctionWrapper(FunctionWrapper&& other) noexcept { // 移动构造函数
+            impl = std::move(other.impl);
+            enqueue_time_ns = other.enqueue_time_ns;
+        }
+
+        FunctionWrapper& operator=(FunctionWrapper&& other) noexcept { // 移动复制函数
+            impl = std::move(other.impl);
+            enqueue_time_ns = other.enqueue_time_ns;
+            return *this;
+        }
+
+        // 禁止拷贝
+        FunctionWrapper(const FunctionWrapper&) = delete;
+
+        FunctionWrapper& operator=(const FunctionWrapper&) = delete;
+    };
+}
+
+#endif //THREADPOOL_FUNCTION_WRAPPER_HPP
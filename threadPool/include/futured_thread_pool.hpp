@@ -7,79 +7,69 @@
 
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <vector>
 #include <future>
-
-#include "thread_safe_queue.hpp"
+#include <iterator>
+#include <type_traits>
+
+#include "cancellation.hpp"
+#include "cpu_topology.hpp"
+#include "elastic_scaler.hpp"
+#include "function_wrapper.hpp"
+#include "pool_telemetry.hpp"
+#include "priority_lanes.hpp"
 #include "threads_joiner.hpp"
 
 namespace zhaocc {
     class FuturedThreadPool {
     private:
-        /* 对任意类型的可调用对象进行封装，只支持move，不支持copy，主要用于对packaged_task封装 */
-        class FunctionWrapper {
-            /* 封装可调用对象基类 */
-            class ImplBase {
-            public:
-                virtual void call() = 0; // 纯虚函数
-                virtual ~ImplBase() {} // 定义基类析构为虚函数防止内存泄露
-            };
-
-            std::unique_ptr<ImplBase> impl;
+        std::atomic<bool> done; // 线程池所有任务是否将结束
+        Placement const placement; // 工作线程的放置策略
+        zhaocc::PriorityLanes<FunctionWrapper> work_queue; // 按优先级分开的任务队列
+        std::atomic<uint64_t> missed{0}; // 超过截止时间未执行的任务数量
+        zhaocc::CancellationSource cancel_source; // 以CANCEL_PENDING关闭时取消
+        std::atomic<bool> stopped{false}; // 是否已经调用过shutdown
+        zhaocc::PoolTelemetry telemetry; // 运行统计，每个工作线程位置一份
+        std::vector<std::thread> threads; // 所有工作线程，弹性模式下有空位置
+        zhaocc::ElasticScaler scaler; // 根据排队情况增减工作线程，必须放到threads后面
+        zhaocc::ThreadsJoiner threads_joiner; // threads joiner，帮助在线程池析构时能够等待所有线程工作结束，必须放到threads后面，这样析构的时候先析构它
 
-            /* 封装任意类型的可调用对象 */
-            template<typename F>
-            class ImplType : public ImplBase {
-            private:
-                F f; // 保存可调用对象
-            public:
-                ImplType(F&& f_) : f(std::move(f_)) {} // 使用万能引用来接受任意参数
+        inline static thread_local WorkerStats* local_stats = nullptr; // 当前工作线程的统计
+        inline static thread_local FuturedThreadPool* local_pool = nullptr; // 当前工作线程所属的线程池
 
-                void call() {
-                    f();
+        /* submit的任务在开始执行前检查线程池是否已被取消 */
+        template<typename FuncType>
+        auto cancellable(FuncType&& f) {
+            return [this, f = std::forward<FuncType>(f)]() mutable -> std::invoke_result_t<std::decay_t<FuncType>&> {
+                if (cancel_source.is_cancelled()) {
+                    throw OperationCancelled();
                 }
+                return f();
             };
+        }
 
-        public:
-            template<typename F>
-            FunctionWrapper(F&& f) : impl(new ImplType<F>(std::move(f))) {} // 万能引用接受任意参数
-
-            void operator()() { // 定义为函数对象类型
-                impl->call();
-            }
-
-            FunctionWrapper() = default; // 默认的构造函数
-
-            FunctionWrapper(FunctionWrapper&& other) noexcept { // 移动构造函数
-                impl = std::move(other.impl);
-            }
-
-            FunctionWrapper& operator=(FunctionWrapper&& other) noexcept { // 移动复制函数
-                impl = std::move(other.impl);
-                return *this;
-            }
-
-            // 禁止拷贝
-            FunctionWrapper(const FunctionWrapper&) = delete;
-
-            FunctionWrapper& operator=(const FunctionWrapper&) = delete;
-        };
-
-        std::atomic<bool> done; // 线程池所有任务是否将结束
-        zhaocc::ThreadSafeQueue<FunctionWrapper> work_queue; // 任务队列
-        std::vector<std::thread> threads; // 所有工作线程
-        zhaocc::ThreadsJoiner threads_joiner; // threads joiner，帮助在线程池析构时能够等待所有线程工作结束，必须放到threads后面，这样析构的时候先析构它
-
-        void worker_thread_func(); // 工作线程执行的函数
+        void worker_thread_func(unsigned slot); // 工作线程执行的函数，slot为该线程在threads中的位置
 
     public:
 
         /**
          * 构造函数
          * @param concurrent_count: 线程池中并发线程数量
+         * @param placement_: 工作线程的放置策略
+         */
+        explicit FuturedThreadPool(unsigned concurrent_count=std::thread::hardware_concurrency(),
+                                   Placement placement_ = Placement::NONE)
+                : FuturedThreadPool(ElasticOptions{concurrent_count, concurrent_count}, placement_) {}
+
+        /**
+         * 构造弹性线程池，线程数量在[min_threads, max_threads]之间根据排队时间变化
+         * @param options: 弹性伸缩的参数
+         * @param placement_: 工作线程的放置策略
          */
-        explicit FuturedThreadPool(unsigned concurrent_count=std::thread::hardware_concurrency());
+        explicit FuturedThreadPool(const ElasticOptions& options, Placement placement_ = Placement::NONE);
         ~FuturedThreadPool(); // 析构函数
 
         /**
@@ -89,62 +79,261 @@ namespace zhaocc {
          * @return 与可调用对象返回值相关联的future
          */
         template<typename FuncType>
-        std::future<typename std::result_of<FuncType()>::type> submit(FuncType&& f);
+        std::future<typename std::result_of<FuncType()>::type> submit(FuncType&& f) {
+            return submit(Priority::NORMAL, std::forward<FuncType>(f));
+        }
+
+        /**
+         * 按优先级提交任务
+         * @param priority: 任务的优先级
+         * @param f: 可调用对象
+         * @return 与可调用对象返回值相关联的future
+         */
+        template<typename FuncType>
+        std::future<typename std::result_of<FuncType()>::type> submit(Priority priority, FuncType&& f);
+
+        /**
+         * 提交有截止时间的任务，开始执行时已经超过截止时间则不执行，future中得到DeadlineMissed异常
+         * @param priority: 任务的优先级
+         * @param deadline: 截止时间
+         * @param f: 可调用对象
+         * @return 与可调用对象返回值相关联的future
+         */
+        template<typename FuncType>
+        std::future<typename std::result_of<FuncType()>::type>
+        submit(Priority priority, std::chrono::steady_clock::time_point deadline, FuncType f) {
+            return submit(priority, with_deadline(deadline, std::move(f), missed));
+        }
+
+        /**
+         * 批量提交任务，所有任务只获取一次任务队列的尾部锁
+         * @param first, last: 可调用对象的迭代器范围，可调用对象会被move
+         * @return 与每个可调用对象返回值相关联的future，顺序与输入一致
+         */
+        template<typename InputIt>
+        std::vector<std::future<typename std::result_of<typename std::iterator_traits<InputIt>::value_type()>::type>>
+        submit_bulk(InputIt first, InputIt last);
+
+        template<typename Range>
+        auto submit_bulk(Range&& tasks) -> decltype(submit_bulk(std::begin(tasks), std::end(tasks))) {
+            return submit_bulk(std::begin(tasks), std::end(tasks));
+        }
+
+        /**
+         * 批量提交count个任务，第i个任务执行f(i)
+         * @param count: 任务数量
+         * @param f: 可调用对象，参数为任务序号，会被拷贝到每个任务中
+         * @return 与每个任务返回值相关联的future
+         */
+        template<typename FuncType>
+        std::vector<std::future<typename std::result_of<FuncType(size_t)>::type>> submit_n(size_t count, FuncType f);
+
+        /**
+         * 提交不需要结果的任务，没有packaged_task和future的开销
+         * @param f: 可调用对象，会被move到任务队列中
+         */
+        template<typename FuncType>
+        void post(FuncType f) {
+            post(Priority::NORMAL, std::move(f));
+        }
+
+        template<typename FuncType>
+        void post(Priority priority, FuncType f);
 
         /**
          * 提供一个接口可以在调用者线程上执行任务
          */
         void run_pending_task();
+
+        /**
+         * 关闭线程池并等待所有工作线程退出，只有第一次调用有效，析构时以DRAIN方式调用
+         * 关闭期间仍然可以提交任务（例如正在执行的任务提交的子任务），工作线程退出后提交的任务不会被执行
+         * @param mode: 关闭方式
+         */
+        void shutdown(ShutdownMode mode = ShutdownMode::DRAIN);
+
+        /**
+         * 等待所有已提交的任务执行完（任务队列为空且没有正在执行的任务），等待期间在当前线程上帮助执行任务，
+         * 可以在两个批处理阶段之间调用，不能在工作线程上调用
+         */
+        void wait_idle();
+
+        /* 线程池的取消token，以CANCEL_PENDING关闭时被取消，长时间运行的任务可以检查它提前结束 */
+        CancellationToken cancellation_token() const {
+            return cancel_source.token();
+        }
+
+        /* 汇总运行统计，可以在任意线程随时调用 */
+        TelemetrySnapshot telemetry_snapshot() const {
+            return telemetry.snapshot(scaler.thread_count(), scaler.backlog());
+        }
+
+        /* 超过截止时间未执行的任务数量 */
+        uint64_t missed_deadlines() const {
+            return missed.load(std::memory_order_relaxed);
+        }
+
+        /* 当前运行中的工作线程数量 */
+        unsigned thread_count() const {
+            return scaler.thread_count();
+        }
     };
 
-    void FuturedThreadPool::worker_thread_func() {
+    inline void FuturedThreadPool::worker_thread_func(unsigned slot) {
+        CpuTopology::instance().pin_current_thread(placement, slot); // 绑定失败时继续由操作系统调度
+        WorkerStats& stats = telemetry.worker(slot);
+        local_stats = &stats;
+        local_pool = this;
+        bool idle = false;
+        std::chrono::steady_clock::time_point idle_since;
+
         while (!done) {
             FunctionWrapper task;
-
+            // 所有工作线程共用一个队列，没有可以被窃取的本地队列，所以每次只取一个任务：
+            // 批量取出的任务会被排在前面的长任务耽误，而此时其他工作线程可能空闲，之后入队的REALTIME任务也要等待
             if (work_queue.try_pop(task)) {
-                task(); // 当前有任务直接执行
+                stats.add(stats.main_pops);
+                scaler.on_dequeue();
+                PoolTelemetry::run(stats, task); // 当前有任务直接执行
+                idle = false;
+            } else if (!idle) { // 只在空闲时读取时钟
+                idle = true;
+                idle_since = std::chrono::steady_clock::now();
+                stats.add(stats.idle_spins);
+                std::this_thread::yield();
+            } else if (scaler.try_retire(slot, std::chrono::steady_clock::now() - idle_since)) {
+                break; // 空闲太久，退出工作线程
             } else {
+                stats.add(stats.idle_spins);
                 std::this_thread::yield(); // 当前无任务则调度出去
             }
 
             // work_queue.wait_and_pop(task); // 一直阻塞等待到有任务
             // task(); // 执行任务
         }
+        local_stats = nullptr;
+        local_pool = nullptr;
     }
 
-    FuturedThreadPool::FuturedThreadPool(unsigned concurrent_count) : done(false),
-                                             threads_joiner(threads) { // 将threads交付给threads_joiner管理，在线程池任务结束时等待所有线程
+    inline FuturedThreadPool::FuturedThreadPool(const ElasticOptions& options, Placement placement_)
+            : done(false), placement(placement_), telemetry(options.max_threads), scaler(options, threads),
+              threads_joiner(threads, &scaler.mutex()) { // 将threads交付给threads_joiner管理，在线程池任务结束时等待所有线程
         try {
-            for (unsigned i = 0; i < concurrent_count; i++) {
-                threads.emplace_back(&FuturedThreadPool::worker_thread_func, this); // 创建工作线程
-            }
+            scaler.start([this](unsigned slot) { // 创建工作线程，弹性模式下supervisor也通过它扩容
+                return std::thread(&FuturedThreadPool::worker_thread_func, this, slot);
+            });
         } catch (...) {
             done = true;
+            scaler.stop();
             throw;
         }
     }
 
-    FuturedThreadPool::~FuturedThreadPool() {
+    inline FuturedThreadPool::~FuturedThreadPool() {
+        shutdown(ShutdownMode::DRAIN);
+    }
+
+    inline void FuturedThreadPool::shutdown(ShutdownMode mode) {
+        if (stopped.exchange(true)) {
+            return;
+        }
+        if (mode == ShutdownMode::CANCEL_PENDING) {
+            cancel_source.cancel(); // 尚未开始的submit任务会很快以OperationCancelled结束
+        }
+        if (mode != ShutdownMode::ABANDON) {
+            wait_idle();
+        }
         done = true;
+        scaler.stop(); // 先停止扩容，再等待所有线程
+        threads_joiner.join_all();
+    }
+
+    inline void FuturedThreadPool::wait_idle() {
+        for (;;) {
+            // 入队计数在任务入队前累加，执行计数在任务执行完后累加，两次读到的入队计数相同并且等于执行计数时，
+            // 说明期间没有新任务，之前的任务都已经执行完
+            uint64_t const enqueued = scaler.enqueued_count();
+            if (telemetry.executed() == enqueued && scaler.enqueued_count() == enqueued) {
+                return;
+            }
+            run_pending_task();
+        }
     }
 
     template<typename FuncType>
-    std::future<typename std::result_of<FuncType()>::type> FuturedThreadPool::submit(FuncType&& f) { // 万能引用
+    std::future<typename std::result_of<FuncType()>::type>
+    FuturedThreadPool::submit(Priority priority, FuncType&& f) { // 万能引用
         using res_type = typename std::result_of<FuncType()>::type;
 
-        std::packaged_task<res_type()> task(std::forward<FuncType>(f)); // 完美转移
+        std::packaged_task<res_type()> task(cancellable(std::forward<FuncType>(f))); // 完美转移
         std::future<res_type> future_res(task.get_future());
 
-        work_queue.push(std::move(task));
+        FunctionWrapper wrapped(std::move(task));
+        PoolTelemetry::stamp(wrapped);
+        scaler.on_enqueue();
+        work_queue.push(priority, std::move(wrapped));
         return future_res;
     }
 
-    void FuturedThreadPool::run_pending_task() {
+    template<typename FuncType>
+    void FuturedThreadPool::post(Priority priority, FuncType f) {
+        FunctionWrapper wrapped(std::move(f));
+        PoolTelemetry::stamp(wrapped);
+        scaler.on_enqueue();
+        work_queue.push(priority, std::move(wrapped));
+    }
+
+    template<typename InputIt>
+    std::vector<std::future<typename std::result_of<typename std::iterator_traits<InputIt>::value_type()>::type>>
+    FuturedThreadPool::submit_bulk(InputIt first, InputIt last) {
+        using res_type = typename std::result_of<typename std::iterator_traits<InputIt>::value_type()>::type;
+
+        std::vector<FunctionWrapper> tasks;
+        std::vector<std::future<res_type>> futures;
+        for (; first != last; ++first) {
+            std::packaged_task<res_type()> task(cancellable(std::move(*first)));
+            futures.emplace_back(task.get_future());
+            tasks.emplace_back(std::move(task));
+            PoolTelemetry::stamp(tasks.back());
+        }
+
+        scaler.on_enqueue(tasks.size());
+        work_queue.push_bulk(Priority::NORMAL, std::make_move_iterator(tasks.begin()), std::make_move_iterator(tasks.end()));
+        return futures;
+    }
+
+    template<typename FuncType>
+    std::vector<std::future<typename std::result_of<FuncType(size_t)>::type>>
+    FuturedThreadPool::submit_n(size_t count, FuncType f) {
+        using res_type = typename std::result_of<FuncType(size_t)>::type;
+
+        std::vector<FunctionWrapper> tasks;
+        std::vector<std::future<res_type>> futures;
+        tasks.reserve(count);
+        futures.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            std::packaged_task<res_type()> task(cancellable([f, i]() { return f(i); }));
+            futures.emplace_back(task.get_future());
+            tasks.emplace_back(std::move(task));
+            PoolTelemetry::stamp(tasks.back());
+        }
+
+        scaler.on_enqueue(tasks.size());
+        work_queue.push_bulk(Priority::NORMAL, std::make_move_iterator(tasks.begin()), std::make_move_iterator(tasks.end()));
+        return futures;
+    }
+
+    inline void FuturedThreadPool::run_pending_task() {
         FunctionWrapper task;
+        bool const own = local_pool == this; // 其他线程池的工作线程调用时按非工作线程处理
+        WorkerStats& stats = own ? *local_stats : telemetry.external();
 
         if (work_queue.try_pop(task)) {
-            task(); // 当前有任务直接执行
+            stats.add(stats.main_pops);
+            scaler.on_dequeue();
+            PoolTelemetry::run(stats, task); // 当前有任务直接执行
         } else {
+            stats.add(stats.idle_spins);
             std::this_thread::yield(); // 当前无任务则调度出去
         }
     }
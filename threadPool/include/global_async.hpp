@@ -0,0 +1,145 @@
+/**
+ * 类似std::async的pool_async：任务提交到一个全局的、第一次使用时才创建的MultiQueueThreadPool（工作窃取），
+ * 线程数量固定，递归的分治算法可以随意调用，不会像每次创建std::thread那样耗尽线程。
+ * 1. 线程池已经饱和（尚未开始执行的任务数达到每个工作线程kSaturationPerThread个）时直接在调用线程上执行，
+ *    再多的排队任务不会带来更多的并行，只会增加调度开销。
+ * 2. get()时任务如果还没有被工作线程取走，由调用线程抢先执行（两边通过claimed标志只有一方执行），
+ *    这样等待方总是先完成自己的子任务，调用栈的深度与递归深度相同；
+ *    任务已经在其他线程上执行时，在当前线程上帮助执行线程池中的其他任务，帮助的嵌套深度有上限，超过后阻塞等待。
+ */
+
+#ifndef THREADPOOL_GLOBAL_ASYNC_HPP
+#define THREADPOOL_GLOBAL_ASYNC_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "multi_queue_thread_pool.hpp"
+
+namespace zhaocc {
+    class GlobalPool {
+    public:
+        static constexpr int64_t kSaturationPerThread = 4; // 每个工作线程排队的任务数达到该值时视为饱和
+        static constexpr unsigned kMaxHelpDepth = 8; // 等待时帮助执行其他任务的最大嵌套深度
+
+    private:
+        static unsigned& configured_threads() {
+            static unsigned threads = 0; // 0表示hardware_concurrency
+            return threads;
+        }
+
+    public:
+        /**
+         * 设置全局线程池的线程数量，必须在第一次使用之前调用
+         */
+        static void configure(unsigned threads) {
+            configured_threads() = threads;
+        }
+
+        /* 全局线程池，第一次调用时创建，进程退出时以DRAIN方式关闭 */
+        static MultiQueueThreadPool& instance() {
+            static MultiQueueThreadPool pool(configured_threads() != 0 ? configured_threads() :
+                                             std::max(1u, std::thread::hardware_concurrency()));
+            return pool;
+        }
+
+        static bool saturated() {
+            MultiQueueThreadPool& pool = instance();
+            return pool.pending_count() >= kSaturationPerThread * static_cast<int64_t>(pool.thread_count());
+        }
+
+        /* 当前线程在等待中帮助执行任务的嵌套深度 */
+        static unsigned& help_depth() {
+            thread_local unsigned depth = 0;
+            return depth;
+        }
+    };
+
+    template<typename R>
+    class AsyncFuture {
+    private:
+        struct State {
+            std::atomic<bool> claimed{false}; // 任务是否已经被某个线程取走执行
+            std::packaged_task<R()> task;
+
+            explicit State(std::packaged_task<R()> task_) : task(std::move(task_)) {}
+
+            /* 抢到执行权时执行任务 */
+            bool try_run() {
+                if (claimed.exchange(true, std::memory_order_acq_rel)) {
+                    return false;
+                }
+                task();
+                return true;
+            }
+        };
+
+        std::shared_ptr<State> state; // 已经在调用线程上执行过时为空
+        std::future<R> future;
+
+    public:
+        AsyncFuture() = default;
+
+        /* 由pool_async调用：饱和时立即执行，否则提交到全局线程池 */
+        explicit AsyncFuture(std::packaged_task<R()> task) {
+            future = task.get_future();
+            if (GlobalPool::saturated()) {
+                task(); // 饱和时直接在调用线程上执行
+                return;
+            }
+            state = std::make_shared<State>(std::move(task));
+            GlobalPool::instance().post([s = state]() { s->try_run(); });
+        }
+
+        bool valid() const {
+            return future.valid();
+        }
+
+        /* 等待任务完成：任务还在队列中则在本线程执行，已经在其他线程执行则帮助执行其他任务 */
+        void wait() {
+            if (state && state->try_run()) {
+                return;
+            }
+            MultiQueueThreadPool& pool = GlobalPool::instance();
+            unsigned& depth = GlobalPool::help_depth();
+            while (future.wait_for(std::chrono::seconds(0)) == std::future_status::timeout) {
+                if (depth >= GlobalPool::kMaxHelpDepth) {
+                    future.wait(); // 正在执行的任务只等待它自己的子任务，不会形成环，阻塞等待不会死锁
+                    break;
+                }
+                depth++;
+                pool.run_pending_task();
+                depth--;
+            }
+        }
+
+        R get() {
+            wait();
+            state.reset();
+            return future.get();
+        }
+    };
+
+    /**
+     * 在全局线程池中异步执行f(args...)，参数按值保存
+     * @return AsyncFuture，get()时会帮助执行任务，不会阻塞工作线程
+     */
+    template<typename F, typename... Args>
+    auto pool_async(F&& f, Args&& ... args) {
+        using result_type = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+        std::packaged_task<result_type()> task(
+                [f = std::forward<F>(f), tuple = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                    return std::apply(std::move(f), std::move(tuple));
+                });
+        return AsyncFuture<result_type>(std::move(task));
+    }
+}
+
+#endif //THREADPOOL_GLOBAL_ASYNC_HPP
@@ -5,92 +5,97 @@
 #ifndef THREADPOOL_MULTI_QUEUE_THREAD_POOL_HPP
 #define THREADPOOL_MULTI_QUEUE_THREAD_POOL_HPP
 
+#include <algorithm>
 #include <memory>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <vector>
 #include <future>
-
+#include <iterator>
+#include <type_traits>
+
+#include "cancellation.hpp"
+#include "cpu_topology.hpp"
+#include "elastic_scaler.hpp"
+#include "function_wrapper.hpp"
+#include "pool_telemetry.hpp"
+#include "priority_lanes.hpp"
 #include "thread_safe_queue.hpp"
 #include "threads_joiner.hpp"
 
 namespace zhaocc {
     class MultiQueueThreadPool {
     private:
-    private:
-        /* 对任意类型的可调用对象进行封装，只支持move，不支持copy，主要用于对packaged_task封装 */
-        class FunctionWrapper {
-            /* 封装可调用对象基类 */
-            class ImplBase {
-            public:
-                virtual void call() = 0; // 纯虚函数
-                virtual ~ImplBase() {} // 定义基类析构为虚函数防止内存泄露
-            };
-
-            std::unique_ptr<ImplBase> impl;
-
-            /* 封装任意类型的可调用对象 */
-            template<typename F>
-            class ImplType : public ImplBase {
-            private:
-                F f; // 保存可调用对象
-            public:
-                ImplType(F&& f_) : f(std::move(f_)) {} // 使用万能引用来接受任意参数
-
-                void call() {
-                    f();
-                }
-            };
-
-        public:
-            template<typename F>
-            FunctionWrapper(F&& f) : impl(new ImplType<F>(std::move(f))) {} // 万能引用接受任意参数
-
-            void operator()() { // 定义为函数对象类型
-                impl->call();
-            }
-
-            FunctionWrapper() = default; // 默认的构造函数
-
-            FunctionWrapper(FunctionWrapper&& other) noexcept { // 移动构造函数
-                impl = std::move(other.impl);
-            }
-
-            FunctionWrapper& operator=(FunctionWrapper&& other) noexcept { // 移动复制函数
-                impl = std::move(other.impl);
-                return *this;
-            }
-
-            // 禁止拷贝
-            FunctionWrapper(const FunctionWrapper&) = delete;
-
-            FunctionWrapper& operator=(const FunctionWrapper&) = delete;
-        };
+        static constexpr size_t kDequeueBatch = 4; // 工作线程每次从主任务队列中最多取出的任务数量
+        static constexpr unsigned kRealtimeStreak = 8; // REALTIME任务最多连续插队的次数，之后执行一次本线程队列中的任务
+        static constexpr unsigned kLocalStreak = 16; // 本线程队列最多连续执行的次数，之后先从主任务队列按权重取一次
 
         std::atomic<bool> done; // 线程池所有任务是否将结束
-        ThreadSafeQueue <FunctionWrapper> main_work_queue; // 主任务队列，用于所有工作线程公用
+        Placement const placement; // 工作线程的放置策略
+        PriorityLanes <FunctionWrapper> main_work_queue; // 按优先级分开的主任务队列，用于所有工作线程公用
+        std::atomic<uint64_t> missed{0}; // 超过截止时间未执行的任务数量
+        CancellationSource cancel_source; // 以CANCEL_PENDING关闭时取消
+        std::atomic<bool> stopped{false}; // 是否已经调用过shutdown
+        PoolTelemetry telemetry; // 运行统计，每个工作线程位置一份
         std::vector<std::unique_ptr<ThreadSafeQueue < FunctionWrapper>>>
-        sub_work_queues; // 子任务队列，对于每一个工作线程都有一个单独的任务队列
-        std::vector<std::thread> threads; // 所有工作线程
+        sub_work_queues; // 子任务队列，对于每一个工作线程的位置都有一个单独的任务队列，按最大线程数量创建
+        std::vector<std::vector<unsigned>> steal_orders; // 每个位置窃取任务时依次尝试的队列，绑定时同一NUMA节点的排在前面
+        std::vector<std::thread> threads; // 所有工作线程，弹性模式下有空位置
+        ElasticScaler scaler; // 根据排队情况增减工作线程，必须放到threads后面
         ThreadsJoiner threads_joiner; // threads joiner，帮助在线程池析构时能够等待所有线程工作结束，必须放到threads后面，这样析构的时候先析构它
 
-        static thread_local ThreadSafeQueue <FunctionWrapper>* local_work_queue; // 当前工作线程的任务队列指针
-        static thread_local unsigned my_index; // 当前工作线程的任务队列在sub_work_queues中的位置
+        inline static thread_local ThreadSafeQueue <FunctionWrapper>* local_work_queue = nullptr; // 当前工作线程的任务队列指针
+        inline static thread_local unsigned my_index = 0; // 当前工作线程的任务队列在sub_work_queues中的位置
+        inline static thread_local unsigned realtime_streak = 0; // 当前工作线程连续执行插队的REALTIME任务的次数
+        inline static thread_local unsigned local_streak = 0; // 当前工作线程连续执行本线程队列中任务的次数
+        inline static thread_local WorkerStats* local_stats = nullptr; // 当前工作线程的统计
+        inline static thread_local MultiQueueThreadPool* local_pool = nullptr; // 当前工作线程所属的线程池
+
+        /* 当前线程是本线程池的工作线程时返回它的任务队列，否则（包括其他线程池的工作线程）返回空 */
+        ThreadSafeQueue <FunctionWrapper>* own_queue() const {
+            return local_pool == this ? local_work_queue : nullptr;
+        }
+
+        /* submit的任务在开始执行前检查线程池是否已被取消 */
+        template<typename FuncType>
+        auto cancellable(FuncType&& f) {
+            return [this, f = std::forward<FuncType>(f)]() mutable -> std::invoke_result_t<std::decay_t<FuncType>&> {
+                if (cancel_source.is_cancelled()) {
+                    throw OperationCancelled();
+                }
+                return f();
+            };
+        }
 
         void worker_thread_func(unsigned my_index_); // 工作线程执行的函数
 
+        bool pop_task_from_realtime_lane(FunctionWrapper& task); // 在本线程队列之前获取REALTIME任务
         bool pop_task_from_local_queue(FunctionWrapper& task); // 从工作线程的任务队列中获取任务
         bool pop_task_from_main_queue(FunctionWrapper& task); // 从线程池的主任务队列中获取任务
         bool pop_task_from_other_thread_queue(FunctionWrapper& task); // 从其他工作线程的任务队列中窃取任务
+        bool try_run_pending_task(WorkerStats& stats); // 获取并执行一个任务，没有任务时返回false
+        void push_tasks(std::vector<FunctionWrapper>& tasks); // 批量放入当前线程的任务队列或者主任务队列
 
     public:
 
         /**
          * 构造函数
          * @param concurrent_count: 线程池中并发线程数量
+         * @param placement_: 工作线程的放置策略
+         */
+        explicit MultiQueueThreadPool(unsigned concurrent_count = std::thread::hardware_concurrency(),
+                                      Placement placement_ = Placement::NONE)
+                : MultiQueueThreadPool(ElasticOptions{concurrent_count, concurrent_count}, placement_) {}
+
+        /**
+         * 构造弹性线程池，线程数量在[min_threads, max_threads]之间根据排队时间变化
+         * @param options: 弹性伸缩的参数
+         * @param placement_: 工作线程的放置策略
          */
-        explicit MultiQueueThreadPool(unsigned concurrent_count = std::thread::hardware_concurrency());
+        explicit MultiQueueThreadPool(const ElasticOptions& options, Placement placement_ = Placement::NONE);
 
         ~MultiQueueThreadPool(); // 析构函数
 
@@ -101,94 +106,376 @@ namespace zhaocc {
          * @return 与可调用对象返回值相关联的future
          */
         template<typename FuncType>
-        std::future<typename std::result_of<FuncType()>::type> submit(FuncType&& f);
+        std::future<typename std::result_of<FuncType()>::type> submit(FuncType&& f) {
+            return submit(Priority::NORMAL, std::forward<FuncType>(f));
+        }
+
+        /**
+         * 按优先级提交任务，NORMAL以外的任务总是放到主任务队列中对应优先级的队列
+         * @param priority: 任务的优先级
+         * @param f: 可调用对象
+         * @return 与可调用对象返回值相关联的future
+         */
+        template<typename FuncType>
+        std::future<typename std::result_of<FuncType()>::type> submit(Priority priority, FuncType&& f);
+
+        /**
+         * 提交有截止时间的任务，开始执行时已经超过截止时间则不执行，future中得到DeadlineMissed异常
+         * @param priority: 任务的优先级
+         * @param deadline: 截止时间
+         * @param f: 可调用对象
+         * @return 与可调用对象返回值相关联的future
+         */
+        template<typename FuncType>
+        std::future<typename std::result_of<FuncType()>::type>
+        submit(Priority priority, std::chrono::steady_clock::time_point deadline, FuncType f) {
+            return submit(priority, with_deadline(deadline, std::move(f), missed));
+        }
+
+        /**
+         * 批量提交任务，所有任务只获取一次任务队列的尾部锁
+         * @param first, last: 可调用对象的迭代器范围，可调用对象会被move
+         * @return 与每个可调用对象返回值相关联的future，顺序与输入一致
+         */
+        template<typename InputIt>
+        std::vector<std::future<typename std::result_of<typename std::iterator_traits<InputIt>::value_type()>::type>>
+        submit_bulk(InputIt first, InputIt last);
+
+        template<typename Range>
+        auto submit_bulk(Range&& tasks) -> decltype(submit_bulk(std::begin(tasks), std::end(tasks))) {
+            return submit_bulk(std::begin(tasks), std::end(tasks));
+        }
+
+        /**
+         * 批量提交count个任务，第i个任务执行f(i)
+         * @param count: 任务数量
+         * @param f: 可调用对象，参数为任务序号，会被拷贝到每个任务中
+         * @return 与每个任务返回值相关联的future
+         */
+        template<typename FuncType>
+        std::vector<std::future<typename std::result_of<FuncType(size_t)>::type>> submit_n(size_t count, FuncType f);
+
+        /**
+         * 提交不需要结果的任务，没有packaged_task和future的开销
+         * @param f: 可调用对象，会被move到任务队列中
+         */
+        template<typename FuncType>
+        void post(FuncType f) {
+            post(Priority::NORMAL, std::move(f));
+        }
+
+        template<typename FuncType>
+        void post(Priority priority, FuncType f);
 
         /**
          * 提供一个接口可以在调用者线程上执行任务
          */
         void run_pending_task();
-    };
 
-    thread_local ThreadSafeQueue <MultiQueueThreadPool::FunctionWrapper>* MultiQueueThreadPool::local_work_queue = nullptr;
-    thread_local unsigned MultiQueueThreadPool::my_index = 0;
+        /**
+         * 关闭线程池并等待所有工作线程退出，只有第一次调用有效，析构时以DRAIN方式调用
+         * 关闭期间仍然可以提交任务（例如正在执行的任务提交的子任务），工作线程退出后提交的任务不会被执行
+         * @param mode: 关闭方式
+         */
+        void shutdown(ShutdownMode mode = ShutdownMode::DRAIN);
 
-    void MultiQueueThreadPool::worker_thread_func(unsigned my_index_) {
+        /**
+         * 等待所有已提交的任务执行完（任务队列为空且没有正在执行的任务），等待期间在当前线程上帮助执行任务，
+         * 可以在两个批处理阶段之间调用，不能在工作线程上调用
+         */
+        void wait_idle();
+
+        /* 线程池的取消token，以CANCEL_PENDING关闭时被取消，长时间运行的任务可以检查它提前结束 */
+        CancellationToken cancellation_token() const {
+            return cancel_source.token();
+        }
+
+        /* 汇总运行统计，可以在任意线程随时调用 */
+        TelemetrySnapshot telemetry_snapshot() const {
+            return telemetry.snapshot(scaler.thread_count(), scaler.backlog());
+        }
+
+        /* 超过截止时间未执行的任务数量 */
+        uint64_t missed_deadlines() const {
+            return missed.load(std::memory_order_relaxed);
+        }
+
+        /* 当前运行中的工作线程数量 */
+        unsigned thread_count() const {
+            return scaler.thread_count();
+        }
+
+        /* 已提交、尚未开始执行的任务数量，近似值，不加锁 */
+        int64_t pending_count() const {
+            return scaler.backlog();
+        }
+    };
+
+    inline void MultiQueueThreadPool::worker_thread_func(unsigned my_index_) {
         // 当前工作线程获取对应的任务队列
         my_index = my_index_;
+        CpuTopology::instance().pin_current_thread(placement, my_index_); // 绑定失败时继续由操作系统调度
         local_work_queue = sub_work_queues[my_index_].get();
+        WorkerStats& stats = telemetry.worker(my_index_);
+        local_stats = &stats;
+        local_pool = this;
+        bool idle = false;
+        std::chrono::steady_clock::time_point idle_since;
 
         while (!done) {
-            run_pending_task();
+            if (try_run_pending_task(stats)) {
+                idle = false;
+            } else if (!idle) { // 只在空闲时读取时钟
+                idle = true;
+                idle_since = std::chrono::steady_clock::now();
+                stats.add(stats.idle_spins);
+                std::this_thread::yield();
+            } else if (local_work_queue->empty() && // 只有当前线程会向自己的任务队列放任务，为空时退出不会遗留任务
+                       scaler.try_retire(my_index, std::chrono::steady_clock::now() - idle_since)) {
+                break; // 空闲太久，退出工作线程，任务队列留给之后复用该位置的线程
+            } else {
+                stats.add(stats.idle_spins);
+                std::this_thread::yield(); // 当前无任务则调度出去
+            }
         }
+        local_work_queue = nullptr;
+        local_stats = nullptr;
+        local_pool = nullptr;
     }
 
-    MultiQueueThreadPool::MultiQueueThreadPool(unsigned concurrent_count)
-            : done(false), threads_joiner(threads) { // 将threads交付给threads_joiner管理，在线程池任务结束时等待所有线程
+    inline MultiQueueThreadPool::MultiQueueThreadPool(const ElasticOptions& options, Placement placement_)
+            : done(false), placement(placement_), telemetry(options.max_threads), scaler(options, threads),
+              threads_joiner(threads, &scaler.mutex()) { // 将threads交付给threads_joiner管理，在线程池任务结束时等待所有线程
         try {
-            for (unsigned i = 0; i < concurrent_count; i++) {
+            for (unsigned i = 0; i < scaler.max_threads(); i++) { // 先创建好所有任务队列，工作线程窃取任务时会遍历sub_work_queues
                 sub_work_queues.emplace_back(
                         std::make_unique<ThreadSafeQueue<FunctionWrapper>>()); // 每个工作线程都对应一个工作队列
-                threads.emplace_back(std::thread(&MultiQueueThreadPool::worker_thread_func, this, i)); // 创建工作线程
             }
+            CpuTopology const& topology = CpuTopology::instance();
+            unsigned const slots = scaler.max_threads();
+            for (unsigned slot = 0; slot < slots; slot++) { // 从下一个位置开始环形遍历，最后是自己
+                std::vector<unsigned> order;
+                for (unsigned i = 1; i <= slots; i++) {
+                    order.push_back((slot + i) % slots);
+                }
+                if (placement != Placement::NONE) { // 同一节点的队列排在前面，减少跨节点访问任务数据
+                    std::stable_partition(order.begin(), order.end(), [&](unsigned victim) {
+                        return topology.node_for_slot(victim) == topology.node_for_slot(slot);
+                    });
+                }
+                steal_orders.push_back(std::move(order));
+            }
+            scaler.start([this](unsigned slot) { // 创建工作线程，弹性模式下supervisor也通过它扩容
+                return std::thread(&MultiQueueThreadPool::worker_thread_func, this, slot);
+            });
         } catch (...) {
             done = true;
+            scaler.stop();
             throw;
         }
     }
 
-    MultiQueueThreadPool::~MultiQueueThreadPool() {
+    inline MultiQueueThreadPool::~MultiQueueThreadPool() {
+        shutdown(ShutdownMode::DRAIN);
+    }
+
+    inline void MultiQueueThreadPool::shutdown(ShutdownMode mode) {
+        if (stopped.exchange(true)) {
+            return;
+        }
+        if (mode == ShutdownMode::CANCEL_PENDING) {
+            cancel_source.cancel(); // 尚未开始的submit任务会很快以OperationCancelled结束
+        }
+        if (mode != ShutdownMode::ABANDON) {
+            wait_idle();
+        }
         done = true;
+        scaler.stop(); // 先停止扩容，再等待所有线程
+        threads_joiner.join_all();
+    }
+
+    inline void MultiQueueThreadPool::wait_idle() {
+        for (;;) {
+            // 入队计数在任务入队前累加，执行计数在任务执行完后累加，两次读到的入队计数相同并且等于执行计数时，
+            // 说明期间没有新任务，之前的任务都已经执行完
+            uint64_t const enqueued = scaler.enqueued_count();
+            if (telemetry.executed() == enqueued && scaler.enqueued_count() == enqueued) {
+                return;
+            }
+            run_pending_task();
+        }
     }
 
     template<typename FuncType>
-    std::future<typename std::result_of<FuncType()>::type> MultiQueueThreadPool::submit(FuncType&& f) { // 万能引用
+    std::future<typename std::result_of<FuncType()>::type>
+    MultiQueueThreadPool::submit(Priority priority, FuncType&& f) { // 万能引用
         using res_type = typename std::result_of<FuncType()>::type;
 
-        std::packaged_task<res_type()> task(std::forward<FuncType>(f)); // 完美转移
+        std::packaged_task<res_type()> task(cancellable(std::forward<FuncType>(f))); // 完美转移
         std::future<res_type> future_res(task.get_future());
 
-        if (local_work_queue) { // 如果当前线程有工作队列，将任务放到本线程的工作队列中
-            local_work_queue->push(std::move(task));
+        FunctionWrapper wrapped(std::move(task));
+        PoolTelemetry::stamp(wrapped);
+        scaler.on_enqueue();
+        ThreadSafeQueue<FunctionWrapper>* const queue = own_queue();
+        if (queue && priority == Priority::NORMAL) { // 如果当前线程有工作队列，将任务放到本线程的工作队列中
+            queue->push(std::move(wrapped));
         } else {
-            main_work_queue.push(std::move(task));
+            main_work_queue.push(priority, std::move(wrapped));
         }
         return future_res;
     }
 
-    bool MultiQueueThreadPool::pop_task_from_local_queue(FunctionWrapper& task) {
-        return local_work_queue && local_work_queue->try_pop(task);
+    template<typename FuncType>
+    void MultiQueueThreadPool::post(Priority priority, FuncType f) {
+        FunctionWrapper wrapped(std::move(f));
+        PoolTelemetry::stamp(wrapped);
+        scaler.on_enqueue();
+        ThreadSafeQueue<FunctionWrapper>* const queue = own_queue();
+        if (queue && priority == Priority::NORMAL) { // 与submit一致
+            queue->push(std::move(wrapped));
+        } else {
+            main_work_queue.push(priority, std::move(wrapped));
+        }
     }
 
-    bool MultiQueueThreadPool::pop_task_from_main_queue(FunctionWrapper& task) {
-        return main_work_queue.try_pop(task);
+    inline void MultiQueueThreadPool::push_tasks(std::vector<FunctionWrapper>& tasks) {
+        for (auto& task : tasks) {
+            PoolTelemetry::stamp(task);
+        }
+        auto first = std::make_move_iterator(tasks.begin());
+        auto last = std::make_move_iterator(tasks.end());
+        scaler.on_enqueue(tasks.size());
+        ThreadSafeQueue<FunctionWrapper>* const queue = own_queue();
+        if (queue) { // 与submit一致，工作线程提交的任务放到本线程的工作队列中
+            queue->push_bulk(first, last);
+        } else {
+            main_work_queue.push_bulk(Priority::NORMAL, first, last);
+        }
+    }
+
+    template<typename InputIt>
+    std::vector<std::future<typename std::result_of<typename std::iterator_traits<InputIt>::value_type()>::type>>
+    MultiQueueThreadPool::submit_bulk(InputIt first, InputIt last) {
+        using res_type = typename std::result_of<typename std::iterator_traits<InputIt>::value_type()>::type;
+
+        std::vector<FunctionWrapper> tasks;
+        std::vector<std::future<res_type>> futures;
+        for (; first != last; ++first) {
+            std::packaged_task<res_type()> task(cancellable(std::move(*first)));
+            futures.emplace_back(task.get_future());
+            tasks.emplace_back(std::move(task));
+        }
+
+        push_tasks(tasks);
+        return futures;
+    }
+
+    template<typename FuncType>
+    std::vector<std::future<typename std::result_of<FuncType(size_t)>::type>>
+    MultiQueueThreadPool::submit_n(size_t count, FuncType f) {
+        using res_type = typename std::result_of<FuncType(size_t)>::type;
+
+        std::vector<FunctionWrapper> tasks;
+        std::vector<std::future<res_type>> futures;
+        tasks.reserve(count);
+        futures.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            std::packaged_task<res_type()> task(cancellable([f, i]() { return f(i); }));
+            futures.emplace_back(task.get_future());
+            tasks.emplace_back(std::move(task));
+        }
+
+        push_tasks(tasks);
+        return futures;
+    }
+
+    inline bool MultiQueueThreadPool::pop_task_from_realtime_lane(FunctionWrapper& task) {
+        // REALTIME任务可以插到本线程队列中的任务前面，但连续插队kRealtimeStreak次后让本线程队列执行一次，防止其被饿死
+        if (!own_queue() || !main_work_queue.has(Priority::REALTIME) || realtime_streak >= kRealtimeStreak) {
+            realtime_streak = 0;
+            return false;
+        }
+        if (main_work_queue.try_pop(Priority::REALTIME, task)) {
+            realtime_streak++;
+            return true;
+        }
+        realtime_streak = 0;
+        return false;
+    }
+
+    inline bool MultiQueueThreadPool::pop_task_from_local_queue(FunctionWrapper& task) {
+        ThreadSafeQueue<FunctionWrapper>* const queue = own_queue();
+        return queue && queue->try_pop(task);
     }
 
-    bool MultiQueueThreadPool::pop_task_from_other_thread_queue(FunctionWrapper& task) {
-        for (unsigned i = 0; i < sub_work_queues.size(); i++) { // 尝试从每一个其他工作线程中窃取任务
-            unsigned const ind = (my_index + i + 1) % sub_work_queues.size();
+    inline bool MultiQueueThreadPool::pop_task_from_main_queue(FunctionWrapper& task) {
+        ThreadSafeQueue<FunctionWrapper>* const queue = own_queue();
+        if (!queue) { // 非工作线程只取一个任务
+            return main_work_queue.try_pop(task);
+        }
+
+        // 工作线程一次取出一小批任务，执行第一个，其余放到本线程的任务队列中，仍然可以被其他工作线程窃取；
+        // 本线程队列中只有NORMAL任务，所以除第一个以外只批量取NORMAL任务，REALTIME和BACKGROUND任务不会被提前或者推后
+        std::vector<FunctionWrapper> batch;
+        batch.reserve(kDequeueBatch);
+        if (main_work_queue.try_pop_bulk(std::back_inserter(batch), kDequeueBatch) == 0) {
+            return false;
+        }
+        task = std::move(batch.front());
+        queue->push_bulk(std::make_move_iterator(batch.begin() + 1), std::make_move_iterator(batch.end()));
+        return true;
+    }
+
+    inline bool MultiQueueThreadPool::pop_task_from_other_thread_queue(FunctionWrapper& task) {
+        if (steal_orders.empty()) {
+            return false;
+        }
+        // 尝试从每一个其他工作线程中窃取任务，my_index可能来自另一个线程池的工作线程
+        for (unsigned ind : steal_orders[my_index % steal_orders.size()]) {
             if (sub_work_queues[ind]->try_pop(task)) {
-                std::cout << "[thread-" << std::this_thread::get_id() << " index-" << my_index
-                          << "] got task from other task queue with index " << ind << "." << std::endl;
                 return true;
             }
         }
         return false;
     }
 
-    void MultiQueueThreadPool::run_pending_task() {
+    inline bool MultiQueueThreadPool::try_run_pending_task(WorkerStats& stats) {
         FunctionWrapper task;
 
-        if (pop_task_from_local_queue(task)) {
-            std::cout << "[thread-" << std::this_thread::get_id() << " index-" << my_index
-                      << "] got task from local queue." << std::endl;
-            task(); // 当前有任务直接执行
+        // 本线程队列连续执行kLocalStreak次后先从主任务队列取一次，防止不断产生的本地任务饿死主任务队列中的BACKGROUND任务
+        bool const main_first = local_streak >= kLocalStreak;
+        if (main_first) {
+            local_streak = 0;
+        }
+
+        // 按执行前取出任务的来源计数，local_pops + main_pops + stolen == executed
+        if (pop_task_from_realtime_lane(task)) {
+            stats.add(stats.main_pops);
+        } else if (main_first && pop_task_from_main_queue(task)) {
+            stats.add(stats.main_pops);
+        } else if (pop_task_from_local_queue(task)) {
+            stats.add(stats.local_pops);
+            local_streak++;
         } else if (pop_task_from_main_queue(task)) {
-            std::cout << "[thread-" << std::this_thread::get_id() << " index-" << my_index
-                      << "] got task from main queue." << std::endl;
-            task();
+            stats.add(stats.main_pops);
+            local_streak = 0; // 本线程队列已经为空
         } else if (pop_task_from_other_thread_queue(task)) {
-            task();
+            stats.add(stats.stolen);
+            local_streak = 0;
         } else {
+            stats.add(stats.failed_steals);
+            return false;
+        }
+        scaler.on_dequeue();
+        PoolTelemetry::run(stats, task); // 当前有任务直接执行
+        return true;
+    }
+
+    inline void MultiQueueThreadPool::run_pending_task() {
+        WorkerStats& stats = local_pool == this ? *local_stats : telemetry.external();
+        if (!try_run_pending_task(stats)) {
+            stats.add(stats.idle_spins);
             std::this_thread::yield(); // 当前无任务则调度出去
         }
     }
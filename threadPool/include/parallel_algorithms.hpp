@@ -0,0 +1,196 @@
+/**
+ * 基于线程池（MultiQueueThreadPool或FuturedThreadPool）实现的并行算法：parallel_for、parallel_reduce、parallel_transform、parallel_scan。
+ * 区间递归二分，一半提交到线程池，另一半在本线程继续拆分，直到不大于grain；等待子任务时本线程通过run_pending_task执行线程池中的任务，
+ * 不会阻塞也不会死锁。在MultiQueueThreadPool上，工作线程拆分出来的子任务放在自己的任务队列中，空闲的工作线程会来窃取。
+ * 区间可以是整数下标[first, last)，也可以是随机访问迭代器。
+ */
+
+#ifndef THREADPOOL_PARALLEL_ALGORITHMS_HPP
+#define THREADPOOL_PARALLEL_ALGORITHMS_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <vector>
+
+namespace zhaocc {
+    namespace detail {
+        /* 等待future就绪，等待期间在本线程执行线程池中的任务 */
+        template<typename ThreadPoolType, typename FutureType>
+        void wait_and_help(ThreadPoolType& pool, FutureType& future) {
+            while (future.wait_for(std::chrono::milliseconds(0)) == std::future_status::timeout) {
+                pool.run_pending_task();
+            }
+        }
+
+        /* grain为0时自动选择：每个线程（包括调用者线程）大约分到8块，既能均衡负载，又不会拆得太碎 */
+        template<typename ThreadPoolType>
+        size_t auto_grain(ThreadPoolType& pool, size_t len, size_t grain) {
+            if (grain > 0) {
+                return grain;
+            }
+            size_t const chunks = (pool.thread_count() + 1) * 8;
+            return std::max<size_t>(1, (len + chunks - 1) / chunks);
+        }
+
+        template<typename ThreadPoolType, typename Iterator, typename Body>
+        void parallel_for_impl(ThreadPoolType& pool, Iterator first, Iterator last, size_t grain, Body& body) {
+            size_t const len = last - first;
+            if (len <= grain) {
+                body(first, last);
+                return;
+            }
+
+            Iterator const mid = first + len / 2;
+            std::future<void> right = pool.submit([&pool, mid, last, grain, &body]() {
+                parallel_for_impl(pool, mid, last, grain, body);
+            });
+            try {
+                parallel_for_impl(pool, first, mid, grain, body);
+            } catch (...) {
+                wait_and_help(pool, right); // 子任务引用了body，必须等它结束才能把异常抛出去
+                throw;
+            }
+            wait_and_help(pool, right);
+            right.get(); // 传递子任务中的异常
+        }
+
+        template<typename ThreadPoolType, typename Iterator, typename T, typename Reduce, typename Combine>
+        T parallel_reduce_impl(ThreadPoolType& pool, Iterator first, Iterator last, size_t grain, const T& identity,
+                               Reduce& reduce, Combine& combine) {
+            size_t const len = last - first;
+            if (len <= grain) {
+                return reduce(first, last, identity);
+            }
+
+            Iterator const mid = first + len / 2;
+            std::future<T> right = pool.submit([&pool, mid, last, grain, &identity, &reduce, &combine]() {
+                return parallel_reduce_impl(pool, mid, last, grain, identity, reduce, combine);
+            });
+            T left = [&]() {
+                try {
+                    return parallel_reduce_impl(pool, first, mid, grain, identity, reduce, combine);
+                } catch (...) {
+                    wait_and_help(pool, right);
+                    throw;
+                }
+            }();
+            wait_and_help(pool, right);
+            return combine(std::move(left), right.get());
+        }
+    }
+
+    /**
+     * 并行执行body
+     * @param pool: 线程池
+     * @param first, last: 区间，整数下标或者随机访问迭代器
+     * @param grain: 不再拆分的最大区间长度，为0时根据线程池大小自动选择
+     * @param body: 可调用对象，参数为子区间(sub_first, sub_last)，会被多个线程同时调用
+     */
+    template<typename ThreadPoolType, typename Iterator, typename Body>
+    void parallel_for(ThreadPoolType& pool, Iterator first, Iterator last, size_t grain, Body body) {
+        if (first == last) {
+            return;
+        }
+        detail::parallel_for_impl(pool, first, last, detail::auto_grain(pool, last - first, grain), body);
+    }
+
+    /**
+     * 并行归约
+     * @param identity: 归约的单位元，每个子区间都从它开始归约
+     * @param reduce: 可调用对象，(sub_first, sub_last, identity) -> T，串行归约一个子区间
+     * @param combine: 可调用对象，(T, T) -> T，合并相邻两个子区间的结果，需要满足结合律
+     * @return 整个区间的归约结果
+     */
+    template<typename ThreadPoolType, typename Iterator, typename T, typename Reduce, typename Combine>
+    T parallel_reduce(ThreadPoolType& pool, Iterator first, Iterator last, size_t grain, T identity, Reduce reduce,
+                      Combine combine) {
+        if (first == last) {
+            return identity;
+        }
+        return detail::parallel_reduce_impl(pool, first, last, detail::auto_grain(pool, last - first, grain),
+                                            identity, reduce, combine);
+    }
+
+    /**
+     * 并行归约迭代器区间中的元素，combine同时用于子区间内部和子区间之间
+     */
+    template<typename ThreadPoolType, typename Iterator, typename T, typename Combine>
+    T parallel_reduce(ThreadPoolType& pool, Iterator first, Iterator last, size_t grain, T identity, Combine combine) {
+        return parallel_reduce(pool, first, last, grain, identity,
+                               [&combine](Iterator sub_first, Iterator sub_last, T init) {
+                                   for (; sub_first != sub_last; ++sub_first) {
+                                       init = combine(std::move(init), *sub_first);
+                                   }
+                                   return init;
+                               }, combine);
+    }
+
+    /**
+     * 并行变换，d_first[i] = op(first[i])
+     * @param d_first: 输出区间的起点，随机访问迭代器，不能与输入区间部分重叠
+     * @return 输出区间的终点
+     */
+    template<typename ThreadPoolType, typename InputIt, typename OutputIt, typename UnaryOp>
+    OutputIt parallel_transform(ThreadPoolType& pool, InputIt first, InputIt last, OutputIt d_first, size_t grain,
+                                UnaryOp op) {
+        parallel_for(pool, first, last, grain, [first, d_first, &op](InputIt sub_first, InputIt sub_last) {
+            std::transform(sub_first, sub_last, d_first + (sub_first - first), op);
+        });
+        return d_first + (last - first);
+    }
+
+    /**
+     * 并行包含式前缀和，d_first[i] = identity op first[0] op ... op first[i]
+     * 分两遍：第一遍并行求出每一块的和，串行求出每一块的起始前缀，第二遍并行在每一块内做前缀和。
+     * @param identity: op的单位元
+     * @param op: 满足结合律的二元运算
+     * @return 输出区间的终点
+     */
+    template<typename ThreadPoolType, typename InputIt, typename OutputIt, typename T, typename BinaryOp>
+    OutputIt parallel_scan(ThreadPoolType& pool, InputIt first, InputIt last, OutputIt d_first, size_t grain,
+                           T identity, BinaryOp op) {
+        size_t const len = last - first;
+        if (len == 0) {
+            return d_first;
+        }
+        grain = detail::auto_grain(pool, len, grain);
+        size_t const block_count = (len + grain - 1) / grain;
+
+        std::vector<T> block_sums(block_count, identity);
+        parallel_for(pool, size_t(0), block_count, 1, [&](size_t sub_first, size_t sub_last) {
+            for (size_t b = sub_first; b < sub_last; b++) {
+                InputIt it = first + b * grain;
+                InputIt const end = first + std::min(len, (b + 1) * grain);
+                T sum = identity;
+                for (; it != end; ++it) {
+                    sum = op(std::move(sum), *it);
+                }
+                block_sums[b] = std::move(sum);
+            }
+        });
+
+        T prefix = identity; // 块数量很少，串行求出每一块的起始前缀
+        for (size_t b = 0; b < block_count; b++) {
+            T sum = std::move(block_sums[b]);
+            block_sums[b] = prefix;
+            prefix = op(std::move(prefix), sum);
+        }
+
+        parallel_for(pool, size_t(0), block_count, 1, [&](size_t sub_first, size_t sub_last) {
+            for (size_t b = sub_first; b < sub_last; b++) {
+                InputIt it = first + b * grain;
+                InputIt const end = first + std::min(len, (b + 1) * grain);
+                OutputIt out = d_first + b * grain;
+                T sum = block_sums[b];
+                for (; it != end; ++it, ++out) {
+                    sum = op(std::move(sum), *it);
+                    *out = sum;
+                }
+            }
+        });
+        return d_first + len;
+    }
+}
+
+#endif //THREADPOOL_PARALLEL_ALGORITHMS_HPP
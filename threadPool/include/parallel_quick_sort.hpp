@@ -7,7 +7,6 @@
 
 #include <list>
 #include <algorithm>
-#include <iostream>
 
 #include "futured_thread_pool.hpp"
 
@@ -60,8 +59,6 @@ namespace zhaocc {
         }
 
         result.splice(result.begin(), sorted_lower_future.get()); // 等待异步线程执行完毕
-
-        std::cout << "[thread-" << std::this_thread::get_id() << "] sub sort task done." << std::endl;
         return result;
     }
 }
@@ -0,0 +1,216 @@
+/**
+ * 线程池的运行统计：每个工作线程执行的任务数、从本线程队列/主任务队列/其他线程窃取的任务数、窃取失败次数、空转次数，
+ * 以及任务从入队到开始执行的等待时间和执行时间的对数-线性直方图。
+ * 每个工作线程只写自己独占一个缓存行（直方图另占若干缓存行）的计数，只有该线程写，不需要原子的读-改-写；
+ * 读取由snapshot在需要时汇总。等待时间和执行时间按提交线程每kSampleEvery（64）个任务采样一个，
+ * 未采样的任务不读取时钟，统计的开销平均每个任务只有几次普通的加法。
+ */
+
+#ifndef THREADPOOL_POOL_TELEMETRY_HPP
+#define THREADPOOL_POOL_TELEMETRY_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "function_wrapper.hpp"
+
+namespace zhaocc {
+    /* 对数-线性直方图的分桶：每个2的幂区间再线性分为4个桶，相对误差不超过25% */
+    struct LatencyBuckets {
+        static constexpr unsigned kSubBits = 2;
+        static constexpr unsigned kSub = 1u << kSubBits;
+        static constexpr unsigned kCount = (64 - kSubBits + 1) * kSub;
+
+        static unsigned bucket_of(uint64_t ns) {
+            if (ns < kSub) {
+                return static_cast<unsigned>(ns);
+            }
+            unsigned const msb = 63 - static_cast<unsigned>(__builtin_clzll(ns));
+            unsigned const sub = static_cast<unsigned>(ns >> (msb - kSubBits)) & (kSub - 1);
+            return (msb - kSubBits + 1) * kSub + sub;
+        }
+
+        /* 桶的下界（纳秒） */
+        static uint64_t lower_bound(unsigned bucket) {
+            if (bucket < kSub) {
+                return bucket;
+            }
+            unsigned const msb = bucket / kSub - 1 + kSubBits;
+            return (uint64_t(1) << msb) | (uint64_t(bucket % kSub) << (msb - kSubBits));
+        }
+    };
+
+    /* 一个工作线程的统计，按缓存行对齐，避免与其他线程的统计伪共享 */
+    struct alignas(64) WorkerStats {
+        bool shared = false; // 非工作线程共用的统计，可能被多个线程同时写，需要原子加
+        std::atomic<uint64_t> executed{0}; // 执行的任务数
+        std::atomic<uint64_t> local_pops{0}; // 从本线程任务队列取出的任务数
+        std::atomic<uint64_t> main_pops{0}; // 从主任务队列取出的任务数
+        std::atomic<uint64_t> stolen{0}; // 从其他工作线程窃取的任务数
+        std::atomic<uint64_t> failed_steals{0}; // 遍历所有其他队列都没有窃取到任务的次数
+        std::atomic<uint64_t> idle_spins{0}; // 没有任务而让出CPU的次数
+        alignas(64) std::array<std::atomic<uint64_t>, LatencyBuckets::kCount> wait_hist{}; // 入队到开始执行
+        std::array<std::atomic<uint64_t>, LatencyBuckets::kCount> run_hist{}; // 执行时间
+
+        void add(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+            if (shared) {
+                counter.fetch_add(n, std::memory_order_release);
+            } else { // 只有所属的工作线程写，普通的读-加-写即可；release使wait_idle看到计数时也能看到任务的结果
+                counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_release);
+            }
+        }
+    };
+
+    /* 汇总后的统计 */
+    struct TelemetrySnapshot {
+        struct Counters {
+            uint64_t executed = 0;
+            uint64_t local_pops = 0;
+            uint64_t main_pops = 0;
+            uint64_t stolen = 0;
+            uint64_t failed_steals = 0;
+            uint64_t idle_spins = 0;
+        };
+
+        std::vector<Counters> workers; // 每个工作线程位置的统计，最后一个是所有非工作线程（调用run_pending_task）的统计
+        Counters total;
+        unsigned threads = 0; // 运行中的工作线程数量
+        int64_t queue_depth = 0; // 已提交、尚未开始执行的任务数量
+        std::array<uint64_t, LatencyBuckets::kCount> wait_hist{};
+        std::array<uint64_t, LatencyBuckets::kCount> run_hist{};
+
+        /**
+         * 直方图的分位数
+         * @param hist: wait_hist或者run_hist
+         * @param q: 0到1之间
+         * @return 分位数所在桶的下界（微秒），没有采样时返回0
+         */
+        static double percentile_us(const std::array<uint64_t, LatencyBuckets::kCount>& hist, double q) {
+            uint64_t count = 0;
+            for (uint64_t c : hist) {
+                count += c;
+            }
+            if (count == 0) {
+                return 0;
+            }
+            uint64_t const rank = static_cast<uint64_t>(q * static_cast<double>(count - 1)) + 1;
+            uint64_t seen = 0;
+            for (unsigned b = 0; b < LatencyBuckets::kCount; b++) {
+                seen += hist[b];
+                if (seen >= rank) {
+                    return LatencyBuckets::lower_bound(b) / 1000.0;
+                }
+            }
+            return 0;
+        }
+
+        std::string to_string() const {
+            std::ostringstream out;
+            out << "threads=" << threads << " queue_depth=" << queue_depth << " executed=" << total.executed
+                << " local=" << total.local_pops << " main=" << total.main_pops << " stolen=" << total.stolen
+                << " failed_steals=" << total.failed_steals << " idle_spins=" << total.idle_spins
+                << " wait_us(p50/p99)=" << percentile_us(wait_hist, 0.5) << "/" << percentile_us(wait_hist, 0.99)
+                << " run_us(p50/p99)=" << percentile_us(run_hist, 0.5) << "/" << percentile_us(run_hist, 0.99);
+            return out.str();
+        }
+    };
+
+    class PoolTelemetry {
+    public:
+        static constexpr unsigned kSampleEvery = 64; // 每个提交线程每64个任务采样一个的时间，必须是2的幂
+
+    private:
+        unsigned const slots;
+        std::unique_ptr<WorkerStats[]> stats; // slots个工作线程位置，加上一个非工作线程共用的位置
+
+        static uint64_t now_ns() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+    public:
+        explicit PoolTelemetry(unsigned worker_slots) : slots(worker_slots), stats(new WorkerStats[worker_slots + 1]) {
+            stats[slots].shared = true;
+        }
+
+        WorkerStats& worker(unsigned slot) {
+            return stats[slot];
+        }
+
+        WorkerStats& external() {
+            return stats[slots];
+        }
+
+        /* 入队前调用：采样的任务记录入队时间 */
+        static void stamp(FunctionWrapper& task) {
+            thread_local unsigned tick = 0;
+            if ((++tick & (kSampleEvery - 1)) == 0) {
+                task.set_enqueue_time(now_ns());
+            }
+        }
+
+        /* 执行任务并计数，采样的任务同时记录等待时间和执行时间 */
+        static void run(WorkerStats& s, FunctionWrapper& task) {
+            uint64_t const enqueued = task.enqueue_time();
+            if (enqueued == 0) {
+                task();
+            } else {
+                uint64_t const start = now_ns();
+                s.add(s.wait_hist[LatencyBuckets::bucket_of(start > enqueued ? start - enqueued : 0)]);
+                task();
+                s.add(s.run_hist[LatencyBuckets::bucket_of(now_ns() - start)]);
+            }
+            s.add(s.executed);
+        }
+
+        /* 所有线程累计执行完的任务数 */
+        uint64_t executed() const {
+            uint64_t total = 0;
+            for (unsigned i = 0; i <= slots; i++) {
+                total += stats[i].executed.load(std::memory_order_acquire);
+            }
+            return total;
+        }
+
+        /**
+         * 汇总所有线程的统计，可以在任意线程随时调用，结果是近似的
+         * @param threads: 运行中的工作线程数量
+         * @param queue_depth: 尚未开始执行的任务数量
+         */
+        TelemetrySnapshot snapshot(unsigned threads, int64_t queue_depth) const {
+            TelemetrySnapshot snap;
+            snap.threads = threads;
+            snap.queue_depth = queue_depth;
+            for (unsigned i = 0; i <= slots; i++) {
+                WorkerStats const& s = stats[i];
+                TelemetrySnapshot::Counters c;
+                c.executed = s.executed.load(std::memory_order_relaxed);
+                c.local_pops = s.local_pops.load(std::memory_order_relaxed);
+                c.main_pops = s.main_pops.load(std::memory_order_relaxed);
+                c.stolen = s.stolen.load(std::memory_order_relaxed);
+                c.failed_steals = s.failed_steals.load(std::memory_order_relaxed);
+                c.idle_spins = s.idle_spins.load(std::memory_order_relaxed);
+                snap.total.executed += c.executed;
+                snap.total.local_pops += c.local_pops;
+                snap.total.main_pops += c.main_pops;
+                snap.total.stolen += c.stolen;
+                snap.total.failed_steals += c.failed_steals;
+                snap.total.idle_spins += c.idle_spins;
+                snap.workers.push_back(c);
+                for (unsigned b = 0; b < LatencyBuckets::kCount; b++) {
+                    snap.wait_hist[b] += s.wait_hist[b].load(std::memory_order_relaxed);
+                    snap.run_hist[b] += s.run_hist[b].load(std::memory_order_relaxed);
+                }
+            }
+            return snap;
+        }
+    };
+}
+
+#endif //THREADPOOL_POOL_TELEMETRY_HPP
@@ -0,0 +1,189 @@
+/**
+ * 按优先级分开的任务队列：REALTIME、NORMAL、BACKGROUND各一个ThreadSafeQueue。
+ * 出队时按权重轮转（平滑加权轮询，默认8:4:1）选择首选的队列，首选队列为空时再按优先级从高到低尝试其他队列，
+ * 所有队列都有任务时低优先级的任务也能按权重得到执行，不会被饿死。
+ * 另外提供任务截止时间的封装：任务开始执行时已经超过截止时间则不执行，future中得到DeadlineMissed异常。
+ */
+
+#ifndef THREADPOOL_PRIORITY_LANES_HPP
+#define THREADPOOL_PRIORITY_LANES_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "thread_safe_queue.hpp"
+
+namespace zhaocc {
+    /* 任务的优先级 */
+    enum class Priority : unsigned {
+        REALTIME = 0, // 延迟敏感的任务，例如交互请求
+        NORMAL = 1, // 默认优先级
+        BACKGROUND = 2 // 批量任务，例如compaction
+    };
+
+    /* 任务开始执行时已经超过截止时间 */
+    class DeadlineMissed : public std::runtime_error {
+    public:
+        DeadlineMissed() : std::runtime_error("task deadline missed") {}
+    };
+
+    template<typename T>
+    class PriorityLanes {
+    public:
+        static constexpr unsigned kLanes = 3;
+
+    private:
+        std::array<ThreadSafeQueue<T>, kLanes> lanes;
+        std::array<std::atomic<int64_t>, kLanes> sizes; // 每个队列中任务数量的近似值，用于跳过空队列时不获取锁
+        std::vector<unsigned> schedule; // 一轮加权轮转中每次首选的队列
+        std::atomic<unsigned> tick{0};
+
+        static unsigned lane_of(Priority priority) {
+            return static_cast<unsigned>(priority);
+        }
+
+        /* 本次出队首选的队列 */
+        unsigned next_lane() {
+            return schedule[tick.fetch_add(1, std::memory_order_relaxed) % schedule.size()];
+        }
+
+        /* 首选队列为空时按优先级从高到低选择，都为空时返回kLanes */
+        unsigned first_ready(unsigned preferred) const {
+            if (sizes[preferred].load(std::memory_order_relaxed) > 0) {
+                return preferred;
+            }
+            for (unsigned lane = 0; lane < kLanes; lane++) {
+                if (sizes[lane].load(std::memory_order_relaxed) > 0) {
+                    return lane;
+                }
+            }
+            return kLanes;
+        }
+
+        bool try_pop_lane(unsigned lane, T& value) {
+            if (sizes[lane].load(std::memory_order_relaxed) <= 0 || !lanes[lane].try_pop(value)) {
+                return false;
+            }
+            sizes[lane].fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+    public:
+        /**
+         * 构造函数
+         * @param weights: REALTIME、NORMAL、BACKGROUND的权重，都必须大于0
+         */
+        explicit PriorityLanes(std::array<unsigned, kLanes> weights = {8, 4, 1}) {
+            for (auto& size : sizes) {
+                size.store(0);
+            }
+            // 平滑加权轮询：每一步所有队列累加自己的权重，选择当前值最大的队列并减去总权重，
+            // 8:4:1的一轮为13步，REALTIME不会连续占满一轮，BACKGROUND每轮至少被首选一次
+            unsigned total = 0;
+            for (unsigned weight : weights) {
+                if (weight == 0) {
+                    throw std::invalid_argument("priority lane weight must be positive");
+                }
+                total += weight;
+            }
+            std::array<int, kLanes> current{};
+            for (unsigned step = 0; step < total; step++) {
+                unsigned best = 0;
+                for (unsigned lane = 0; lane < kLanes; lane++) {
+                    current[lane] += static_cast<int>(weights[lane]);
+                    if (current[lane] > current[best]) {
+                        best = lane;
+                    }
+                }
+                current[best] -= static_cast<int>(total);
+                schedule.push_back(best);
+            }
+        }
+
+        void push(Priority priority, T value) {
+            unsigned const lane = lane_of(priority);
+            sizes[lane].fetch_add(1, std::memory_order_relaxed); // 先计数再入队，出队时计数不会小于实际数量
+            lanes[lane].push(std::move(value));
+        }
+
+        template<typename InputIt>
+        size_t push_bulk(Priority priority, InputIt first, InputIt last) {
+            unsigned const lane = lane_of(priority);
+            sizes[lane].fetch_add(static_cast<int64_t>(std::distance(first, last)), std::memory_order_relaxed);
+            return lanes[lane].push_bulk(first, last);
+        }
+
+        /* 按权重轮转取出一个任务 */
+        bool try_pop(T& value) {
+            unsigned const preferred = next_lane();
+            if (try_pop_lane(preferred, value)) {
+                return true;
+            }
+            for (unsigned lane = 0; lane < kLanes; lane++) { // 首选队列为空时按优先级从高到低
+                if (lane != preferred && try_pop_lane(lane, value)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /* 只从指定优先级的队列中取出一个任务 */
+        bool try_pop(Priority priority, T& value) {
+            return try_pop_lane(lane_of(priority), value);
+        }
+
+        /**
+         * 取出最多max_count个任务，每个任务占用一次加权轮转，顺序与连续调用try_pop相同，不会改变各队列的权重；
+         * 第一个任务之后，轮转选中的不是batch_priority的队列时就停止，所以除第一个以外的任务都属于batch_priority
+         * @return 取出的任务数量
+         */
+        template<typename OutputIt>
+        size_t try_pop_bulk(OutputIt out, size_t max_count, Priority batch_priority = Priority::NORMAL) {
+            size_t count = 0;
+            while (count < max_count) {
+                unsigned slot = tick.load(std::memory_order_relaxed);
+                unsigned const lane = first_ready(schedule[slot % schedule.size()]);
+                if (lane == kLanes || (count > 0 && lane != lane_of(batch_priority))) {
+                    break;
+                }
+                if (!tick.compare_exchange_weak(slot, slot + 1, std::memory_order_relaxed)) {
+                    continue; // 这次轮转被其他线程占用，重新选择
+                }
+                T value;
+                if (!try_pop_lane(lane, value)) {
+                    break;
+                }
+                *out++ = std::move(value);
+                count++;
+            }
+            return count;
+        }
+
+        /* 指定优先级的队列中是否可能有任务，不获取锁 */
+        bool has(Priority priority) const {
+            return sizes[lane_of(priority)].load(std::memory_order_relaxed) > 0;
+        }
+    };
+
+    /**
+     * 给任务加上截止时间：开始执行时已经超过截止时间则不执行f，抛出DeadlineMissed并累加missed
+     */
+    template<typename FuncType>
+    auto with_deadline(std::chrono::steady_clock::time_point deadline, FuncType f, std::atomic<uint64_t>& missed) {
+        return [deadline, f = std::move(f), &missed]() mutable -> std::invoke_result_t<FuncType&> {
+            if (std::chrono::steady_clock::now() > deadline) {
+                missed.fetch_add(1, std::memory_order_relaxed);
+                throw DeadlineMissed();
+            }
+            return f();
+        };
+    }
+}
+
+#endif //THREADPOOL_PRIORITY_LANES_HPP
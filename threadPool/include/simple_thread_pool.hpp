@@ -24,14 +24,14 @@ namespace zhaocc {
         void worker_thread_func(); // 工作线程执行的函数
 
     public:
-        SimpleThreadPool(); // 构造函数
+        explicit SimpleThreadPool(unsigned concurrent_count = std::thread::hardware_concurrency()); // 构造函数
         ~SimpleThreadPool(); // 析构函数
 
         template<typename FuncType>
         void submit(FuncType f); // 提交任务
     };
 
-    void SimpleThreadPool::worker_thread_func() {
+    inline void SimpleThreadPool::worker_thread_func() {
         while (!done) {
             std::function<void()> task;
 
@@ -46,9 +46,8 @@ namespace zhaocc {
         }
     }
 
-    SimpleThreadPool::SimpleThreadPool() : done(false),
-                                           threads_joiner(threads) { // 将threads交付给threads_joiner管理，在线程池任务结束时等待所有线程
-        unsigned const concurrent_count = std::thread::hardware_concurrency(); // 获取硬件支持的并发数
+    inline SimpleThreadPool::SimpleThreadPool(unsigned concurrent_count) : done(false),
+                                                                    threads_joiner(threads) { // 将threads交付给threads_joiner管理，在线程池任务结束时等待所有线程
         try {
             for (unsigned i = 0; i < concurrent_count; i++) {
                 threads.emplace_back(&SimpleThreadPool::worker_thread_func, this); // 创建工作线程
@@ -59,7 +58,7 @@ namespace zhaocc {
         }
     }
 
-    SimpleThreadPool::~SimpleThreadPool() {
+    inline SimpleThreadPool::~SimpleThreadPool() {
         done = true;
     }
 
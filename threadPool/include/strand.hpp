@@ -0,0 +1,170 @@
+/**
+ * 基于线程池的strand（串行器）：同一个strand中的任务按提交顺序依次执行、不会并发，不同strand之间在线程池的工作线程上并行，
+ * 可以代替"每个会话一把互斥锁，在工作线程中持锁执行任务"的做法，后者会让排在同一会话上的工作线程阻塞。
+ * 1. strand没有自己的线程：有任务时向线程池提交一个批处理任务，批处理一次取出strand中已有的所有任务依次执行，
+ *    执行完还有新任务时重新提交到线程池（而不是一直占着工作线程），让其他strand和任务有机会执行。
+ * 2. 锁只在入队和换出任务列表时持有，执行任务期间不持锁，工作线程不会阻塞在strand上。
+ * 3. StrandGroup按key的哈希把大量会话映射到固定数量的strand上，同一个key总是串行，哈希到同一个strand的不同key也会串行。
+ * post的任务不应抛出异常（与线程池的post相同），需要异常时使用submit。
+ */
+
+#ifndef THREADPOOL_STRAND_HPP
+#define THREADPOOL_STRAND_HPP
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "function_wrapper.hpp"
+
+namespace zhaocc {
+    template<typename ThreadPoolType>
+    class Strand {
+    private:
+        class Impl : public std::enable_shared_from_this<Impl> {
+        private:
+            ThreadPoolType& pool;
+            std::mutex mutex; // 保护pending和scheduled
+            std::vector<FunctionWrapper> pending; // 等待执行的任务
+            bool scheduled = false; // 是否已经向线程池提交了批处理任务（或者正在执行批处理）
+            std::vector<FunctionWrapper> batch; // 正在执行的一批任务，只被批处理任务访问，复用容量
+
+            /* 当前线程正在执行的strand */
+            static const Impl*& current() {
+                thread_local const Impl* strand = nullptr;
+                return strand;
+            }
+
+            void schedule() {
+                pool.post([self = this->shared_from_this()]() { self->run_batch(); });
+            }
+
+            /* 批处理：换出已有的任务依次执行，执行完仍有任务时重新提交 */
+            void run_batch() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    batch.swap(pending);
+                }
+                const Impl*& strand = current();
+                const Impl* const outer = strand; // 任务中可能同步地执行其他strand的批处理（例如run_pending_task）
+                strand = this;
+                for (auto& task : batch) {
+                    task();
+                }
+                strand = outer;
+                batch.clear();
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (pending.empty()) {
+                        pending.swap(batch); // 把容量还给pending，下一批不需要重新分配
+                        scheduled = false;
+                        return;
+                    }
+                }
+                schedule();
+            }
+
+        public:
+            explicit Impl(ThreadPoolType& pool_) : pool(pool_) {}
+
+            void post(FunctionWrapper task) {
+                bool need_schedule;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    pending.push_back(std::move(task));
+                    need_schedule = !scheduled;
+                    scheduled = true;
+                }
+                if (need_schedule) { // 锁外提交，线程池的队列锁不嵌套在strand的锁中
+                    schedule();
+                }
+            }
+
+            bool running_in_this_thread() const {
+                return current() == this;
+            }
+        };
+
+        std::shared_ptr<Impl> impl; // 已提交的批处理任务也持有impl，strand析构后剩余任务仍然会执行
+
+    public:
+        /**
+         * 构造函数
+         * @param pool: 执行任务的线程池，必须比strand中的任务存活更久
+         */
+        explicit Strand(ThreadPoolType& pool) : impl(std::make_shared<Impl>(pool)) {}
+
+        /**
+         * 提交不需要结果的任务
+         * @param f: 可调用对象，会被move到strand的任务列表中
+         */
+        template<typename FuncType>
+        void post(FuncType f) {
+            impl->post(FunctionWrapper(std::move(f)));
+        }
+
+        /**
+         * 提交任务
+         * @param f: 可调用对象
+         * @return 与可调用对象返回值相关联的future
+         */
+        template<typename FuncType>
+        std::future<std::invoke_result_t<FuncType>> submit(FuncType f) {
+            using result_type = std::invoke_result_t<FuncType>;
+            std::packaged_task<result_type()> task(std::move(f));
+            std::future<result_type> res(task.get_future());
+            impl->post(FunctionWrapper(std::move(task)));
+            return res;
+        }
+
+        /* 当前线程是否正在执行本strand的任务 */
+        bool running_in_this_thread() const {
+            return impl->running_in_this_thread();
+        }
+    };
+
+    /**
+     * 按key把任务分配到固定数量的strand上，同一个key的任务按提交顺序串行执行
+     * @tparam Key: 会话等的标识
+     * @tparam Hash: key的哈希函数
+     */
+    template<typename ThreadPoolType, typename Key, typename Hash = std::hash<Key>>
+    class StrandGroup {
+    private:
+        std::vector<Strand<ThreadPoolType>> strands;
+        Hash hasher;
+
+    public:
+        /**
+         * 构造函数
+         * @param pool: 执行任务的线程池
+         * @param strand_count: strand的数量，越多不同key之间越少因为哈希冲突而串行
+         */
+        explicit StrandGroup(ThreadPoolType& pool, size_t strand_count = 64) {
+            strands.reserve(strand_count);
+            for (size_t i = 0; i < strand_count; i++) {
+                strands.emplace_back(pool);
+            }
+        }
+
+        Strand<ThreadPoolType>& strand_for(const Key& key) {
+            return strands[hasher(key) % strands.size()];
+        }
+
+        template<typename FuncType>
+        void post(const Key& key, FuncType f) {
+            strand_for(key).post(std::move(f));
+        }
+
+        template<typename FuncType>
+        std::future<std::invoke_result_t<FuncType>> submit(const Key& key, FuncType f) {
+            return strand_for(key).submit(std::move(f));
+        }
+    };
+}
+
+#endif //THREADPOOL_STRAND_HPP
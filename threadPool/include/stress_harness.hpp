@@ -0,0 +1,351 @@
+/**
+ * 并发容器的正确性测试框架，按容器类型参数化：
+ * 1. 随机化的多生产者多消费者压力测试：每个元素编码为(生产者, 序号)，结束后检查没有丢失、没有重复；
+ *    FIFO容器还要检查每个消费者看到的同一生产者的元素按序号递增，LIFO容器的批量出栈要求同一批内按序号递减。
+ * 2. 有界的线性一致性检查：几个线程各执行几次随机的push/try_pop，记录每次调用的开始与结束时刻，
+ *    用回溯搜索（Wing & Gong算法）寻找一个与实时顺序相容、并且符合顺序队列/栈语义的全序。历史很小，搜索是有界的。
+ *
+ * 新的容器只需要提供一个适配器即可接入：
+ *   struct Adapter {
+ *       using Container = ...;
+ *       static constexpr ContainerOrder kOrder = ContainerOrder::FIFO; // 或LIFO
+ *       static void push(Container&, uint64_t);
+ *       static bool try_pop(Container&, uint64_t&); // 为空时返回false
+ *       // 可选：批量出栈，按出栈顺序追加到out，返回取出的数量；有try_pop时可以不提供
+ *       static size_t pop_batch(Container&, std::vector<uint64_t>& out);
+ *   };
+ * 只提供pop_batch的容器（例如只有pop_all的lock_free_stack）不参与线性一致性检查。
+ */
+
+#ifndef THREADPOOL_STRESS_HARNESS_HPP
+#define THREADPOOL_STRESS_HARNESS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace zhaocc {
+    /* 容器的顺序语义 */
+    enum class ContainerOrder {
+        FIFO, // 队列
+        LIFO // 栈
+    };
+
+    /* 测试结果，失败时message描述第一个发现的问题 */
+    struct StressReport {
+        bool ok = true;
+        std::string message;
+        uint64_t pushed = 0;
+        uint64_t popped = 0;
+
+        void fail(const std::string& what) {
+            if (ok) {
+                ok = false;
+                message = what;
+            }
+        }
+    };
+
+    template<typename Adapter>
+    concept HasTryPop = requires(typename Adapter::Container& c, uint64_t& v) {
+        { Adapter::try_pop(c, v) } -> std::same_as<bool>;
+    };
+
+    template<typename Adapter>
+    concept HasPopBatch = requires(typename Adapter::Container& c, std::vector<uint64_t>& out) {
+        { Adapter::pop_batch(c, out) } -> std::convertible_to<size_t>;
+    };
+
+    struct StressOptions {
+        unsigned producers = 4;
+        unsigned consumers = 4;
+        uint64_t per_producer = 20000; // 每个生产者push的元素数
+        uint64_t seed = 1;
+        unsigned pause_every = 64; // 平均每多少次操作随机让出一次CPU，打乱线程之间的交错
+    };
+
+    class StressHarness {
+    private:
+        static constexpr unsigned kSeqBits = 40;
+
+        static uint64_t encode(unsigned producer, uint64_t seq) {
+            return (static_cast<uint64_t>(producer) << kSeqBits) | seq;
+        }
+
+        static unsigned producer_of(uint64_t value) {
+            return static_cast<unsigned>(value >> kSeqBits);
+        }
+
+        static uint64_t seq_of(uint64_t value) {
+            return value & ((uint64_t(1) << kSeqBits) - 1);
+        }
+
+        static std::string describe(uint64_t value) {
+            std::ostringstream out;
+            out << "(producer " << producer_of(value) << ", seq " << seq_of(value) << ")";
+            return out.str();
+        }
+
+        /* 每个消费者的出队记录，batch_ends记录每批的结束位置（逐个出队时每个元素一批） */
+        struct ConsumerLog {
+            std::vector<uint64_t> values;
+            std::vector<size_t> batch_ends;
+        };
+
+    public:
+        /**
+         * 多生产者多消费者压力测试
+         * @return 测试结果，检查没有丢失、没有重复以及FIFO/LIFO顺序
+         */
+        template<typename Adapter>
+        static StressReport run_mpmc(const StressOptions& options) {
+            typename Adapter::Container container;
+            uint64_t const total = options.per_producer * options.producers;
+            std::atomic<uint64_t> consumed(0);
+            std::vector<ConsumerLog> logs(options.consumers);
+            std::vector<std::thread> threads;
+
+            for (unsigned p = 0; p < options.producers; p++) {
+                threads.emplace_back([&, p]() {
+                    std::mt19937_64 rng(options.seed * 1000003 + p);
+                    for (uint64_t seq = 0; seq < options.per_producer; seq++) {
+                        Adapter::push(container, encode(p, seq));
+                        if (rng() % options.pause_every == 0) {
+                            std::this_thread::yield();
+                        }
+                    }
+                });
+            }
+            for (unsigned c = 0; c < options.consumers; c++) {
+                threads.emplace_back([&, c]() {
+                    std::mt19937_64 rng(options.seed * 2000003 + c);
+                    ConsumerLog& log = logs[c];
+                    while (consumed.load(std::memory_order_relaxed) < total) {
+                        size_t got = 0;
+                        if constexpr (HasTryPop<Adapter>) {
+                            uint64_t value;
+                            if (Adapter::try_pop(container, value)) {
+                                log.values.push_back(value);
+                                got = 1;
+                            }
+                        } else {
+                            got = Adapter::pop_batch(container, log.values);
+                        }
+                        if (got == 0 || rng() % options.pause_every == 0) {
+                            std::this_thread::yield();
+                        }
+                        if (got > 0) {
+                            log.batch_ends.push_back(log.values.size());
+                            consumed.fetch_add(got, std::memory_order_relaxed);
+                        }
+                    }
+                });
+            }
+            for (auto& t : threads) {
+                t.join();
+            }
+
+            StressReport report;
+            report.pushed = total;
+            std::vector<uint8_t> seen(total, 0);
+            for (unsigned c = 0; c < options.consumers; c++) {
+                ConsumerLog const& log = logs[c];
+                report.popped += log.values.size();
+                std::vector<int64_t> last(options.producers, -1); // FIFO：本消费者看到的每个生产者的上一个序号
+                size_t batch_begin = 0;
+                for (size_t end : log.batch_ends) {
+                    std::vector<int64_t> batch_last; // LIFO：本批内每个生产者的上一个序号
+                    if (Adapter::kOrder == ContainerOrder::LIFO && end - batch_begin > 1) {
+                        batch_last.assign(options.producers, -1);
+                    }
+                    for (size_t i = batch_begin; i < end; i++) {
+                        uint64_t const value = log.values[i];
+                        unsigned const p = producer_of(value);
+                        uint64_t const seq = seq_of(value);
+                        if (p >= options.producers || seq >= options.per_producer) {
+                            report.fail("consumer " + std::to_string(c) + " popped a value never pushed: " +
+                                        describe(value));
+                            continue;
+                        }
+                        if (seen[p * options.per_producer + seq]++ != 0) {
+                            report.fail("duplicated " + describe(value));
+                        }
+                        if (Adapter::kOrder == ContainerOrder::FIFO) {
+                            if (static_cast<int64_t>(seq) <= last[p]) {
+                                report.fail("consumer " + std::to_string(c) + " saw " + describe(value) +
+                                            " after seq " + std::to_string(last[p]));
+                            }
+                            last[p] = static_cast<int64_t>(seq);
+                        } else if (end - batch_begin > 1) {
+                            if (batch_last[p] >= 0 && static_cast<int64_t>(seq) >= batch_last[p]) {
+                                report.fail("batch of consumer " + std::to_string(c) + " is not LIFO at " +
+                                            describe(value));
+                            }
+                            batch_last[p] = static_cast<int64_t>(seq);
+                        }
+                    }
+                    batch_begin = end;
+                }
+            }
+            for (uint64_t i = 0; i < total; i++) {
+                if (seen[i] == 0) {
+                    report.fail("lost " + describe(encode(static_cast<unsigned>(i / options.per_producer),
+                                                          i % options.per_producer)));
+                    break;
+                }
+            }
+            if (report.popped != total) {
+                report.fail("popped " + std::to_string(report.popped) + " of " + std::to_string(total));
+            }
+            return report;
+        }
+
+        /* 一次操作的记录 */
+        struct Operation {
+            bool is_push;
+            uint64_t value; // push的值，或者pop得到的值
+            bool ok; // pop是否取到值，push总是true
+            uint64_t invoke; // 调用开始时刻（全局递增的逻辑时钟）
+            uint64_t response; // 调用返回时刻
+        };
+
+    private:
+        /* 回溯搜索：已经线性化的操作集合为done，model为此时容器中的元素 */
+        static bool linearize(const std::vector<Operation>& history, ContainerOrder order, uint32_t done,
+                              std::deque<uint64_t>& model, std::set<std::pair<uint32_t, std::deque<uint64_t>>>& dead) {
+            uint32_t const all = history.size() == 32 ? ~uint32_t(0) : (uint32_t(1) << history.size()) - 1;
+            if (done == all) {
+                return true;
+            }
+            if (dead.count({done, model}) != 0) { // 同样的状态已经搜索过并且失败
+                return false;
+            }
+            uint64_t min_response = UINT64_MAX; // 尚未线性化的操作中最早的返回时刻，开始时刻在它之后的操作不能排在最前
+            for (size_t i = 0; i < history.size(); i++) {
+                if ((done & (uint32_t(1) << i)) == 0) {
+                    min_response = std::min(min_response, history[i].response);
+                }
+            }
+            for (size_t i = 0; i < history.size(); i++) {
+                Operation const& op = history[i];
+                if ((done & (uint32_t(1) << i)) != 0 || op.invoke > min_response) {
+                    continue;
+                }
+                uint32_t const next = done | (uint32_t(1) << i);
+                if (op.is_push) {
+                    model.push_back(op.value);
+                    if (linearize(history, order, next, model, dead)) {
+                        return true;
+                    }
+                    model.pop_back();
+                } else if (!op.ok) {
+                    if (model.empty() && linearize(history, order, next, model, dead)) {
+                        return true;
+                    }
+                } else if (!model.empty()) {
+                    bool const fifo = order == ContainerOrder::FIFO;
+                    uint64_t const expected = fifo ? model.front() : model.back();
+                    if (expected == op.value) {
+                        fifo ? model.pop_front() : model.pop_back();
+                        if (linearize(history, order, next, model, dead)) {
+                            return true;
+                        }
+                        fifo ? model.push_front(expected) : model.push_back(expected);
+                    }
+                }
+            }
+            dead.insert({done, model});
+            return false;
+        }
+
+    public:
+        /**
+         * 检查一段历史是否可线性化
+         * @param history: 最多32个操作
+         */
+        static bool is_linearizable(const std::vector<Operation>& history, ContainerOrder order) {
+            std::deque<uint64_t> model;
+            std::set<std::pair<uint32_t, std::deque<uint64_t>>> dead;
+            return history.size() <= 32 && linearize(history, order, 0, model, dead);
+        }
+
+        static std::string to_string(const std::vector<Operation>& history) {
+            std::ostringstream out;
+            for (auto const& op : history) {
+                out << "  [" << op.invoke << ", " << op.response << "] "
+                    << (op.is_push ? "push(" + std::to_string(op.value) + ")" :
+                        op.ok ? "try_pop -> " + std::to_string(op.value) : std::string("try_pop -> empty")) << "\n";
+            }
+            return out.str();
+        }
+
+        /**
+         * 线性一致性检查：rounds轮，每轮threads个线程各执行ops_per_thread次随机的push/try_pop
+         * @return 测试结果，失败时message中包含不可线性化的历史
+         */
+        template<typename Adapter>
+        static StressReport run_linearizability(unsigned rounds, unsigned threads, unsigned ops_per_thread,
+                                                uint64_t seed) {
+            static_assert(HasTryPop<Adapter>, "linearizability check needs try_pop");
+            StressReport report;
+            std::mt19937_64 rng(seed);
+            for (unsigned round = 0; round < rounds && report.ok; round++) {
+                typename Adapter::Container container;
+                std::atomic<uint64_t> clock(0);
+                std::atomic<unsigned> ready(0);
+                std::vector<std::vector<Operation>> logs(threads);
+                std::vector<uint64_t> plans(threads); // 每个线程的随机操作序列，按位表示push/pop
+                for (auto& plan : plans) {
+                    plan = rng();
+                }
+                std::vector<std::thread> workers;
+                for (unsigned t = 0; t < threads; t++) {
+                    workers.emplace_back([&, t]() {
+                        ready.fetch_add(1);
+                        while (ready.load() < threads) { // 尽量同时开始，增加重叠
+                            std::this_thread::yield();
+                        }
+                        for (unsigned i = 0; i < ops_per_thread; i++) {
+                            Operation op{};
+                            op.is_push = (plans[t] >> i) & 1;
+                            op.invoke = clock.fetch_add(1);
+                            if (op.is_push) {
+                                op.value = t * 1000 + i + 1; // 每个值只push一次
+                                Adapter::push(container, op.value);
+                                op.ok = true;
+                            } else {
+                                op.ok = Adapter::try_pop(container, op.value);
+                            }
+                            op.response = clock.fetch_add(1);
+                            logs[t].push_back(op);
+                        }
+                    });
+                }
+                for (auto& w : workers) {
+                    w.join();
+                }
+                std::vector<Operation> history;
+                for (auto const& log : logs) {
+                    history.insert(history.end(), log.begin(), log.end());
+                }
+                report.pushed += static_cast<uint64_t>(std::count_if(history.begin(), history.end(),
+                                                                     [](const Operation& op) { return op.is_push; }));
+                if (!is_linearizable(history, Adapter::kOrder)) {
+                    report.fail("round " + std::to_string(round) + " is not linearizable:\n" + to_string(history));
+                }
+            }
+            return report;
+        }
+    };
+}
+
+#endif //THREADPOOL_STRESS_HARNESS_HPP
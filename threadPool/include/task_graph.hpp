@@ -0,0 +1,215 @@
+/**
+ * 基于线程池的任务依赖图（DAG）执行器。
+ * 先声明节点和边，finalize时检查环并计算每个节点的入度；每次run时把每个节点的原子依赖计数重置为入度，
+ * 节点执行完后把后继节点的计数减一，减到0的后继立即被调度（第一个就绪的后继由当前线程直接执行，其余post到线程池），
+ * 整个过程没有阻塞等待。图结构只在声明时分配内存，同一张图可以反复run。
+ */
+
+#ifndef THREADPOOL_TASK_GRAPH_HPP
+#define THREADPOOL_TASK_GRAPH_HPP
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace zhaocc {
+    template<typename ThreadPoolType>
+    class TaskGraph {
+    public:
+        using NodeId = size_t;
+
+    private:
+        struct Node {
+            std::function<void()> work; // 节点的任务
+            std::vector<NodeId> successors; // 依赖本节点的节点
+            size_t in_degree = 0; // 前驱节点数量
+            std::atomic<size_t> pending{0}; // 本次运行中尚未完成的前驱数量
+        };
+
+        ThreadPoolType& pool;
+        std::vector<std::unique_ptr<Node>> nodes; // Node包含原子变量不能移动，使用指针保存
+        std::vector<NodeId> roots; // 没有前驱的节点
+        bool finalized = false; // 图结构是否已经固定
+
+        std::atomic<size_t> remaining{0}; // 本次运行中尚未完成的节点数量
+        std::atomic<bool> failed{false}; // 本次运行中是否有节点抛出异常
+        std::exception_ptr first_exception; // 第一个异常，只被第一个置位failed的线程写入
+        std::atomic<bool> running{false};
+
+        void check_id(NodeId id) const;
+        void execute(NodeId id); // 执行节点，并沿着就绪的后继继续执行
+
+    public:
+        explicit TaskGraph(ThreadPoolType& pool_) : pool(pool_) {}
+
+        // 不允许拷贝
+        TaskGraph(const TaskGraph&) = delete;
+
+        TaskGraph& operator=(const TaskGraph&) = delete;
+
+        /**
+         * 添加节点
+         * @param work: 节点的任务，每次run都会被调用一次
+         * @return 节点id
+         */
+        NodeId add_node(std::function<void()> work);
+
+        /**
+         * 添加依赖边，to在from完成后才能执行
+         */
+        void add_edge(NodeId from, NodeId to);
+
+        /**
+         * 固定图结构，检查是否有环，第一次run时会自动调用
+         * @throw std::logic_error: 图中有环
+         */
+        void finalize();
+
+        /**
+         * 执行一次整张图，返回时所有节点都已完成；等待期间调用者线程执行线程池中的任务。
+         * 某个节点抛出异常时，之后尚未开始的节点都会被跳过，run结束后重新抛出第一个异常。
+         * 同一张图不能被多个线程同时run。
+         */
+        void run();
+
+        size_t node_count() const {
+            return nodes.size();
+        }
+    };
+
+    template<typename ThreadPoolType>
+    void TaskGraph<ThreadPoolType>::check_id(NodeId id) const {
+        if (id >= nodes.size()) {
+            throw std::out_of_range("TaskGraph: invalid node id " + std::to_string(id));
+        }
+    }
+
+    template<typename ThreadPoolType>
+    typename TaskGraph<ThreadPoolType>::NodeId TaskGraph<ThreadPoolType>::add_node(std::function<void()> work) {
+        if (finalized) {
+            throw std::logic_error("TaskGraph: can not add node after finalize");
+        }
+        nodes.emplace_back(new Node);
+        nodes.back()->work = std::move(work);
+        return nodes.size() - 1;
+    }
+
+    template<typename ThreadPoolType>
+    void TaskGraph<ThreadPoolType>::add_edge(NodeId from, NodeId to) {
+        if (finalized) {
+            throw std::logic_error("TaskGraph: can not add edge after finalize");
+        }
+        check_id(from);
+        check_id(to);
+        nodes[from]->successors.push_back(to);
+        nodes[to]->in_degree++;
+    }
+
+    template<typename ThreadPoolType>
+    void TaskGraph<ThreadPoolType>::finalize() {
+        if (finalized) {
+            return;
+        }
+
+        // 拓扑排序检查环
+        std::vector<size_t> in_degrees(nodes.size());
+        std::vector<NodeId> ready;
+        for (NodeId id = 0; id < nodes.size(); id++) {
+            in_degrees[id] = nodes[id]->in_degree;
+            if (in_degrees[id] == 0) {
+                ready.push_back(id);
+            }
+        }
+        roots = ready;
+        size_t visited = 0;
+        while (!ready.empty()) {
+            NodeId const id = ready.back();
+            ready.pop_back();
+            visited++;
+            for (NodeId succ : nodes[id]->successors) {
+                if (--in_degrees[succ] == 0) {
+                    ready.push_back(succ);
+                }
+            }
+        }
+        if (visited != nodes.size()) {
+            throw std::logic_error("TaskGraph: graph has a cycle");
+        }
+        finalized = true;
+    }
+
+    template<typename ThreadPoolType>
+    void TaskGraph<ThreadPoolType>::execute(NodeId id) {
+        while (true) {
+            Node& node = *nodes[id];
+            if (!failed.load(std::memory_order_relaxed)) { // 有节点失败后，剩余的节点不再执行，只做计数
+                try {
+                    node.work();
+                } catch (...) {
+                    if (!failed.exchange(true)) {
+                        first_exception = std::current_exception();
+                    }
+                }
+            }
+
+            NodeId next = nodes.size(); // 由当前线程继续执行的后继
+            for (NodeId succ : node.successors) {
+                // acq_rel：本节点的写入对后继可见，且最后一个完成的前驱能看到其他前驱的写入
+                if (nodes[succ]->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    if (next == nodes.size()) {
+                        next = succ;
+                    } else {
+                        pool.post([this, succ]() { execute(succ); });
+                    }
+                }
+            }
+
+            bool const has_next = next != nodes.size();
+            // 计数放在调度后继之后，保证remaining为0时不会再有节点被调度；减到0后run可能已经返回，之后不能再访问this
+            remaining.fetch_sub(1, std::memory_order_acq_rel);
+            if (!has_next) {
+                return;
+            }
+            id = next;
+        }
+    }
+
+    template<typename ThreadPoolType>
+    void TaskGraph<ThreadPoolType>::run() {
+        finalize();
+        if (nodes.empty()) {
+            return;
+        }
+        if (running.exchange(true)) {
+            throw std::logic_error("TaskGraph: run concurrently");
+        }
+
+        for (auto& node : nodes) {
+            node->pending.store(node->in_degree, std::memory_order_relaxed);
+        }
+        failed.store(false, std::memory_order_relaxed);
+        first_exception = nullptr;
+        remaining.store(nodes.size(), std::memory_order_release);
+
+        for (size_t i = 1; i < roots.size(); i++) {
+            NodeId const root = roots[i];
+            pool.post([this, root]() { execute(root); });
+        }
+        execute(roots[0]); // 第一个根节点直接在调用者线程执行
+
+        while (remaining.load(std::memory_order_acquire) != 0) {
+            pool.run_pending_task(); // 帮忙执行任务，不阻塞等待
+        }
+
+        running.store(false);
+        if (first_exception) {
+            std::rethrow_exception(first_exception);
+        }
+    }
+}
+
+#endif //THREADPOOL_TASK_GRAPH_HPP
@@ -8,6 +8,7 @@
 #include <memory>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
 
 namespace zhaocc {
     template<typename T>
@@ -53,9 +54,26 @@ namespace zhaocc {
 
         void wait_and_pop(T& value);
 
+        /**
+         * 批量pop，只获取一次头部锁
+         * @param out: 输出迭代器，数据会被move
+         * @param max_count: 最多pop的数量
+         * @return 实际pop的数量
+         */
+        template<typename OutputIt>
+        size_t try_pop_bulk(OutputIt out, size_t max_count);
+
         // push往尾部添加数据
         void push(T new_value);
 
+        /**
+         * 批量push，先在锁外构造好整条链表，再只获取一次尾部锁挂到尾部，并只唤醒一次等待的线程
+         * @param first, last: 输入迭代器范围，数据会被move
+         * @return push的数量
+         */
+        template<typename InputIt>
+        size_t push_bulk(InputIt first, InputIt last);
+
         // empty判断队列是否为空
         bool empty();
     };
@@ -138,6 +156,68 @@ namespace zhaocc {
         return old_head != nullptr; // 如果unique_ptr指向空，则转成bool型是false
     }
 
+    template<typename T>
+    template<typename OutputIt>
+    size_t ThreadSafeQueue<T>::try_pop_bulk(OutputIt out, size_t max_count) {
+        std::unique_ptr<Node> popped; // 被pop的节点链表，在锁外析构
+        Node* popped_tail = nullptr;
+        size_t count = 0;
+        {
+            std::lock_guard<std::mutex> lock(head_mutex);
+            Node* const cur_tail = get_tail(); // 尾部只会后移，只需获取一次
+            while (count < max_count && head.get() != cur_tail) {
+                *out++ = std::move(*(head->data));
+                std::unique_ptr<Node> old_head = pop_head();
+                Node* const p = old_head.get();
+                if (popped_tail) {
+                    popped_tail->next = std::move(old_head);
+                } else {
+                    popped = std::move(old_head);
+                }
+                popped_tail = p;
+                count++;
+            }
+        }
+        while (popped) { // 逐个析构，避免递归析构长链表
+            popped = std::move(popped->next);
+        }
+        return count;
+    }
+
+    template<typename T>
+    template<typename InputIt>
+    size_t ThreadSafeQueue<T>::push_bulk(InputIt first, InputIt last) {
+        if (first == last) {
+            return 0;
+        }
+
+        // 当前尾部傀儡节点保存第一个数据，新链表的每个节点保存后一个数据，新链表的最后一个节点作为新的傀儡节点
+        std::shared_ptr<T> first_data(std::make_shared<T>(std::move(*first)));
+        std::unique_ptr<Node> chain(new Node);
+        Node* new_tail = chain.get();
+        size_t count = 1;
+        for (++first; first != last; ++first, count++) {
+            new_tail->data = std::make_shared<T>(std::move(*first));
+            new_tail->next.reset(new Node);
+            new_tail = new_tail->next.get();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(tail_mutex);
+            tail->data = std::move(first_data);
+            tail->next = std::move(chain);
+            tail = new_tail;
+        }
+
+        // 线程池的工作线程轮询try_pop，不阻塞在data_cond上，这里只需要唤醒wait_and_pop的调用者
+        if (count == 1) {
+            data_cond.notify_one();
+        } else {
+            data_cond.notify_all();
+        }
+        return count;
+    }
+
     template<typename T>
     void ThreadSafeQueue<T>::push(T new_value) {
         std::shared_ptr<T> new_data(std::make_shared<T>(std::move(new_value))); // 新的data
@@ -158,7 +238,7 @@ namespace zhaocc {
     template<typename T>
     bool ThreadSafeQueue<T>::empty() {
         std::lock_guard<std::mutex> lock(head_mutex);
-        return head == get_tail();
+        return head.get() == get_tail();
     }
 }
 
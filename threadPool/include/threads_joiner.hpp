@@ -7,17 +7,32 @@
 
 #include <vector>
 #include <thread>
+#include <mutex>
 
 namespace zhaocc {
     class ThreadsJoiner {
     private:
         std::vector<std::thread>& threads; // 引用一个线程容器
+        std::mutex* threads_mutex; // 线程容器中的线程对象会被其他线程替换时（弹性线程池），用于保护线程对象，可以为空
     public:
-        ThreadsJoiner(std::vector<std::thread>& threads_) : threads(threads_) {}
+        ThreadsJoiner(std::vector<std::thread>& threads_, std::mutex* threads_mutex_ = nullptr)
+                : threads(threads_), threads_mutex(threads_mutex_) {}
 
         ~ThreadsJoiner() {
-            for (auto& th : threads) {
-                if (th.joinable()) {
+            join_all();
+        }
+
+        /* join所有线程，可以提前调用，之后再调用或者析构时不会重复join */
+        void join_all() {
+            for (size_t i = 0; i < threads.size(); i++) {
+                std::thread th;
+                if (threads_mutex) { // 在锁内取出线程对象，在锁外join，join期间不阻塞其他线程访问线程容器
+                    std::lock_guard<std::mutex> lock(*threads_mutex);
+                    th = std::move(threads[i]);
+                } else {
+                    th = std::move(threads[i]);
+                }
+                if (th.joinable()) { // 空位置或者已经被join的线程不是joinable的
                     th.join();
                 }
             }
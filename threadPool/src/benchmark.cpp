@@ -0,0 +1,294 @@
+/**
+ * 仓库中各个队列、锁、线程池的微基准测试，在1..N个线程下测量吞吐和延迟分位数，结果可以输出为JSON：
+ *   ./threadPoolBenchmark --threads 8 --repetitions 5 --json bench.json
+ * 发布新版本前与上一版本的JSON对比，发现性能回退。
+ */
+
+#include <iostream>
+#include <vector>
+#include <list>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <stdexcept>
+
+#include "bench_harness.hpp"
+#include "thread_safe_queue.hpp"
+#include "simple_thread_pool.hpp"
+#include "futured_thread_pool.hpp"
+#include "multi_queue_thread_pool.hpp"
+#include "parallel_quick_sort.hpp"
+#include "thread_pool_timer_container.h"
+#include "blocking_queue.hpp" // syncConcurrent/include
+#include "thread_safe_stack.hpp" // sharedDataBetweenThreads/include
+#include "concurrent_stack.hpp" // sharedDataBetweenThreads/include
+#include "my_lock.hpp" // atomic/include
+
+using zhaocc::BenchRun;
+using zhaocc::BenchSample;
+using zhaocc::LatencyRecorder;
+
+constexpr uint64_t kQueueOps = 200000;
+constexpr uint64_t kLockOps = 400000;
+constexpr uint64_t kPoolTasks = 100000;
+constexpr int kSortElements = 20000; // do_sort在等待时嵌套执行其他排序任务，数据量太大时调用栈会溢出
+constexpr int kTimers = 2000;
+constexpr size_t kBufferSize = 4096;
+
+/**
+ * 队列：一半线程生产、一半线程消费，单线程时交替push/try_pop；
+ * 延迟为采样到的push以及成功的try_pop的耗时
+ */
+template<typename QueueType>
+BenchSample bench_queue(BenchRun& run) {
+    QueueType queue;
+    if (run.threads == 1) {
+        double const seconds = run.run_threads(1, [&](unsigned, LatencyRecorder& recorder) {
+            uint64_t value;
+            for (uint64_t i = 0; i < kQueueOps; i++) {
+                recorder.measure([&]() {
+                    queue.push(i);
+                    queue.try_pop(value);
+                });
+            }
+        });
+        return {kQueueOps, seconds};
+    }
+
+    unsigned const producers = run.threads / 2;
+    uint64_t const per_producer = kQueueOps / producers;
+    uint64_t const total = per_producer * producers;
+    std::atomic<uint64_t> consumed(0);
+    double const seconds = run.run_threads(run.threads, [&](unsigned index, LatencyRecorder& recorder) {
+        if (index < producers) {
+            for (uint64_t i = 0; i < per_producer; i++) {
+                recorder.measure([&]() { queue.push(i); });
+            }
+            return;
+        }
+        uint64_t value;
+        uint64_t popped = 0;
+        while (consumed.load(std::memory_order_relaxed) < total) {
+            bool const sample = (popped & (LatencyRecorder::kSampleEvery - 1)) == 0;
+            uint64_t const start = sample ? LatencyRecorder::now_ns() : 0;
+            if (queue.try_pop(value)) {
+                if (sample) {
+                    recorder.record(LatencyRecorder::now_ns() - start);
+                }
+                popped++;
+                consumed.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    return {total, seconds};
+}
+
+/* 栈：每个线程push后立即pop，任何线程pop时栈中至少有它自己push的一个元素，不会抛出EmptyStack */
+BenchSample bench_stack(BenchRun& run) {
+    zhaocc::ThreadSafeStack<uint64_t> stack;
+    uint64_t const per_thread = kQueueOps / run.threads;
+    double const seconds = run.run_threads(run.threads, [&](unsigned, LatencyRecorder& recorder) {
+        uint64_t value;
+        for (uint64_t i = 0; i < per_thread; i++) {
+            recorder.measure([&]() {
+                stack.push(i);
+                stack.pop(value);
+            });
+        }
+    });
+    return {per_thread * run.threads, seconds};
+}
+
+/* 对象池取出/放回缓冲区：ThreadSafeStack只能拷贝，栈为空时抛出异常 */
+bool take_buffer(zhaocc::ThreadSafeStack<std::vector<char>>& pool, std::vector<char>& buffer) {
+    try {
+        pool.pop(buffer);
+        return true;
+    } catch (const zhaocc::EmptyStack&) {
+        return false;
+    }
+}
+
+template<bool LockFree>
+bool take_buffer(zhaocc::ConcurrentStack<std::vector<char>, LockFree>& pool, std::vector<char>& buffer) {
+    return pool.try_pop(buffer);
+}
+
+/* 对象池：每个线程取出一个4KB缓冲区（池为空时新建），使用后放回，延迟为一次取出+放回 */
+template<typename StackType>
+BenchSample bench_recycle(BenchRun& run) {
+    StackType pool;
+    uint64_t const per_thread = kQueueOps / run.threads;
+    double const seconds = run.run_threads(run.threads, [&](unsigned, LatencyRecorder& recorder) {
+        std::vector<char> buffer;
+        for (uint64_t i = 0; i < per_thread; i++) {
+            recorder.measure([&]() {
+                if (!take_buffer(pool, buffer)) {
+                    buffer.assign(kBufferSize, 0);
+                }
+                buffer[i % kBufferSize]++;
+                pool.push(std::move(buffer));
+            });
+        }
+    });
+    return {per_thread * run.threads, seconds};
+}
+
+/* 锁：所有线程争用同一把锁递增计数，延迟为一次加锁+解锁 */
+template<typename LockType>
+BenchSample bench_lock(BenchRun& run) {
+    LockType lock;
+    uint64_t counter = 0;
+    uint64_t const per_thread = kLockOps / run.threads;
+    double const seconds = run.run_threads(run.threads, [&](unsigned, LatencyRecorder& recorder) {
+        for (uint64_t i = 0; i < per_thread; i++) {
+            recorder.measure([&]() {
+                std::lock_guard<LockType> guard(lock);
+                counter++;
+            });
+        }
+    });
+    if (counter != per_thread * run.threads) {
+        throw std::logic_error("lock benchmark lost updates");
+    }
+    return {counter, seconds};
+}
+
+template<typename ThreadPoolType>
+ThreadPoolType* make_pool(BenchRun& run) {
+    return new ThreadPoolType(run.threads, run.pin ? zhaocc::Placement::PIN_CORE : zhaocc::Placement::NONE);
+}
+
+template<>
+zhaocc::SimpleThreadPool* make_pool<zhaocc::SimpleThreadPool>(BenchRun& run) {
+    return new zhaocc::SimpleThreadPool(run.threads); // SimpleThreadPool不支持绑核
+}
+
+template<typename FuncType>
+void post_to(zhaocc::SimpleThreadPool& pool, FuncType f) {
+    pool.submit(std::move(f));
+}
+
+template<typename ThreadPoolType, typename FuncType>
+void post_to(ThreadPoolType& pool, FuncType f) {
+    pool.post(std::move(f));
+}
+
+/**
+ * 线程池：一个外部线程提交kPoolTasks个空任务直到全部执行完，线程数为工作线程数；
+ * 延迟为采样任务从提交到开始执行的时间
+ */
+template<typename ThreadPoolType>
+BenchSample bench_pool(BenchRun& run) {
+    std::unique_ptr<ThreadPoolType> pool(make_pool<ThreadPoolType>(run));
+    std::atomic<uint64_t> done(0);
+    std::vector<uint64_t> waits(kPoolTasks / LatencyRecorder::kSampleEvery, 0); // 每个采样任务只写自己的位置
+
+    auto const begin = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < kPoolTasks; i++) {
+        if (i % LatencyRecorder::kSampleEvery == 0) {
+            uint64_t const submitted = LatencyRecorder::now_ns();
+            post_to(*pool, [&done, &waits, i, submitted]() {
+                waits[i / LatencyRecorder::kSampleEvery] = LatencyRecorder::now_ns() - submitted;
+                done.fetch_add(1, std::memory_order_release);
+            });
+        } else {
+            post_to(*pool, [&done]() { done.fetch_add(1, std::memory_order_release); });
+        }
+    }
+    while (done.load(std::memory_order_acquire) < kPoolTasks) {
+        std::this_thread::yield();
+    }
+    std::chrono::duration<double> const cost = std::chrono::steady_clock::now() - begin;
+    run.latencies.insert(run.latencies.end(), waits.begin(), waits.end());
+    return {kPoolTasks, cost.count()};
+}
+
+/* 并行快速排序：kSortElements个随机整数，吞吐为每秒排序的元素数 */
+template<typename ThreadPoolType>
+BenchSample bench_quick_sort(BenchRun& run) {
+    std::mt19937 rng(42); // 固定种子，每次输入相同
+    std::list<int> data;
+    for (int i = 0; i < kSortElements; i++) {
+        data.push_back(static_cast<int>(rng()));
+    }
+    zhaocc::ParallelQuickSort<int, ThreadPoolType> sorter(run.threads);
+
+    auto const begin = std::chrono::steady_clock::now();
+    std::list<int> sorted = sorter.do_sort(data);
+    std::chrono::duration<double> const cost = std::chrono::steady_clock::now() - begin;
+    if (sorted.size() != static_cast<size_t>(kSortElements) || !std::is_sorted(sorted.begin(), sorted.end())) {
+        throw std::logic_error("parallel quick sort produced a wrong result");
+    }
+    return {static_cast<uint64_t>(kSortElements), cost.count()};
+}
+
+/**
+ * 定时器：kTimers个1~20ms的一次性定时器，吞吐为每秒触发的定时器数（受定时时长限制，主要看延迟）；
+ * 延迟为回调实际执行时间晚于到期时间的部分
+ */
+BenchSample bench_timer(BenchRun& run) {
+    common::ThreadPoolTimerContainer container(static_cast<int>(run.threads));
+    container.Start();
+    std::atomic<int> fired(0);
+    std::vector<uint64_t> lateness(kTimers, 0);
+
+    auto const begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < kTimers; i++) {
+        int const delay_ms = i % 20 + 1;
+        uint64_t const due = LatencyRecorder::now_ns() + static_cast<uint64_t>(delay_ms) * 1000000;
+        container.AddTimer([&fired, &lateness, i, due](void*) {
+            uint64_t const now = LatencyRecorder::now_ns();
+            lateness[i] = now > due ? now - due : 0;
+            fired.fetch_add(1, std::memory_order_release);
+        }, nullptr, delay_ms, nullptr, common::ThreadPoolTimerContainer::MS, false);
+    }
+    while (fired.load(std::memory_order_acquire) < kTimers) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    std::chrono::duration<double> const cost = std::chrono::steady_clock::now() - begin;
+    container.Stop();
+    run.latencies.insert(run.latencies.end(), lateness.begin(), lateness.end());
+    return {static_cast<uint64_t>(kTimers), cost.count()};
+}
+
+int main(int argc, char** argv) {
+    zhaocc::BenchOptions options;
+    try {
+        options = zhaocc::BenchOptions::parse(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        zhaocc::BenchOptions::usage(argv[0]);
+        return 1;
+    }
+
+    zhaocc::BenchSuite suite;
+    suite.add("thread_safe_queue/mpmc", bench_queue<zhaocc::ThreadSafeQueue<uint64_t>>);
+    suite.add("blocking_queue/mpmc", bench_queue<zhaocc::BlockingQueue<uint64_t>>);
+    suite.add("thread_safe_stack/push_pop", bench_stack);
+    suite.add("thread_safe_stack/recycle", bench_recycle<zhaocc::ThreadSafeStack<std::vector<char>>>);
+    suite.add("concurrent_stack/recycle", bench_recycle<zhaocc::ConcurrentStack<std::vector<char>>>);
+    suite.add("concurrent_stack_lock_free/recycle", bench_recycle<zhaocc::ConcurrentStack<std::vector<char>, true>>);
+    suite.add("my_lock/increment", bench_lock<zhaocc::MyLock>);
+    suite.add("std_mutex/increment", bench_lock<std::mutex>); // 作为MyLock的对照
+    suite.add("simple_thread_pool/post", bench_pool<zhaocc::SimpleThreadPool>);
+    suite.add("futured_thread_pool/post", bench_pool<zhaocc::FuturedThreadPool>);
+    suite.add("multi_queue_thread_pool/post", bench_pool<zhaocc::MultiQueueThreadPool>);
+    suite.add("parallel_quick_sort/futured", bench_quick_sort<zhaocc::FuturedThreadPool>);
+    suite.add("parallel_quick_sort/multi_queue", bench_quick_sort<zhaocc::MultiQueueThreadPool>);
+    suite.add("timer_container/one_shot", bench_timer);
+    suite.run(options);
+
+    if (!options.json_path.empty()) {
+        if (!suite.write_json(options)) {
+            std::cerr << "failed to write " << options.json_path << std::endl;
+            return 1;
+        }
+        std::cout << "results written to " << options.json_path << std::endl;
+    }
+}
@@ -3,6 +3,8 @@
  */
 
 #include <iostream>
+#include <thread>
+#include <utility> // boost 1.74的asio/awaitable.hpp在C++20下使用std::exchange但没有包含<utility>
 #include <boost/asio.hpp>
 
 void task1() {
@@ -0,0 +1,188 @@
+/**
+ * 测试批量接口：ThreadSafeQueue和PriorityLanes的批量push/pop，两种线程池的submit_bulk（迭代器范围与range重载）、submit_n，
+ * 包括空范围、单个工作线程时的执行顺序、每个任务的future，以及FuturedThreadPool中一个长任务不会拖住之后的任务。
+ */
+
+#include <iostream>
+#include <vector>
+#include <list>
+#include <memory>
+#include <string>
+#include <functional>
+#include <iterator>
+#include <future>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <stdexcept>
+#include <cassert>
+
+#include "thread_safe_queue.hpp"
+#include "priority_lanes.hpp"
+#include "futured_thread_pool.hpp"
+#include "multi_queue_thread_pool.hpp"
+
+void test_queue_bulk() {
+    zhaocc::ThreadSafeQueue<int> queue;
+    std::vector<int> const empty;
+    assert(queue.push_bulk(empty.begin(), empty.end()) == 0 && queue.empty());
+
+    std::vector<int> in{1, 2, 3, 4, 5};
+    assert(queue.push_bulk(in.begin(), in.end()) == 5);
+    queue.push(6); // 批量push之后单个push仍然接在尾部
+    std::vector<int> out;
+    assert(queue.try_pop_bulk(std::back_inserter(out), 0) == 0);
+    assert(queue.try_pop_bulk(std::back_inserter(out), 3) == 3);
+    assert(queue.try_pop_bulk(std::back_inserter(out), 10) == 3);
+    assert(queue.try_pop_bulk(std::back_inserter(out), 10) == 0);
+    assert((out == std::vector<int>{1, 2, 3, 4, 5, 6}) && queue.empty());
+
+    // 只能移动的元素
+    zhaocc::ThreadSafeQueue<std::unique_ptr<int>> ptr_queue;
+    std::vector<std::unique_ptr<int>> ptrs;
+    ptrs.push_back(std::make_unique<int>(7));
+    ptrs.push_back(std::make_unique<int>(8));
+    assert(ptr_queue.push_bulk(std::make_move_iterator(ptrs.begin()), std::make_move_iterator(ptrs.end())) == 2);
+    std::vector<std::unique_ptr<int>> ptr_out;
+    assert(ptr_queue.try_pop_bulk(std::back_inserter(ptr_out), 2) == 2);
+    assert(*ptr_out[0] == 7 && *ptr_out[1] == 8);
+
+    // 批量push唤醒所有阻塞在wait_and_pop上的线程
+    zhaocc::ThreadSafeQueue<int> blocking_queue;
+    std::vector<std::thread> consumers;
+    std::vector<int> consumed(3);
+    for (int i = 0; i < 3; i++) {
+        consumers.emplace_back([&blocking_queue, &consumed, i]() { blocking_queue.wait_and_pop(consumed[i]); });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // 让消费者先阻塞
+    std::vector<int> wake{1, 2, 3};
+    blocking_queue.push_bulk(wake.begin(), wake.end());
+    for (auto& th : consumers) {
+        th.join();
+    }
+    assert(consumed[0] + consumed[1] + consumed[2] == 6 && blocking_queue.empty());
+
+    // PriorityLanes批量出队时第一个之后只取NORMAL任务，这里没有NORMAL任务，每次只取一个
+    zhaocc::PriorityLanes<int> lanes;
+    std::vector<int> background{20, 21, 22};
+    lanes.push_bulk(zhaocc::Priority::BACKGROUND, background.begin(), background.end());
+    lanes.push(zhaocc::Priority::REALTIME, 0);
+    std::vector<int> popped;
+    size_t total = 0;
+    for (size_t n; (n = lanes.try_pop_bulk(std::back_inserter(popped), 8)) > 0;) {
+        assert(n == 1);
+        total += n;
+    }
+    assert(total == 4 && !lanes.has(zhaocc::Priority::BACKGROUND));
+}
+
+template<typename Pool>
+void test_pool_bulk(const char* name) {
+    {
+        Pool pool(1); // 单个工作线程按提交顺序执行
+        std::mutex m;
+        std::vector<int> order;
+        std::vector<std::function<int()>> tasks;
+        for (int i = 0; i < 100; i++) {
+            tasks.emplace_back([i, &m, &order]() {
+                std::lock_guard<std::mutex> lock(m);
+                order.push_back(i);
+                return i * 2;
+            });
+        }
+        auto futures = pool.submit_bulk(tasks.begin(), tasks.end());
+        assert(futures.size() == 100);
+        for (int i = 0; i < 100; i++) {
+            assert(futures[i].get() == i * 2);
+        }
+        for (int i = 0; i < 100; i++) {
+            assert(order[i] == i);
+        }
+    }
+
+    Pool pool(4);
+    // range重载，list的迭代器不是随机访问迭代器
+    std::list<std::function<std::string()>> named;
+    for (int i = 0; i < 64; i++) {
+        named.emplace_back([i]() { return std::to_string(i); });
+    }
+    auto named_futures = pool.submit_bulk(named);
+    for (int i = 0; i < 64; i++) {
+        assert(named_futures[i].get() == std::to_string(i));
+    }
+
+    // 空范围不提交任何任务
+    std::vector<std::function<int()>> none;
+    assert(pool.submit_bulk(none).empty());
+    assert(pool.submit_n(0, [](size_t i) { return i; }).empty());
+
+    // 每个任务的异常只出现在自己的future中
+    std::vector<std::function<void()>> mixed;
+    for (int i = 0; i < 10; i++) {
+        mixed.emplace_back([i]() {
+            if (i % 3 == 0) {
+                throw std::runtime_error("task failed");
+            }
+        });
+    }
+    auto mixed_futures = pool.submit_bulk(mixed);
+    for (int i = 0; i < 10; i++) {
+        bool thrown = false;
+        try {
+            mixed_futures[i].get();
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown == (i % 3 == 0));
+    }
+
+    // 一次扇出256个任务
+    auto squares = pool.submit_n(256, [](size_t i) -> size_t { return i * i; });
+    for (size_t i = 0; i < squares.size(); i++) {
+        assert(squares[i].get() == i * i);
+    }
+
+    // 在工作线程中批量提交子任务
+    auto outer = pool.submit([&pool]() {
+        auto inner = pool.submit_n(32, [](size_t i) { return static_cast<int>(i); });
+        int sum = 0;
+        for (auto& f : inner) {
+            while (f.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                pool.run_pending_task(); // 等待期间帮助执行，防止占住唯一空闲的工作线程
+            }
+            sum += f.get();
+        }
+        return sum;
+    });
+    assert(outer.get() == 31 * 32 / 2);
+    pool.wait_idle();
+    std::cout << name << " bulk submit ok" << std::endl;
+}
+
+/* 一个工作线程在执行长任务时，排在它后面的任务由其他空闲的工作线程执行，不会被取到长任务所在线程的私有批次中 */
+void test_long_task_does_not_stall_batch() {
+    zhaocc::FuturedThreadPool pool(2);
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::vector<std::function<int()>> tasks;
+    tasks.emplace_back([released]() {
+        released.wait();
+        return 0;
+    });
+    for (int i = 1; i <= 3; i++) {
+        tasks.emplace_back([i]() { return i; });
+    }
+    auto futures = pool.submit_bulk(tasks);
+    for (int i = 1; i <= 3; i++) {
+        assert(futures[i].wait_for(std::chrono::seconds(5)) == std::future_status::ready && futures[i].get() == i);
+    }
+    release.set_value();
+    assert(futures[0].get() == 0);
+}
+
+int main() {
+    test_queue_bulk();
+    test_pool_bulk<zhaocc::FuturedThreadPool>("FuturedThreadPool");
+    test_pool_bulk<zhaocc::MultiQueueThreadPool>("MultiQueueThreadPool");
+    test_long_task_does_not_stall_batch();
+}
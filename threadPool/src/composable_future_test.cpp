@@ -0,0 +1,85 @@
+/**
+ * 测试可组合的future：then流水线、when_all、when_any以及异常传递
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <stdexcept>
+#include <cassert>
+
+#include "multi_queue_thread_pool.hpp"
+#include "composable_future.hpp"
+
+/* then组成的流水线，每一步都在线程池中执行，没有线程阻塞等待中间结果 */
+void test_then(zhaocc::MultiQueueThreadPool& pool) {
+    zhaocc::Future<std::string> result = zhaocc::spawn(pool, []() { return 21; })
+            .then(pool, [](zhaocc::Future<int> f) { return f.get() * 2; })
+            .then(pool, [](zhaocc::Future<int> f) { return "answer: " + std::to_string(f.get()); });
+    std::string res = result.get();
+    assert(res == "answer: 42");
+    std::cout << res << std::endl;
+
+    // 异常沿着流水线传递，直到有后继处理它
+    zhaocc::Future<int> recovered = zhaocc::spawn(pool, []() -> int { throw std::runtime_error("step failed"); })
+            .then(pool, [](zhaocc::Future<int> f) { return f.get() + 1; }) // get重新抛出，本步骤也失败
+            .then(pool, [](zhaocc::Future<int> f) {
+                try {
+                    return f.get();
+                } catch (const std::runtime_error& e) {
+                    std::cout << "recovered from: " << e.what() << std::endl;
+                    return -1;
+                }
+            });
+    assert(recovered.get() == -1);
+
+    // void的流水线
+    bool ran = false;
+    zhaocc::spawn(pool, [&ran]() { ran = true; }).then(pool, [](zhaocc::Future<void> f) { f.get(); }).get();
+    assert(ran);
+}
+
+/* when_all汇总扇出的结果 */
+void test_when_all(zhaocc::MultiQueueThreadPool& pool) {
+    std::vector<zhaocc::Future<int>> futures;
+    for (int i = 0; i < 100; i++) {
+        futures.emplace_back(zhaocc::spawn(pool, [i]() { return i; }));
+    }
+    zhaocc::Future<long> sum = zhaocc::when_all(std::move(futures))
+            .then(pool, [](zhaocc::Future<std::vector<zhaocc::Future<int>>> all) {
+                long s = 0;
+                for (auto& f : all.get()) {
+                    s += f.get();
+                }
+                return s;
+            });
+    long res = sum.get();
+    assert(res == 4950);
+    std::cout << "when_all sum: " << res << std::endl;
+
+    assert(zhaocc::when_all(std::vector<zhaocc::Future<int>>()).get().empty());
+}
+
+/* when_any取第一个就绪的结果 */
+void test_when_any(zhaocc::MultiQueueThreadPool& pool) {
+    zhaocc::Promise<int> never_set;
+    std::vector<zhaocc::Future<int>> futures;
+    futures.emplace_back(never_set.get_future());
+    futures.emplace_back(zhaocc::spawn(pool, []() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        return 7;
+    }));
+    auto any = zhaocc::when_any(std::move(futures)).get();
+    assert(any.index == 1 && any.futures[1].get() == 7);
+    std::cout << "when_any index: " << any.index << std::endl;
+    never_set.set_value(0);
+}
+
+int main() {
+    zhaocc::MultiQueueThreadPool pool(2);
+    test_then(pool);
+    test_when_all(pool);
+    test_when_any(pool);
+}
@@ -0,0 +1,178 @@
+/**
+ * 并发容器的压力测试与线性一致性检查：zhaocc::ThreadSafeQueue、BlockingQueue（syncConcurrent）、
+ * ThreadSafeStack、ConcurrentStack（sharedDataBetweenThreads）以及lock_free_stack（atomic）。
+ * 新的容器实现写一个适配器加到main中即可。TSan下（tsan preset）自动减小规模：
+ *   cmake --preset tsan && cmake --build --preset tsan && ctest --preset tsan -R container_stress
+ * 参数：--seed N 改变随机种子，--scale N 把元素数和轮数放大N倍用于长时间运行。
+ */
+
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <cassert>
+
+#include "stress_harness.hpp"
+#include "thread_safe_queue.hpp"
+#include "blocking_queue.hpp" // syncConcurrent/include
+#include "thread_safe_stack.hpp" // sharedDataBetweenThreads/include
+#include "concurrent_stack.hpp" // sharedDataBetweenThreads/include
+#include "lock_free_stack.hpp" // atomic/include
+
+#if defined(__SANITIZE_THREAD__)
+#define UNDER_TSAN 1
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define UNDER_TSAN 1
+#endif
+#endif
+
+#ifdef UNDER_TSAN
+constexpr uint64_t kBaseScale = 1; // TSan下慢5~15倍
+#else
+constexpr uint64_t kBaseScale = 10;
+#endif
+
+struct ThreadSafeQueueAdapter {
+    using Container = zhaocc::ThreadSafeQueue<uint64_t>;
+    static constexpr zhaocc::ContainerOrder kOrder = zhaocc::ContainerOrder::FIFO;
+
+    static void push(Container& c, uint64_t v) { c.push(v); }
+
+    static bool try_pop(Container& c, uint64_t& v) { return c.try_pop(v); }
+};
+
+struct BlockingQueueAdapter {
+    using Container = zhaocc::BlockingQueue<uint64_t>;
+    static constexpr zhaocc::ContainerOrder kOrder = zhaocc::ContainerOrder::FIFO;
+
+    static void push(Container& c, uint64_t v) { c.push(v); }
+
+    static bool try_pop(Container& c, uint64_t& v) { return c.try_pop(v); }
+};
+
+/* 消费者用drain_into批量取出 */
+struct BlockingQueueDrainAdapter {
+    using Container = zhaocc::BlockingQueue<uint64_t>;
+    static constexpr zhaocc::ContainerOrder kOrder = zhaocc::ContainerOrder::FIFO;
+
+    static void push(Container& c, uint64_t v) { c.push(v); }
+
+    static size_t pop_batch(Container& c, std::vector<uint64_t>& out) { return c.drain_into(out); }
+};
+
+struct ThreadSafeStackAdapter {
+    using Container = zhaocc::ThreadSafeStack<uint64_t>;
+    static constexpr zhaocc::ContainerOrder kOrder = zhaocc::ContainerOrder::LIFO;
+
+    static void push(Container& c, uint64_t v) { c.push(v); }
+
+    static bool try_pop(Container& c, uint64_t& v) {
+        try {
+            c.pop(v);
+            return true;
+        } catch (const zhaocc::EmptyStack&) {
+            return false;
+        }
+    }
+};
+
+template<bool LockFree>
+struct ConcurrentStackAdapter {
+    using Container = zhaocc::ConcurrentStack<uint64_t, LockFree>;
+    static constexpr zhaocc::ContainerOrder kOrder = zhaocc::ContainerOrder::LIFO;
+
+    static void push(Container& c, uint64_t v) { c.push(v); }
+
+    static bool try_pop(Container& c, uint64_t& v) { return c.try_pop(v); }
+};
+
+struct LockFreeStackAdapter {
+    using Container = zhaocc::lock_free_stack<uint64_t>;
+    static constexpr zhaocc::ContainerOrder kOrder = zhaocc::ContainerOrder::LIFO;
+
+    static void push(Container& c, uint64_t v) { c.push(v); }
+
+    static size_t pop_batch(Container& c, std::vector<uint64_t>& out) { return c.pop_all(std::back_inserter(out)); }
+};
+
+/* 把栈当作队列：用来确认检查本身能发现顺序错误 */
+struct StackAsQueueAdapter : ThreadSafeStackAdapter {
+    static constexpr zhaocc::ContainerOrder kOrder = zhaocc::ContainerOrder::FIFO;
+};
+
+template<typename Adapter>
+bool check(const char* name, uint64_t scale, uint64_t seed) {
+    bool ok = true;
+    zhaocc::StressOptions options;
+    options.per_producer = 2000 * scale;
+    options.seed = seed;
+    for (auto [producers, consumers] : {std::pair<unsigned, unsigned>{1, 1}, {4, 1}, {1, 4}, {4, 4}}) {
+        options.producers = producers;
+        options.consumers = consumers;
+        zhaocc::StressReport const report = zhaocc::StressHarness::run_mpmc<Adapter>(options);
+        std::cout << name << " mpmc " << producers << "x" << consumers << ": " << report.popped << "/"
+                  << report.pushed << (report.ok ? " ok" : " FAILED: " + report.message) << std::endl;
+        ok = ok && report.ok;
+    }
+    if constexpr (zhaocc::HasTryPop<Adapter>) {
+        unsigned const rounds = static_cast<unsigned>(100 * scale);
+        zhaocc::StressReport const report = zhaocc::StressHarness::run_linearizability<Adapter>(rounds, 3, 4, seed);
+        std::cout << name << " linearizability: " << rounds << " rounds"
+                  << (report.ok ? " ok" : " FAILED: " + report.message) << std::endl;
+        ok = ok && report.ok;
+    }
+    return ok;
+}
+
+/* 检查器自身：已知的可线性化/不可线性化历史 */
+void test_checker() {
+    using Op = zhaocc::StressHarness::Operation;
+    using zhaocc::ContainerOrder;
+    // 两个并发的push之后顺序pop：两种出队顺序都可以
+    std::vector<Op> concurrent{{true, 1, true, 0, 3}, {true, 2, true, 1, 2}, {false, 2, true, 4, 5},
+                               {false, 1, true, 6, 7}};
+    assert(zhaocc::StressHarness::is_linearizable(concurrent, ContainerOrder::FIFO));
+    assert(zhaocc::StressHarness::is_linearizable(concurrent, ContainerOrder::LIFO));
+    // push(1)、push(2)先后完成，FIFO必须先出1
+    std::vector<Op> sequential{{true, 1, true, 0, 1}, {true, 2, true, 2, 3}, {false, 2, true, 4, 5}};
+    assert(!zhaocc::StressHarness::is_linearizable(sequential, ContainerOrder::FIFO));
+    assert(zhaocc::StressHarness::is_linearizable(sequential, ContainerOrder::LIFO));
+    // push完成后try_pop不能返回空
+    std::vector<Op> lost{{true, 1, true, 0, 1}, {false, 0, false, 2, 3}};
+    assert(!zhaocc::StressHarness::is_linearizable(lost, ContainerOrder::FIFO));
+}
+
+int main(int argc, char** argv) {
+    uint64_t scale = kBaseScale;
+    uint64_t seed = 1;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string const arg = argv[i];
+        if (arg == "--seed") {
+            seed = std::stoull(argv[i + 1]);
+        } else if (arg == "--scale") {
+            scale = kBaseScale * std::stoull(argv[i + 1]);
+        }
+    }
+
+    test_checker();
+    bool ok = true;
+    ok = check<ThreadSafeQueueAdapter>("ThreadSafeQueue", scale, seed) && ok;
+    ok = check<BlockingQueueAdapter>("BlockingQueue", scale, seed) && ok;
+    ok = check<BlockingQueueDrainAdapter>("BlockingQueue drain_into", scale, seed) && ok;
+    ok = check<ThreadSafeStackAdapter>("ThreadSafeStack", scale, seed) && ok;
+    ok = check<ConcurrentStackAdapter<false>>("ConcurrentStack", scale, seed) && ok;
+    ok = check<ConcurrentStackAdapter<true>>("ConcurrentStack lock-free", scale, seed) && ok;
+    ok = check<LockFreeStackAdapter>("lock_free_stack", scale, seed) && ok;
+
+    // 栈当作队列必须被发现
+    zhaocc::StressOptions options;
+    options.producers = 1;
+    options.consumers = 1;
+    options.seed = seed;
+    bool const caught = !zhaocc::StressHarness::run_mpmc<StackAsQueueAdapter>(options).ok &&
+                        !zhaocc::StressHarness::run_linearizability<StackAsQueueAdapter>(100, 3, 4, seed).ok;
+    std::cout << "stack checked as a queue is " << (caught ? "rejected" : "NOT rejected") << std::endl;
+
+    return ok && caught ? 0 : 1;
+}
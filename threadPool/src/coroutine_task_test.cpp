@@ -0,0 +1,149 @@
+/**
+ * 测试C++20协程Task与线程池、定时器的结合
+ */
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <future>
+#include <stdexcept>
+#include <cassert>
+
+#include "multi_queue_thread_pool.hpp"
+#include "coroutine_task.hpp"
+
+using Pool = zhaocc::MultiQueueThreadPool;
+
+zhaocc::Task<int> square(Pool& pool, int x) {
+    co_await zhaocc::schedule(pool); // 切换到工作线程
+    co_return x * x;
+}
+
+zhaocc::Task<int> sum_of_squares(Pool& pool, int n) {
+    int sum = 0;
+    for (int i = 1; i <= n; i++) {
+        sum += co_await square(pool, i); // 子Task结束时直接恢复本协程
+        co_await zhaocc::yield(pool); // 每算一个让出一次工作线程
+    }
+    co_return sum;
+}
+
+zhaocc::Task<> fail(Pool& pool) {
+    co_await zhaocc::schedule(pool);
+    throw std::runtime_error("coroutine failed");
+}
+
+/* 模拟一次异步操作：等待delay后返回id，等待期间不占用线程 */
+zhaocc::Task<int> fake_rpc(common::ThreadPoolTimerContainer& timer, Pool& pool, int id,
+                           std::chrono::milliseconds delay) {
+    co_await zhaocc::sleep_for(timer, pool, delay);
+    co_return id;
+}
+
+static std::atomic<int> frames_destroyed(0);
+
+/* 随协程帧一起析构，用于检查被丢弃的恢复不会让协程帧泄漏 */
+struct FrameTracker {
+    ~FrameTracker() {
+        frames_destroyed++;
+    }
+};
+
+/* 在唯一的工作线程上先投递一个阻塞任务，让yield的恢复排在它后面 */
+zhaocc::Task<int> blocked_after_yield(Pool& pool, std::shared_future<void> released) {
+    FrameTracker tracker;
+    pool.post([released]() { released.wait(); });
+    co_await zhaocc::yield(pool);
+    co_return 1;
+}
+
+zhaocc::Task<int> tracked_sleep(common::ThreadPoolTimerContainer& timer, Pool& pool) {
+    FrameTracker tracker;
+    co_return co_await fake_rpc(timer, pool, 1, std::chrono::seconds(10));
+}
+
+/* 判断Future是否以broken_promise结束 */
+bool is_broken(zhaocc::Future<int>& future) {
+    try {
+        future.get();
+    } catch (const std::future_error& e) {
+        return e.code() == std::future_errc::broken_promise;
+    }
+    return false;
+}
+
+void test_basic(Pool& pool) {
+    int res = zhaocc::co_spawn(pool, sum_of_squares(pool, 10)).get();
+    assert(res == 385);
+    std::cout << "sum of squares: " << res << std::endl;
+
+    bool thrown = false;
+    try {
+        zhaocc::co_spawn(pool, fail(pool)).get();
+    } catch (const std::runtime_error& e) {
+        thrown = true;
+        std::cout << "exception: " << e.what() << std::endl;
+    }
+    assert(thrown);
+}
+
+/* 大量同时进行中的异步操作共享固定的工作线程 */
+void test_many_in_flight(Pool& pool, int count) {
+    common::ThreadPoolTimerContainer timer(1);
+    timer.Start();
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<zhaocc::Future<int>> futures;
+    futures.reserve(count);
+    for (int i = 0; i < count; i++) {
+        futures.emplace_back(zhaocc::co_spawn(pool, fake_rpc(timer, pool, i, std::chrono::milliseconds(100))));
+    }
+    long long sum = 0;
+    for (auto& f : zhaocc::when_all(std::move(futures)).get()) {
+        sum += f.get();
+    }
+    std::chrono::duration<double, std::milli> cost = std::chrono::steady_clock::now() - begin;
+    assert(sum == (long long) count * (count - 1) / 2);
+    std::cout << count << " coroutines each sleeping 100ms on " << pool.thread_count()
+              << " worker threads finished in " << cost.count() << "ms" << std::endl;
+    timer.Stop();
+}
+
+/* 线程池以ABANDON关闭或者定时器容器停止时，挂起的协程链被销毁，Future得到broken_promise */
+void test_dropped_resume() {
+    zhaocc::Future<int> abandoned;
+    {
+        Pool pool(1);
+        std::promise<void> release;
+        abandoned = zhaocc::co_spawn(pool, blocked_after_yield(pool, release.get_future().share()));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50)); // 工作线程已经在执行阻塞任务
+        std::thread stopper([&pool]() { pool.shutdown(zhaocc::ShutdownMode::ABANDON); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50)); // 已经设置关闭标志
+        release.set_value();
+        stopper.join();
+    } // 线程池析构时丢弃恢复任务
+    assert(frames_destroyed == 1);
+    assert(is_broken(abandoned));
+
+    Pool pool(1);
+    zhaocc::Future<int> sleeping;
+    {
+        common::ThreadPoolTimerContainer timer(1);
+        timer.Start();
+        sleeping = zhaocc::co_spawn(pool, tracked_sleep(timer, pool));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50)); // 已经挂起在定时器上
+        timer.Stop();
+    } // 定时器容器析构时丢弃回调
+    assert(frames_destroyed == 2);
+    assert(is_broken(sleeping));
+    std::cout << "dropped resumptions destroy the coroutine frames" << std::endl;
+}
+
+int main() {
+    Pool pool(2);
+    test_basic(pool);
+    test_many_in_flight(pool, 20000);
+    test_dropped_resume();
+}
@@ -0,0 +1,75 @@
+/**
+ * 测试/sys的解析和工作线程的绑定：打印NUMA节点与CPU，检查绑定后任务运行在对应的CPU上
+ */
+
+#include <iostream>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <future>
+#include <cassert>
+#include <sched.h>
+
+#include "cpu_topology.hpp"
+#include "futured_thread_pool.hpp"
+#include "multi_queue_thread_pool.hpp"
+
+void test_parse() {
+    assert((zhaocc::CpuTopology::parse_cpu_list("0-3,8-9") == std::vector<int>{0, 1, 2, 3, 8, 9}));
+    assert((zhaocc::CpuTopology::parse_cpu_list("5") == std::vector<int>{5}));
+    assert((zhaocc::CpuTopology::parse_cpu_list("2,1,1-2") == std::vector<int>{1, 2}));
+    assert(zhaocc::CpuTopology::parse_cpu_list("").empty());
+}
+
+void print_topology() {
+    zhaocc::CpuTopology const& topology = zhaocc::CpuTopology::instance();
+    std::cout << "nodes: " << topology.node_count() << ", cpus: " << topology.cpu_count() << std::endl;
+    for (unsigned node = 0; node < topology.node_count(); node++) {
+        std::cout << "node" << node << ":";
+        for (int cpu : topology.cpus_of_node(node)) {
+            std::cout << " " << cpu;
+        }
+        std::cout << std::endl;
+    }
+}
+
+/* PIN_CORE时位置为slot的工作线程只会运行在cpu_for_slot(slot)上 */
+void test_pin_core() {
+    zhaocc::CpuTopology const& topology = zhaocc::CpuTopology::instance();
+    unsigned const count = topology.cpu_count();
+    std::set<int> expected;
+    for (unsigned slot = 0; slot < count; slot++) {
+        expected.insert(topology.cpu_for_slot(slot));
+    }
+
+    zhaocc::FuturedThreadPool pool(count, zhaocc::Placement::PIN_CORE);
+    std::mutex m;
+    std::set<int> seen;
+    std::vector<std::future<void>> futures = pool.submit_n(1000, [&](size_t) {
+        int const cpu = sched_getcpu();
+        std::lock_guard<std::mutex> lock(m);
+        seen.insert(cpu);
+    });
+    for (auto& future : futures) {
+        future.get();
+    }
+    for (int cpu : seen) {
+        assert(expected.count(cpu) == 1);
+    }
+    std::cout << "pin core: tasks ran on " << seen.size() << " of " << count << " cpus" << std::endl;
+}
+
+/* PIN_NODE时任务窃取优先同一节点，这里只检查任务都能完成 */
+void test_pin_node() {
+    zhaocc::MultiQueueThreadPool pool(zhaocc::CpuTopology::instance().cpu_count(), zhaocc::Placement::PIN_NODE);
+    std::future<int> res = pool.submit([]() { return 42; });
+    assert(res.get() == 42);
+    std::cout << "pin node: ok" << std::endl;
+}
+
+int main() {
+    test_parse();
+    print_topology();
+    test_pin_core();
+    test_pin_node();
+}
@@ -0,0 +1,78 @@
+/**
+ * 测试弹性线程池：突发的阻塞型任务使线程数量增长，空闲一段时间后线程数量回落到min_threads
+ */
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <future>
+#include <cassert>
+
+#include "futured_thread_pool.hpp"
+#include "multi_queue_thread_pool.hpp"
+
+/* 每个任务阻塞sleep_ms毫秒，模拟IO；打印完成耗时和线程数量的变化 */
+template<typename ThreadPoolType>
+void test_burst(const char* name, ThreadPoolType& pool, int tasks, int sleep_ms, unsigned min_threads) {
+    std::atomic<unsigned> peak(pool.thread_count());
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::future<void>> futures = pool.submit_n(tasks, [&](size_t) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
+        unsigned const n = pool.thread_count();
+        unsigned p = peak.load();
+        while (n > p && !peak.compare_exchange_weak(p, n)) {}
+    });
+    for (auto& future : futures) {
+        future.get();
+    }
+    std::chrono::duration<double, std::milli> cost = std::chrono::steady_clock::now() - begin;
+    std::cout << name << ": " << tasks << " tasks x " << sleep_ms << "ms, cost " << cost.count()
+              << "ms, peak threads " << peak.load() << std::endl;
+    assert(peak.load() > min_threads); // 排队时间超过阈值后扩容
+
+    for (int i = 0; i < 100 && pool.thread_count() > min_threads; i++) { // 空闲超过idle_timeout后缩容
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    std::cout << name << ": threads after idle " << pool.thread_count() << std::endl;
+    assert(pool.thread_count() == min_threads);
+}
+
+/* 缩容之后再次扩容，被退出线程占用的位置会被复用 */
+void test_regrow(zhaocc::FuturedThreadPool& pool) {
+    std::atomic<int> count(0);
+    std::vector<std::future<void>> futures = pool.submit_n(50, [&](size_t) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        ++count;
+    });
+    for (auto& future : futures) {
+        future.get();
+    }
+    assert(count == 50);
+    std::cout << "regrow: threads " << pool.thread_count() << std::endl;
+}
+
+int main() {
+    zhaocc::ElasticOptions options;
+    options.min_threads = 1;
+    options.max_threads = 16;
+    options.grow_wait_threshold = std::chrono::milliseconds(2);
+    options.idle_timeout = std::chrono::milliseconds(200);
+
+    {
+        zhaocc::FuturedThreadPool pool(options);
+        assert(pool.thread_count() == 1);
+        test_burst("futured", pool, 200, 10, options.min_threads);
+        test_regrow(pool);
+    }
+    {
+        zhaocc::MultiQueueThreadPool pool(options);
+        test_burst("multi queue", pool, 100, 10, options.min_threads);
+    }
+    {
+        zhaocc::FuturedThreadPool fixed(4); // 固定线程数量，与原来的行为一致
+        assert(fixed.thread_count() == 4);
+        std::cout << "fixed: " << fixed.submit([]() { return 42; }).get() << std::endl;
+    }
+}
@@ -0,0 +1,63 @@
+/**
+ * 头文件ODR测试：本文件和header_odr_test_other.cpp都包含所有头文件并链接到同一个程序中，
+ * 头文件中类外定义的非模板函数缺少inline、或者在命名空间作用域定义静态成员时链接会出现重复定义。
+ * 同时检查线程池在一个编译单元中创建、在另一个编译单元中使用时，工作线程的thread_local状态是同一份。
+ */
+
+#include <iostream>
+#include <cassert>
+
+#include "bench_harness.hpp"
+#include "cancellation.hpp"
+#include "composable_future.hpp"
+#include "coroutine_task.hpp"
+#include "cpu_topology.hpp"
+#include "elastic_scaler.hpp"
+#include "function_wrapper.hpp"
+#include "futured_thread_pool.hpp"
+#include "global_async.hpp"
+#include "multi_queue_thread_pool.hpp"
+#include "parallel_algorithms.hpp"
+#include "parallel_quick_sort.hpp"
+#include "pool_telemetry.hpp"
+#include "priority_lanes.hpp"
+#include "simple_thread_pool.hpp"
+#include "strand.hpp"
+#include "stress_harness.hpp"
+#include "task_graph.hpp"
+#include "thread_safe_queue.hpp"
+#include "threads_joiner.hpp"
+#include "thread_pool_timer_container.h"
+#include "blocking_queue.hpp"
+#include "serial_executor.hpp"
+#include "spsc_queue.hpp"
+#include "sync_primitives.hpp"
+#include "concurrent_cache.hpp"
+#include "concurrent_hash_map.hpp"
+#include "concurrent_stack.hpp"
+#include "epoch_reclaimer.hpp"
+#include "multi_lock.hpp"
+#include "profiled_mutex.hpp"
+#include "rcu_snapshot.hpp"
+#include "thread_safe_stack.hpp"
+#include "cpu_relax.hpp"
+#include "lock_free_stack.hpp"
+#include "my_lock.hpp"
+#include "seq_lock.hpp"
+
+/* 在header_odr_test_other.cpp中定义 */
+int submit_from_other_unit(zhaocc::FuturedThreadPool& futured, zhaocc::MultiQueueThreadPool& multi_queue);
+void run_simple_pool_in_other_unit();
+
+int main() {
+    zhaocc::FuturedThreadPool futured(2);
+    zhaocc::MultiQueueThreadPool multi_queue(2);
+    assert(futured.submit([]() { return 1; }).get() == 1);
+    assert(multi_queue.submit([]() { return 2; }).get() == 2);
+    assert(submit_from_other_unit(futured, multi_queue) == 3 + 4 + 5);
+    futured.wait_idle();
+    multi_queue.wait_idle();
+
+    run_simple_pool_in_other_unit();
+    std::cout << "header odr ok" << std::endl;
+}
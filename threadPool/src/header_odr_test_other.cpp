@@ -0,0 +1,73 @@
+/**
+ * 头文件ODR测试的第二个编译单元，与header_odr_test.cpp包含相同的头文件。
+ */
+
+#include <future>
+#include <atomic>
+#include <cassert>
+
+#include "bench_harness.hpp"
+#include "cancellation.hpp"
+#include "composable_future.hpp"
+#include "coroutine_task.hpp"
+#include "cpu_topology.hpp"
+#include "elastic_scaler.hpp"
+#include "function_wrapper.hpp"
+#include "futured_thread_pool.hpp"
+#include "global_async.hpp"
+#include "multi_queue_thread_pool.hpp"
+#include "parallel_algorithms.hpp"
+#include "parallel_quick_sort.hpp"
+#include "pool_telemetry.hpp"
+#include "priority_lanes.hpp"
+#include "simple_thread_pool.hpp"
+#include "strand.hpp"
+#include "stress_harness.hpp"
+#include "task_graph.hpp"
+#include "thread_safe_queue.hpp"
+#include "threads_joiner.hpp"
+#include "thread_pool_timer_container.h"
+#include "blocking_queue.hpp"
+#include "serial_executor.hpp"
+#include "spsc_queue.hpp"
+#include "sync_primitives.hpp"
+#include "concurrent_cache.hpp"
+#include "concurrent_hash_map.hpp"
+#include "concurrent_stack.hpp"
+#include "epoch_reclaimer.hpp"
+#include "multi_lock.hpp"
+#include "profiled_mutex.hpp"
+#include "rcu_snapshot.hpp"
+#include "thread_safe_stack.hpp"
+#include "cpu_relax.hpp"
+#include "lock_free_stack.hpp"
+#include "my_lock.hpp"
+#include "seq_lock.hpp"
+
+int submit_from_other_unit(zhaocc::FuturedThreadPool& futured, zhaocc::MultiQueueThreadPool& multi_queue) {
+    // 在工作线程中提交子任务，子任务放入本线程的任务队列，依赖两个编译单元看到同一个thread_local
+    auto outer = multi_queue.submit([&multi_queue]() {
+        auto inner = multi_queue.submit([]() { return 4; });
+        while (inner.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            multi_queue.run_pending_task();
+        }
+        return inner.get();
+    });
+    auto futured_result = futured.submit([]() { return 3; });
+    auto tail = futured.submit([]() { return 5; });
+    return futured_result.get() + outer.get() + tail.get();
+}
+
+void run_simple_pool_in_other_unit() {
+    std::atomic<int> count{0};
+    {
+        zhaocc::SimpleThreadPool simple(2);
+        for (int i = 0; i < 8; i++) {
+            simple.submit([&count]() { count++; });
+        }
+        while (count.load() < 8) {
+            std::this_thread::yield();
+        }
+    }
+    assert(count.load() == 8);
+}
@@ -6,6 +6,9 @@
 #include <thread>
 #include <chrono>
 #include <cassert>
+#include <vector>
+#include <functional>
+#include <iterator>
 
 #include "thread_safe_queue.hpp"
 #include "simple_thread_pool.hpp"
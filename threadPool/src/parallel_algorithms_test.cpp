@@ -0,0 +1,101 @@
+/**
+ * 测试基于线程池的并行算法，并与串行版本对比耗时
+ */
+
+#include <iostream>
+#include <vector>
+#include <numeric>
+#include <cmath>
+#include <chrono>
+#include <cassert>
+
+#include "futured_thread_pool.hpp"
+#include "multi_queue_thread_pool.hpp"
+#include "parallel_algorithms.hpp"
+
+/* 计算耗时，单位ms */
+template<typename Func>
+double time_cost(Func f) {
+    auto begin = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double, std::milli> cost = std::chrono::steady_clock::now() - begin;
+    return cost.count();
+}
+
+template<typename ThreadPoolType>
+void test_parallel_algorithms(ThreadPoolType& pool, const char* pool_name) {
+    size_t const count = 10000000;
+    std::vector<double> in(count);
+    std::iota(in.begin(), in.end(), 0.0);
+    std::vector<double> serial_out(count);
+    std::vector<double> parallel_out(count);
+
+    // parallel_for与parallel_transform
+    double serial_cost = time_cost([&]() {
+        std::transform(in.begin(), in.end(), serial_out.begin(), [](double x) { return std::sqrt(x) * std::sin(x); });
+    });
+    double parallel_cost = time_cost([&]() {
+        zhaocc::parallel_transform(pool, in.begin(), in.end(), parallel_out.begin(), 0,
+                                   [](double x) { return std::sqrt(x) * std::sin(x); });
+    });
+    assert(serial_out == parallel_out);
+    std::cout << "[" << pool_name << "] transform serial: " << serial_cost << "ms, parallel: " << parallel_cost
+              << "ms" << std::endl;
+
+    zhaocc::parallel_for(pool, size_t(0), count, 0, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            parallel_out[i] = in[i] * 2;
+        }
+    });
+    assert(parallel_out[count - 1] == in[count - 1] * 2);
+
+    // parallel_reduce
+    long long serial_sum = 0;
+    serial_cost = time_cost([&]() {
+        serial_sum = std::accumulate(in.begin(), in.end(), 0LL, [](long long s, double x) {
+            return s + static_cast<long long>(x);
+        });
+    });
+    long long parallel_sum = 0;
+    parallel_cost = time_cost([&]() {
+        parallel_sum = zhaocc::parallel_reduce(pool, in.begin(), in.end(), 0, 0LL,
+                                               [](std::vector<double>::iterator first, std::vector<double>::iterator last,
+                                                  long long s) {
+                                                   for (; first != last; ++first) {
+                                                       s += static_cast<long long>(*first);
+                                                   }
+                                                   return s;
+                                               }, std::plus<long long>());
+    });
+    assert(serial_sum == parallel_sum && serial_sum == (long long) count * (count - 1) / 2);
+    std::cout << "[" << pool_name << "] reduce serial: " << serial_cost << "ms, parallel: " << parallel_cost
+              << "ms" << std::endl;
+
+    // 只传combine的parallel_reduce
+    std::vector<int> small{3, 1, 4, 1, 5, 9, 2, 6};
+    assert(zhaocc::parallel_reduce(pool, small.begin(), small.end(), 2, 0,
+                                   [](int a, int b) { return std::max(a, b); }) == 9);
+
+    // parallel_scan
+    std::vector<long long> ints(count, 1);
+    std::vector<long long> serial_scan(count);
+    std::vector<long long> parallel_scan(count);
+    serial_cost = time_cost([&]() {
+        std::partial_sum(ints.begin(), ints.end(), serial_scan.begin());
+    });
+    parallel_cost = time_cost([&]() {
+        zhaocc::parallel_scan(pool, ints.begin(), ints.end(), parallel_scan.begin(), 0, 0LL,
+                              std::plus<long long>());
+    });
+    assert(serial_scan == parallel_scan && parallel_scan[count - 1] == (long long) count);
+    std::cout << "[" << pool_name << "] scan serial: " << serial_cost << "ms, parallel: " << parallel_cost
+              << "ms" << std::endl;
+}
+
+int main() {
+    zhaocc::MultiQueueThreadPool multi_queue_thread_pool;
+    test_parallel_algorithms(multi_queue_thread_pool, "MultiQueueThreadPool");
+
+    zhaocc::FuturedThreadPool futured_thread_pool;
+    test_parallel_algorithms(futured_thread_pool, "FuturedThreadPool");
+}
@@ -0,0 +1,108 @@
+/**
+ * 测试线程池的运行统计：直方图分桶、计数之间的关系，以及统计本身每个任务的开销
+ */
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <type_traits>
+#include <cassert>
+
+#include "pool_telemetry.hpp"
+#include "futured_thread_pool.hpp"
+#include "multi_queue_thread_pool.hpp"
+
+/* 分桶单调，桶的下界不超过落入该桶的值，相对误差不超过25% */
+void test_buckets() {
+    unsigned last = 0;
+    for (uint64_t v = 0; v < (uint64_t(1) << 40); v = v < 16 ? v + 1 : v + v / 7) {
+        unsigned const b = zhaocc::LatencyBuckets::bucket_of(v);
+        assert(b >= last && b < zhaocc::LatencyBuckets::kCount);
+        uint64_t const lower = zhaocc::LatencyBuckets::lower_bound(b);
+        assert(lower <= v && v - lower <= v / 4);
+        last = b;
+    }
+    assert(zhaocc::LatencyBuckets::bucket_of(UINT64_MAX) == zhaocc::LatencyBuckets::kCount - 1);
+}
+
+/* 递归提交子任务，产生本线程队列、主任务队列和窃取的计数 */
+template<typename ThreadPoolType>
+void test_counters(const char* name) {
+    ThreadPoolType pool(4);
+    std::atomic<int> leaves(0);
+    std::vector<std::future<void>> roots;
+    for (int r = 0; r < 100; r++) {
+        roots.emplace_back(pool.submit([&]() {
+            std::vector<std::future<void>> children;
+            for (int c = 0; c < 20; c++) {
+                children.emplace_back(pool.submit([&leaves]() { ++leaves; }));
+            }
+            for (auto& child : children) {
+                while (child.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                    pool.run_pending_task();
+                }
+            }
+        }));
+    }
+    for (auto& root : roots) {
+        root.get();
+    }
+    assert(leaves == 2000);
+
+    zhaocc::TelemetrySnapshot snap = pool.telemetry_snapshot();
+    while (snap.total.executed < 2100) { // 任务的计数在future就绪之后才累加
+        std::this_thread::yield();
+        snap = pool.telemetry_snapshot();
+    }
+    assert(snap.total.executed == 2100 && snap.queue_depth == 0);
+    if constexpr (std::is_same<ThreadPoolType, zhaocc::MultiQueueThreadPool>::value) {
+        assert(snap.total.local_pops + snap.total.main_pops + snap.total.stolen == snap.total.executed);
+    } else { // FuturedThreadPool按批从任务队列取出，所有任务都来自任务队列
+        assert(snap.total.main_pops == snap.total.executed);
+    }
+    std::cout << name << ": " << snap.to_string() << std::endl;
+    for (size_t i = 0; i < snap.workers.size(); i++) {
+        std::cout << "  " << (i + 1 == snap.workers.size() ? "external" : "worker-" + std::to_string(i))
+                  << " executed=" << snap.workers[i].executed << " stolen=" << snap.workers[i].stolen << std::endl;
+    }
+}
+
+/* 统计的开销：直接执行空任务与通过PoolTelemetry::run执行（含采样）每个任务的耗时之差 */
+void test_overhead() {
+    constexpr int kTasks = 10000000;
+    zhaocc::PoolTelemetry telemetry(1);
+    zhaocc::WorkerStats& stats = telemetry.worker(0);
+    long sink = 0;
+
+    std::vector<zhaocc::FunctionWrapper> tasks;
+    auto measure = [&](bool instrumented) {
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < kTasks; i++) {
+            zhaocc::FunctionWrapper task([&sink]() { ++sink; });
+            if (instrumented) {
+                zhaocc::PoolTelemetry::stamp(task);
+                zhaocc::PoolTelemetry::run(stats, task);
+            } else {
+                task();
+            }
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / kTasks;
+    };
+    measure(false); // 预热
+    double const plain = measure(false);
+    double const instrumented = measure(true);
+    std::cout << "per task: plain " << plain << "ns, instrumented " << instrumented << "ns, overhead "
+              << (instrumented - plain) << "ns (" << (instrumented - plain) / 10.0
+              << "% of the 1us budget at 1M tasks/s)" << std::endl;
+    assert(stats.executed.load() == kTasks);
+}
+
+int main() {
+    test_buckets();
+    test_counters<zhaocc::MultiQueueThreadPool>("multi queue");
+    test_counters<zhaocc::FuturedThreadPool>("futured");
+    test_overhead();
+}
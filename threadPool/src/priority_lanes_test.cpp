@@ -0,0 +1,201 @@
+/**
+ * 测试优先级队列的加权出队、REALTIME任务在大量BACKGROUND任务积压时的等待时间，以及任务截止时间
+ */
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <future>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <cassert>
+
+#include "priority_lanes.hpp"
+#include "futured_thread_pool.hpp"
+#include "multi_queue_thread_pool.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+/* 三个队列都有任务时按8:4:1出队，BACKGROUND不会被饿死 */
+void test_weighted_dequeue() {
+    zhaocc::PriorityLanes<int> lanes;
+    for (int i = 0; i < 100; i++) {
+        lanes.push(zhaocc::Priority::BACKGROUND, 2);
+        lanes.push(zhaocc::Priority::NORMAL, 1);
+        lanes.push(zhaocc::Priority::REALTIME, 0);
+    }
+    int counts[3] = {0, 0, 0};
+    int value;
+    for (int i = 0; i < 13; i++) { // 一轮
+        assert(lanes.try_pop(value));
+        counts[value]++;
+    }
+    std::cout << "one round: realtime " << counts[0] << ", normal " << counts[1] << ", background " << counts[2]
+              << std::endl;
+    assert(counts[0] == 8 && counts[1] == 4 && counts[2] == 1);
+
+    int popped = 13;
+    while (lanes.try_pop(value)) {
+        popped++;
+    }
+    assert(popped == 300);
+}
+
+/* 批量出队与逐个出队的顺序相同，每个任务都占用一次轮转；除第一个以外只批量取出NORMAL任务 */
+void test_bulk_dequeue_keeps_weights() {
+    zhaocc::PriorityLanes<int> single;
+    zhaocc::PriorityLanes<int> bulk;
+    for (int i = 0; i < 100; i++) {
+        for (auto* lanes : {&single, &bulk}) {
+            lanes->push(zhaocc::Priority::BACKGROUND, 2);
+            lanes->push(zhaocc::Priority::NORMAL, 1);
+        }
+    }
+    std::vector<int> expected;
+    int value;
+    while (single.try_pop(value)) {
+        expected.push_back(value);
+    }
+    std::vector<int> popped;
+    for (size_t n; (n = bulk.try_pop_bulk(std::back_inserter(popped), 4)) > 0;) {
+        for (size_t i = popped.size() - n + 1; i < popped.size(); i++) {
+            assert(popped[i] == 1);
+        }
+    }
+    assert(popped == expected);
+}
+
+/* 唯一的工作线程上批量取出的BACKGROUND任务不会插到积压的NORMAL任务前面 */
+void test_pool_batch_order() {
+    zhaocc::MultiQueueThreadPool pool(1);
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::promise<void> started;
+    pool.post([&started, released]() {
+        started.set_value();
+        released.wait();
+    });
+    started.get_future().wait(); // 之后提交的任务都积压在主任务队列中
+
+    std::mutex m;
+    std::vector<zhaocc::Priority> order;
+    std::vector<std::future<void>> futures;
+    auto record = [&m, &order](zhaocc::Priority priority) {
+        return [&m, &order, priority]() {
+            std::lock_guard<std::mutex> lock(m);
+            order.push_back(priority);
+        };
+    };
+    for (int i = 0; i < 4; i++) {
+        futures.emplace_back(pool.submit(zhaocc::Priority::BACKGROUND, record(zhaocc::Priority::BACKGROUND)));
+    }
+    for (int i = 0; i < 24; i++) {
+        futures.emplace_back(pool.submit(zhaocc::Priority::NORMAL, record(zhaocc::Priority::NORMAL)));
+    }
+    release.set_value();
+    for (auto& future : futures) {
+        future.get();
+    }
+    // REALTIME为空时一轮13次中只有一次首选BACKGROUND
+    assert(std::count(order.begin(), order.begin() + 13, zhaocc::Priority::BACKGROUND) == 1);
+}
+
+/* 工作线程不断产生本线程队列的任务时，主任务队列中的BACKGROUND任务仍然能执行 */
+void test_local_work_does_not_starve_background() {
+    zhaocc::MultiQueueThreadPool pool(1);
+    std::atomic<bool> background_ran{false};
+    std::atomic<int> steps{0};
+    std::promise<void> chain_done;
+    std::function<void()> step = [&]() {
+        if (background_ran || ++steps >= 100000) {
+            chain_done.set_value();
+            return;
+        }
+        pool.post(step); // 在工作线程上提交，进入本线程队列
+    };
+    pool.post(step);
+    while (steps < 100) {
+        std::this_thread::yield();
+    }
+    int const submitted_at = steps;
+    pool.submit(zhaocc::Priority::BACKGROUND, [&background_ran]() { background_ran = true; });
+    chain_done.get_future().wait();
+    std::cout << "background ran after " << steps - submitted_at << " local tasks" << std::endl;
+    assert(background_ran && steps < 100000);
+    pool.wait_idle();
+}
+
+/* 积压background_count个BACKGROUND任务后提交REALTIME（或NORMAL）任务，返回这些任务从提交到开始执行的最大等待时间 */
+double max_wait_behind_backlog(zhaocc::Priority priority, int background_count) {
+    zhaocc::FuturedThreadPool pool(2);
+    auto work = []() {
+        volatile double x = 0;
+        for (int i = 0; i < 20000; i++) {
+            x = x + i * 0.5;
+        }
+    };
+    std::vector<std::future<void>> background;
+    for (int i = 0; i < background_count; i++) {
+        background.emplace_back(pool.submit(zhaocc::Priority::BACKGROUND, work));
+    }
+
+    std::vector<std::future<double>> waits;
+    for (int i = 0; i < 20; i++) {
+        Clock::time_point const submitted = Clock::now();
+        waits.emplace_back(pool.submit(priority, [submitted]() {
+            return std::chrono::duration<double, std::milli>(Clock::now() - submitted).count();
+        }));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    double max_wait = 0;
+    for (auto& wait : waits) {
+        max_wait = std::max(max_wait, wait.get());
+    }
+    for (auto& future : background) {
+        future.get();
+    }
+    return max_wait;
+}
+
+/* 开始执行时已经超过截止时间的任务不执行，future中得到DeadlineMissed */
+template<typename ThreadPoolType>
+void test_deadline(const char* name) {
+    ThreadPoolType pool(1);
+    std::promise<void> started;
+    std::future<void> blocker = pool.submit([&started]() {
+        started.set_value();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    });
+    started.get_future().wait(); // 唯一的工作线程被占用后再提交
+    bool ran = false;
+    std::future<void> late = pool.submit(zhaocc::Priority::REALTIME, Clock::now() + std::chrono::milliseconds(10),
+                                         [&ran]() { ran = true; });
+    std::future<int> in_time = pool.submit(zhaocc::Priority::NORMAL, Clock::now() + std::chrono::seconds(10),
+                                           []() { return 42; });
+    blocker.get();
+    bool thrown = false;
+    try {
+        late.get();
+    } catch (const zhaocc::DeadlineMissed& e) {
+        thrown = true;
+    }
+    assert(thrown && !ran);
+    assert(in_time.get() == 42);
+    assert(pool.missed_deadlines() == 1);
+    std::cout << name << " deadline: missed " << pool.missed_deadlines() << std::endl;
+}
+
+int main() {
+    test_weighted_dequeue();
+    test_bulk_dequeue_keeps_weights();
+    test_pool_batch_order();
+    test_local_work_does_not_starve_background();
+    std::cout << "max wait behind 2000 background tasks, realtime: "
+              << max_wait_behind_backlog(zhaocc::Priority::REALTIME, 2000) << "ms, background: "
+              << max_wait_behind_backlog(zhaocc::Priority::BACKGROUND, 2000) << "ms" << std::endl;
+    test_deadline<zhaocc::FuturedThreadPool>("futured");
+    test_deadline<zhaocc::MultiQueueThreadPool>("multi queue");
+}
@@ -0,0 +1,152 @@
+/**
+ * 测试线程池的三种关闭方式、协作式取消以及wait_idle
+ */
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <future>
+#include <cassert>
+
+#include "cancellation.hpp"
+#include "futured_thread_pool.hpp"
+#include "multi_queue_thread_pool.hpp"
+
+/* DRAIN：关闭前执行完所有任务，包括执行期间提交的子任务 */
+template<typename ThreadPoolType>
+void test_drain(const char* name) {
+    std::atomic<int> count(0);
+    {
+        ThreadPoolType pool(2);
+        for (int i = 0; i < 100; i++) {
+            pool.post([&pool, &count]() {
+                for (int c = 0; c < 10; c++) {
+                    pool.post([&count]() { ++count; });
+                }
+                ++count;
+            });
+        }
+        pool.shutdown(zhaocc::ShutdownMode::DRAIN);
+        assert(count == 1100);
+    }
+    std::cout << name << " drain: " << count << " tasks" << std::endl;
+}
+
+/* CANCEL_PENDING：正在执行的任务通过token提前结束，尚未开始的任务在future中得到OperationCancelled */
+template<typename ThreadPoolType>
+void test_cancel_pending(const char* name) {
+    ThreadPoolType pool(1);
+    zhaocc::CancellationToken token = pool.cancellation_token();
+    std::promise<void> started;
+    std::future<int> long_task = pool.submit([token, &started]() {
+        started.set_value();
+        int rounds = 0;
+        for (;; rounds++) { // 模拟长时间运行的任务，定期检查token
+            token.throw_if_cancelled();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return rounds;
+    });
+    started.get_future().wait();
+    std::vector<std::future<void>> pending;
+    for (int i = 0; i < 100; i++) {
+        pending.emplace_back(pool.submit([]() { std::this_thread::sleep_for(std::chrono::milliseconds(10)); }));
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    pool.shutdown(zhaocc::ShutdownMode::CANCEL_PENDING);
+    std::chrono::duration<double, std::milli> cost = std::chrono::steady_clock::now() - begin;
+
+    int cancelled = 0;
+    try {
+        long_task.get();
+    } catch (const zhaocc::OperationCancelled&) {
+        cancelled++;
+    }
+    for (auto& future : pending) {
+        try {
+            future.get();
+        } catch (const zhaocc::OperationCancelled&) {
+            cancelled++;
+        }
+    }
+    assert(cancelled == 101);
+    assert(cost.count() < 500); // 100个10ms的任务没有执行
+    std::cout << name << " cancel pending: " << cancelled << " cancelled, shutdown took " << cost.count() << "ms"
+              << std::endl;
+}
+
+/* ABANDON：正在执行的任务结束后立即关闭，尚未开始的任务的future为broken_promise */
+template<typename ThreadPoolType>
+void test_abandon(const char* name) {
+    std::vector<std::future<void>> pending;
+    {
+        ThreadPoolType pool(1);
+        std::promise<void> started;
+        std::future<void> running = pool.submit([&started]() {
+            started.set_value();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        });
+        started.get_future().wait();
+        for (int i = 0; i < 10; i++) {
+            pending.emplace_back(pool.submit([]() {}));
+        }
+        pool.shutdown(zhaocc::ShutdownMode::ABANDON);
+        running.get(); // 正在执行的任务正常结束
+    }
+    int broken = 0;
+    for (auto& future : pending) {
+        try {
+            future.get();
+        } catch (const std::future_error& e) {
+            assert(e.code() == std::future_errc::broken_promise);
+            broken++;
+        }
+    }
+    assert(broken == 10);
+    std::cout << name << " abandon: " << broken << " broken promises" << std::endl;
+}
+
+/* wait_idle作为两个批处理阶段之间的屏障：第二阶段能看到第一阶段所有任务的结果 */
+template<typename ThreadPoolType>
+void test_wait_idle(const char* name) {
+    ThreadPoolType pool(2);
+    std::vector<int> data(10000, 0);
+    for (int phase = 1; phase <= 3; phase++) {
+        for (size_t i = 0; i < data.size(); i += 100) {
+            pool.post([&data, i, phase]() {
+                for (size_t j = i; j < i + 100; j++) {
+                    assert(data[j] == phase - 1);
+                    data[j] = phase;
+                }
+            });
+        }
+        pool.wait_idle();
+        for (int v : data) {
+            assert(v == phase);
+        }
+    }
+
+    constexpr int kCalls = 100000;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < kCalls; i++) {
+        pool.wait_idle();
+    }
+    std::chrono::duration<double, std::nano> cost = std::chrono::steady_clock::now() - begin;
+    std::cout << name << " wait_idle on an idle pool: " << cost.count() / kCalls << "ns" << std::endl;
+}
+
+template<typename ThreadPoolType>
+void test_all(const char* name) {
+    test_drain<ThreadPoolType>(name);
+    test_cancel_pending<ThreadPoolType>(name);
+    test_abandon<ThreadPoolType>(name);
+    test_wait_idle<ThreadPoolType>(name);
+}
+
+int main() {
+    test_all<zhaocc::FuturedThreadPool>("futured");
+    test_all<zhaocc::MultiQueueThreadPool>("multi queue");
+}
@@ -0,0 +1,157 @@
+/**
+ * Strand/StrandGroup测试：同一个key的任务按提交顺序且不并发执行，不同strand可以同时执行，
+ * 以及与"每个会话一把互斥锁，在工作线程中持锁执行"的做法对比吞吐。
+ */
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <future>
+#include <chrono>
+#include <atomic>
+#include <stdexcept>
+#include <cassert>
+
+#include "multi_queue_thread_pool.hpp"
+#include "strand.hpp"
+
+using Pool = zhaocc::MultiQueueThreadPool;
+
+/* 会话状态，非线程安全 */
+struct Session {
+    std::atomic<int> in_flight{0}; // 正在执行的任务数，用来发现并发执行
+    std::vector<int> last_seq; // 每个生产者最后一个任务的序号
+    long long handled = 0;
+    bool ok = true;
+};
+
+void test_per_key_order() {
+    constexpr int kSessions = 100;
+    constexpr int kProducers = 4;
+    constexpr int kPerProducer = 200;
+    Pool pool(4);
+    zhaocc::StrandGroup<Pool, int> group(pool, 16);
+    std::vector<std::unique_ptr<Session>> sessions;
+    for (int i = 0; i < kSessions; i++) {
+        sessions.push_back(std::make_unique<Session>());
+        sessions.back()->last_seq.assign(kProducers, -1);
+    }
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; p++) {
+        producers.emplace_back([&, p]() {
+            for (int seq = 0; seq < kPerProducer; seq++) {
+                for (int key = 0; key < kSessions; key++) {
+                    Session& s = *sessions[key];
+                    group.post(key, [&s, &group, key, p, seq]() {
+                        bool const alone = s.in_flight.fetch_add(1) == 0;
+                        s.ok = s.ok && alone && s.last_seq[p] == seq - 1 && group.strand_for(key).running_in_this_thread();
+                        s.last_seq[p] = seq;
+                        s.handled++;
+                        s.in_flight.fetch_sub(1);
+                    });
+                }
+            }
+        });
+    }
+    for (auto& t : producers) {
+        t.join();
+    }
+    for (int key = 0; key < kSessions; key++) { // submit排在该key已提交的任务之后
+        long long const handled = group.submit(key, [&sessions, key]() { return sessions[key]->handled; }).get();
+        assert(handled == kProducers * kPerProducer);
+        assert(sessions[key]->ok);
+    }
+}
+
+/* 两个strand的任务互相等待：只有不同strand真正并行时才能完成 */
+void test_strands_run_in_parallel() {
+    Pool pool(2);
+    zhaocc::Strand<Pool> a(pool);
+    zhaocc::Strand<Pool> b(pool);
+    std::promise<void> a_started;
+    std::promise<void> b_started;
+    std::shared_future<void> a_ready = a_started.get_future().share();
+    std::shared_future<void> b_ready = b_started.get_future().share();
+    std::future<void> fa = a.submit([&a_started, b_ready]() {
+        a_started.set_value();
+        b_ready.wait();
+    });
+    std::future<void> fb = b.submit([&b_started, a_ready]() {
+        b_started.set_value();
+        a_ready.wait();
+    });
+    fa.get();
+    fb.get();
+}
+
+void test_submit_and_lifetime() {
+    Pool pool(2);
+    std::atomic<int> ran(0);
+    std::future<int> answer;
+    {
+        zhaocc::Strand<Pool> strand(pool);
+        for (int i = 0; i < 1000; i++) {
+            strand.post([&ran]() { ran++; });
+        }
+        answer = strand.submit([]() { return 42; });
+        std::future<void> error = strand.submit([]() { throw std::runtime_error("session error"); });
+        bool caught = false;
+        try {
+            error.get();
+        } catch (const std::runtime_error&) {
+            caught = true;
+        }
+        assert(caught);
+        assert(!strand.running_in_this_thread());
+    } // strand析构后已提交的任务仍然执行
+    assert(answer.get() == 42 && ran == 1000);
+}
+
+/* kBenchSessions个会话，每个任务给会话计数加一，分别用会话互斥锁和strand保证串行，返回每秒任务数 */
+constexpr int kBenchSessions = 8;
+constexpr int kBenchTasks = 100000;
+
+double bench_session_mutex() {
+    Pool pool(4);
+    std::vector<std::mutex> mutexes(kBenchSessions);
+    std::vector<long long> counters(kBenchSessions, 0);
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < kBenchTasks; i++) {
+        int const key = i % kBenchSessions;
+        pool.post([&mutexes, &counters, key]() {
+            std::lock_guard<std::mutex> lock(mutexes[key]); // 同一会话的任务在工作线程上阻塞
+            counters[key]++;
+        });
+    }
+    pool.wait_idle();
+    std::chrono::duration<double> cost = std::chrono::steady_clock::now() - begin;
+    return kBenchTasks / cost.count();
+}
+
+double bench_strand() {
+    Pool pool(4);
+    zhaocc::StrandGroup<Pool, int> group(pool, kBenchSessions);
+    std::vector<long long> counters(kBenchSessions, 0);
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < kBenchTasks; i++) {
+        int const key = i % kBenchSessions;
+        group.post(key, [&counters, key]() { counters[key]++; });
+    }
+    for (int key = 0; key < kBenchSessions; key++) {
+        group.submit(key, []() {}).get();
+        assert(counters[key] == kBenchTasks / kBenchSessions);
+    }
+    std::chrono::duration<double> cost = std::chrono::steady_clock::now() - begin;
+    return kBenchTasks / cost.count();
+}
+
+int main() {
+    test_per_key_order();
+    test_strands_run_in_parallel();
+    test_submit_and_lifetime();
+    double const mutex_rate = bench_session_mutex();
+    double const strand_rate = bench_strand();
+    std::cout << "session mutex: " << mutex_rate << " tasks/s, strand: " << strand_rate << " tasks/s" << std::endl;
+}
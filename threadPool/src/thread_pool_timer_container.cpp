@@ -6,9 +6,20 @@
 
 #include <iostream>
 #include <memory>
+#include <sstream>
 
 #include "thread_pool_timer_container.h"
 
+namespace {
+// Printing boost::thread::id saves and changes the stream's format flags, so build the line in a local stream and
+// write it to std::cout once. Otherwise worker threads starting or finishing together race on std::cout's flags.
+void LogWorkerThread(const char* event) {
+  std::ostringstream line;
+  line << "Worker thread-[" << boost::this_thread::get_id() << "] " << event << "\n";
+  std::cout << line.str() << std::endl;
+}
+} // namespace
+
 common::ThreadPoolTimerContainer::ThreadPoolTimerContainer(int worker_th_count) : state_(STOPPED),
                                                                                   worker_th_count_(worker_th_count),
                                                                                   io_work_(io_service_) {
@@ -23,9 +34,9 @@ bool common::ThreadPoolTimerContainer::Start() {
 
   for (int i = 0; i < worker_th_count_; i++) {
     thread_group_.create_thread([this]() {
-      std::cout << "Worker thread-[" << boost::this_thread::get_id() << "] Start\n" << std::endl;
+      LogWorkerThread("Start");
       this->io_service_.run();
-      std::cout << "Worker thread-[" << boost::this_thread::get_id() << "] Finish\n" << std::endl;
+      LogWorkerThread("Finish");
     });
   }
 
@@ -139,4 +150,12 @@ bool common::ThreadPoolTimerContainer::Stop() {
 
 common::ThreadPoolTimerContainer::~ThreadPoolTimerContainer() {
   Stop();
+
+  // Timers may have been added from other threads, so take them out under timers_mutex_ before destroying them.
+  // Callbacks that never ran, such as a sleeping coroutine's resumption, are then destroyed outside the lock.
+  std::unordered_map<int64_t, std::unique_ptr<TimerItem>> pending;
+  {
+    std::lock_guard<std::mutex> timers_lock(timers_mutex_);
+    pending.swap(timers_);
+  }
 }